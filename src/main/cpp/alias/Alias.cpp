@@ -21,6 +21,13 @@ void NormalizeProbabilities(std::vector<double>& probabilities)
 }
 
 Alias Alias::CreateDistribution(std::vector<double> probabilities, util::Random& rng)
+{
+	Alias result = CreateDistribution(std::move(probabilities));
+	result.m_random = &rng;
+	return result;
+}
+
+Alias Alias::CreateDistribution(std::vector<double> probabilities)
 {
 	assert(probabilities.size() > 0);
 	if (probabilities.size() <= 0) {
@@ -65,13 +72,13 @@ Alias Alias::CreateDistribution(std::vector<double> probabilities, util::Random&
 	for (auto l : small) {
 		prob[l] = 1;
 	}
-	return Alias(std::move(alias), std::move(prob), rng);
+	return Alias(std::move(alias), std::move(prob), nullptr);
 }
 
-std::size_t Alias::Next()
+std::size_t Alias::Next(util::Random& rng) const
 {
-	std::size_t roll = (*m_random)(m_alias.size());
-	double flip = m_random->NextDouble();
+	std::size_t roll = rng(m_alias.size());
+	double flip = rng.NextDouble();
 	if (flip <= m_prob[roll]) {
 		return roll;
 	} else {
@@ -30,13 +30,19 @@ public:
 	/// Creates an Alias object.
 	static Alias CreateDistribution(std::vector<double> probabilities, util::Random& rng);
 
+	/// Creates an Alias object that isn't bound to a random number generator. Only Next(rng) may be used on it.
+	static Alias CreateDistribution(std::vector<double> probabilities);
+
 	/// Generates a new number.
-	std::size_t Next();
+	std::size_t Next() { return Next(*m_random); }
+
+	/// Generates a new number, drawing from the given random number generator.
+	std::size_t Next(util::Random& rng) const;
 
 private:
 	/// Constructor
-	Alias(std::vector<std::size_t>&& alias, std::vector<double>&& prob, util::Random& rng)
-	    : m_random(&rng), m_alias(std::move(alias)), m_prob(std::move(prob))
+	Alias(std::vector<std::size_t>&& alias, std::vector<double>&& prob, util::Random* rng)
+	    : m_random(rng), m_alias(std::move(alias)), m_prob(std::move(prob))
 	{
 	}
 
@@ -81,6 +87,9 @@ public:
 	/// Generates a new value.
 	T Next() { return value_map[inner_alias.Next()]; }
 
+	/// Generates a new value, drawing from the given random number generator.
+	T Next(util::Random& rng) const { return value_map[inner_alias.Next(rng)]; }
+
 private:
 	BiasedRandomValueGenerator(Alias&& inner_alias, std::vector<T>&& value_map)
 	    : inner_alias(std::move(inner_alias)), value_map(std::move(value_map))
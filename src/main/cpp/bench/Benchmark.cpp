@@ -0,0 +1,224 @@
+#include "Benchmark.h"
+
+#include "util/Errors.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace stride {
+namespace bench {
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+namespace {
+
+/// Writes a string as a JSON string.
+void WriteString(const std::string& value, std::ostream& out)
+{
+	out << '"';
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			out << ' ';
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+/// Formats a number of ops per second with a metric prefix.
+string FormatThroughput(double ops_per_second)
+{
+	const char* prefixes[] = {"", "k", "M", "G"};
+	size_t prefix = 0;
+	while (ops_per_second >= 1000.0 && prefix < 3) {
+		ops_per_second /= 1000.0;
+		prefix++;
+	}
+	ostringstream text;
+	text << fixed << setprecision(2) << ops_per_second << ' ' << prefixes[prefix];
+	return text.str();
+}
+
+} // end_of_namespace
+
+void Benchmark::Add(const std::string& name, std::size_t ops_per_run, const std::string& unit, const Factory& factory)
+{
+	m_entries.push_back({name, max<size_t>(ops_per_run, 1U), unit, factory});
+}
+
+std::vector<std::string> Benchmark::GetNames() const
+{
+	vector<string> names;
+	for (const auto& entry : m_entries) {
+		names.push_back(entry.name);
+	}
+	return names;
+}
+
+std::vector<Result> Benchmark::Run(const Options& options, const std::string& filter, std::ostream& progress) const
+{
+	vector<Result> results;
+	for (const auto& entry : m_entries) {
+		if (entry.name.find(filter) == string::npos) {
+			continue;
+		}
+		auto bench_case = entry.factory();
+		const auto time_run = [&bench_case]() {
+			if (bench_case.reset) {
+				bench_case.reset();
+			}
+			const auto start = Clock::now();
+			bench_case.run();
+			return chrono::duration<double>(Clock::now() - start).count();
+		};
+
+		// Warm up, and find the number of runs that make a repetition last long enough.
+		double warmup_time = 0.0;
+		size_t warmup_runs = 0;
+		while (warmup_runs == 0 || warmup_time < options.warmup_seconds) {
+			warmup_time += time_run();
+			warmup_runs++;
+		}
+		const double run_time = warmup_time / warmup_runs;
+		const auto runs = max<size_t>(1U, static_cast<size_t>(ceil(options.min_repetition_seconds / run_time)));
+
+		vector<double> samples;
+		for (size_t repetition = 0; repetition < max<size_t>(options.repetitions, 1U); repetition++) {
+			double time = 0.0;
+			for (size_t run = 0; run < runs; run++) {
+				time += time_run();
+			}
+			samples.push_back(time * 1e9 / (runs * entry.ops_per_run));
+		}
+
+		auto result = Summarize(samples);
+		result.name = entry.name;
+		result.unit = entry.unit;
+		result.ops_per_run = entry.ops_per_run;
+		result.runs_per_repetition = runs;
+		const auto flags = progress.flags();
+		const double deviation = result.mean_ns > 0.0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0;
+		progress << left << setw(56) << result.name << right << fixed << setprecision(2) << setw(14)
+			 << result.median_ns << " ns/op  +/-" << setw(6) << setprecision(1) << deviation << "%  "
+			 << setw(10) << FormatThroughput(result.GetThroughput()) << result.unit << "/s" << endl;
+		progress.flags(flags);
+		results.push_back(result);
+	}
+	return results;
+}
+
+Result Benchmark::Summarize(std::vector<double> samples)
+{
+	Result result;
+	result.repetitions = samples.size();
+	if (samples.empty()) {
+		return result;
+	}
+	sort(samples.begin(), samples.end());
+	const auto n = samples.size();
+	result.min_ns = samples.front();
+	result.median_ns = n % 2 == 1 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+	double sum = 0.0;
+	for (double sample : samples) {
+		sum += sample;
+	}
+	result.mean_ns = sum / n;
+	double squares = 0.0;
+	for (double sample : samples) {
+		squares += (sample - result.mean_ns) * (sample - result.mean_ns);
+	}
+	result.stddev_ns = n > 1 ? sqrt(squares / (n - 1)) : 0.0;
+	return result;
+}
+
+void Benchmark::WriteJson(
+    const std::vector<Result>& results, const std::map<std::string, std::string>& context, std::ostream& out)
+{
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+	out << "{\n  \"context\": {";
+	bool first = true;
+	for (const auto& item : context) {
+		out << (first ? "\n    " : ",\n    ");
+		WriteString(item.first, out);
+		out << ": ";
+		WriteString(item.second, out);
+		first = false;
+	}
+	out << "\n  },\n  \"benchmarks\": [";
+	first = true;
+	out << setprecision(4) << fixed;
+	for (const auto& result : results) {
+		out << (first ? "\n    {" : ",\n    {") << "\"name\": ";
+		WriteString(result.name, out);
+		out << ", \"unit\": ";
+		WriteString(result.unit, out);
+		out << ", \"ops_per_run\": " << result.ops_per_run << ", \"runs_per_repetition\": "
+		    << result.runs_per_repetition << ", \"repetitions\": " << result.repetitions
+		    << ", \"ns_per_op\": {\"min\": " << result.min_ns << ", \"median\": " << result.median_ns
+		    << ", \"mean\": " << result.mean_ns << ", \"stddev\": " << result.stddev_ns
+		    << "}, \"ops_per_second\": " << result.GetThroughput() << "}";
+		first = false;
+	}
+	out << "\n  ]\n}\n";
+	out.flags(flags);
+	out.precision(precision);
+}
+
+std::map<std::string, double> Benchmark::ReadBaseline(const std::string& file_name)
+{
+	ifstream in(file_name);
+	if (!in) {
+		FATAL_ERROR("Can't open baseline " + file_name + ".");
+	}
+	boost::property_tree::ptree pt;
+	boost::property_tree::read_json(in, pt);
+	map<string, double> baseline;
+	for (const auto& benchmark : pt.get_child("benchmarks")) {
+		baseline[benchmark.second.get<string>("name")] = benchmark.second.get<double>("ns_per_op.median");
+	}
+	return baseline;
+}
+
+std::size_t Benchmark::Compare(
+    const std::vector<Result>& results, const std::map<std::string, double>& baseline, double tolerance,
+    std::ostream& out)
+{
+	const auto flags = out.flags();
+	size_t slower = 0;
+	out << left << setw(56) << "benchmark" << right << setw(14) << "baseline" << setw(14) << "now" << setw(10)
+	    << "change" << endl;
+	for (const auto& result : results) {
+		out << left << setw(56) << result.name << right << fixed << setprecision(2);
+		const auto base = baseline.find(result.name);
+		if (base == baseline.end() || base->second <= 0.0) {
+			out << setw(14) << "-" << setw(14) << result.median_ns << setw(10) << "new" << endl;
+			continue;
+		}
+		const double change = (result.median_ns - base->second) / base->second;
+		out << setw(14) << base->second << setw(14) << result.median_ns << setw(9) << setprecision(1) << showpos
+		    << 100.0 * change << '%' << noshowpos;
+		if (change > tolerance) {
+			out << "  slower";
+			slower++;
+		} else if (change < -tolerance) {
+			out << "  faster";
+		}
+		out << endl;
+	}
+	out.flags(flags);
+	return slower;
+}
+
+} // end_of_namespace
+} // end_of_namespace
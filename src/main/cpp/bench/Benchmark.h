@@ -0,0 +1,107 @@
+#ifndef BENCH_BENCHMARK_H_INCLUDED
+#define BENCH_BENCHMARK_H_INCLUDED
+
+/**
+ * @file
+ * A small harness for microbenchmarks: registered cases, warmup, repetitions and JSON output.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace stride {
+namespace bench {
+
+/**
+ * A benchmark case, as built by its factory: the code that is timed, and the code that puts the state back
+ * before every run, so that every run does the same work. Resetting isn't timed.
+ */
+struct Case
+{
+	std::function<void()> run;
+	std::function<void()> reset;
+};
+
+/**
+ * The statistics of a benchmark, over its repetitions.
+ */
+struct Result
+{
+	std::string name;
+	std::string unit;
+	std::size_t ops_per_run = 0;
+	std::size_t runs_per_repetition = 0;
+	std::size_t repetitions = 0;
+	double min_ns = 0.0;
+	double median_ns = 0.0;
+	double mean_ns = 0.0;
+	double stddev_ns = 0.0;
+
+	/// The number of ops per second, at the median time per op.
+	double GetThroughput() const { return median_ns > 0.0 ? 1e9 / median_ns : 0.0; }
+};
+
+/**
+ * Runs the registered benchmarks. Every benchmark is warmed up for a while, which also determines how many runs
+ * a repetition takes to last at least the minimum time; then its repetitions are timed. The time of a
+ * repetition is divided by its number of ops, which gives one sample of the time per op.
+ */
+class Benchmark
+{
+public:
+	/// The settings of the runs.
+	struct Options
+	{
+		std::size_t repetitions = 10;
+		double warmup_seconds = 0.1;
+		double min_repetition_seconds = 0.05;
+	};
+
+	/// A function that builds the state of a case. It's only called when the case is run.
+	using Factory = std::function<Case()>;
+
+	/// Registers a benchmark. A run does `ops_per_run` ops of the given unit (e.g. "person").
+	void Add(const std::string& name, std::size_t ops_per_run, const std::string& unit, const Factory& factory);
+
+	/// The names of the registered benchmarks, in the order in which they were added.
+	std::vector<std::string> GetNames() const;
+
+	/// Runs the benchmarks whose name contains the filter, and prints a line per benchmark as it finishes.
+	std::vector<Result> Run(const Options& options, const std::string& filter, std::ostream& progress) const;
+
+	/// Computes the statistics of the given samples of the time per op.
+	static Result Summarize(std::vector<double> samples);
+
+	/// Writes the results in JSON format, with the context in which they were measured.
+	static void WriteJson(
+	    const std::vector<Result>& results, const std::map<std::string, std::string>& context, std::ostream& out);
+
+	/// Reads the median time per op of every benchmark in a file that was written by WriteJson.
+	static std::map<std::string, double> ReadBaseline(const std::string& file_name);
+
+	/// Prints the change of the median time per op against the baseline. Returns the number of benchmarks
+	/// that got slower by more than the given tolerance (a fraction of the baseline).
+	static std::size_t Compare(
+	    const std::vector<Result>& results, const std::map<std::string, double>& baseline, double tolerance,
+	    std::ostream& out);
+
+private:
+	struct Entry
+	{
+		std::string name;
+		std::size_t ops_per_run;
+		std::string unit;
+		Factory factory;
+	};
+
+	std::vector<Entry> m_entries;
+};
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end-of-include-guard
@@ -0,0 +1,519 @@
+/**
+ * @file
+ * Microbenchmarks of the simulator's hot kernels.
+ */
+
+#include "bench/Benchmark.h"
+#include "alias/Alias.h"
+#include "calendar/Calendar.h"
+#include "core/Cluster.h"
+#include "core/ContactProfile.h"
+#include "core/Disease.h"
+#include "core/DiseaseProfile.h"
+#include "core/Infector.h"
+#include "core/RngHandler.h"
+#include "core/TransmissionKernel.h"
+#include "geo/GeoGrid.h"
+#include "pop/Generator.h"
+#include "pop/Population.h"
+#include "sim/SimulationConfig.h"
+#include "sim/Simulator.h"
+#include "sim/SimulatorBuilder.h"
+#include "util/InstallDirs.h"
+#include "util/Parallel.h"
+#include "util/ParallelMap.h"
+#include "util/Random.h"
+#include "util/TimeStamp.h"
+
+#if USE_HDF5
+#include "checkpoint/CheckPoint.h"
+#endif
+
+#include <boost/property_tree/ptree.hpp>
+#include <spdlog/spdlog.h>
+#include <tclap/CmdLine.h>
+
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace stride;
+using namespace stride::bench;
+using namespace stride::util;
+using namespace TCLAP;
+using boost::property_tree::ptree;
+
+namespace {
+
+/// Keeps the results of the benchmarks alive, so that the compiler doesn't optimize the work away.
+volatile std::size_t g_sink = 0;
+
+/// The clusters of the Infector benchmarks have this many members in total, whatever their size.
+const std::size_t g_cluster_members = 65536U;
+
+/// A fate that keeps the infected persons infectious during the benchmarks.
+const disease::Fate g_fate{0U, 0U, 1000U, 1000U};
+
+/// What the benchmarks share: the configuration, the disease and the calendar.
+struct Environment
+{
+	SingleSimulationConfig config;
+	DiseaseProfile disease_profile;
+	CalendarRef calendar;
+	std::shared_ptr<spdlog::logger> log;
+	unsigned int num_threads;
+};
+
+/// Persons with random ages; consecutive persons share their clusters, of the given size, of every type.
+vector<Person> MakePersons(std::size_t count, std::size_t cluster_size, Random& rng)
+{
+	vector<Person> persons;
+	persons.reserve(count);
+	for (std::size_t i = 0; i < count; i++) {
+		const auto cluster_id = static_cast<unsigned int>(i / cluster_size + 1);
+		persons.emplace_back(
+		    static_cast<PersonId>(i + 1), rng(0, 80), static_cast<unsigned int>(i / 4 + 1), cluster_id,
+		    cluster_id, cluster_id, cluster_id, g_fate);
+	}
+	return persons;
+}
+
+/**
+ * Clusters and the health of their members, which are put back before every run, so that every run sorts the
+ * same members and infects the same contacts.
+ */
+struct ClusterState
+{
+	ClusterState(std::size_t cluster_size, unsigned int seed)
+	    : rng(seed), contact_handler(seed, 1U, 0U), seed(seed)
+	{
+		persons = MakePersons(g_cluster_members, cluster_size, rng);
+		for (std::size_t i = 0; i < persons.size(); i++) {
+			if (i % cluster_size == 0) {
+				initial.emplace_back(initial.size() + 1, ClusterType::Work);
+				initial.back().Reserve(cluster_size);
+			}
+			initial.back().AddPerson(persons[i]);
+		}
+	}
+
+	/// Remembers the health of the persons, as it is put back before every run.
+	void Save()
+	{
+		health.clear();
+		for (const auto& p : persons) {
+			health.push_back(p.GetHealth());
+		}
+	}
+
+	/// Puts back the health of the persons, the order of the members and the random numbers.
+	void Restore()
+	{
+		for (std::size_t i = 0; i < persons.size(); i++) {
+			persons[i].GetHealth() = health[i];
+		}
+		vector<Cluster> copy(initial);
+		clusters.swap(copy);
+		contact_handler = RngHandler(seed, 1U, 0U);
+	}
+
+	/// Runs the Infector on the clusters.
+	void Execute(const Environment& env)
+	{
+		for (auto& cluster : clusters) {
+			Infector<LogMode::None, false, NoLocalInformation>::Execute(
+			    cluster, env.disease_profile, contact_handler, env.calendar, env.log, nullptr, nullptr,
+			    town_infections);
+		}
+	}
+
+	Random rng;
+	RngHandler contact_handler;
+	unsigned int seed;
+	vector<Person> persons;
+	vector<Health> health;
+	vector<Cluster> initial;
+	vector<Cluster> clusters;
+	TownInfectionCounter::Delta town_infections;
+};
+
+/// Infector::Execute on clusters of a size, with a fraction of infectious members (at least one per cluster).
+void AddInfector(Benchmark& benchmark, const Environment& env, std::size_t size, double prevalence)
+{
+	const auto name =
+	    "Infector::Execute/size:" + to_string(size) + "/prevalence:" + to_string(prevalence).substr(0, 4);
+	benchmark.Add(name, g_cluster_members, "person", [&env, size, prevalence]() {
+		auto state = make_shared<ClusterState>(size, 1U);
+		const auto num_cases = max<std::size_t>(1U, static_cast<std::size_t>(lround(size * prevalence)));
+		for (std::size_t i = 0; i < state->persons.size(); i++) {
+			if (i % size < num_cases) {
+				state->persons[i].GetHealth() = Health(g_fate, HealthStatus::Infectious, 0U);
+			}
+		}
+		state->Save();
+		return Case{[state, &env]() { state->Execute(env); }, [state]() { state->Restore(); }};
+	});
+}
+
+/// Cluster::SortMembers, through Infector::Execute on clusters without infectious members, which only sorts
+/// them. A tenth of the members became immune and a fifth recovered since they were added.
+void AddSortMembers(Benchmark& benchmark, const Environment& env, std::size_t size)
+{
+	benchmark.Add("Cluster::SortMembers/size:" + to_string(size), g_cluster_members, "person", [&env, size]() {
+		auto state = make_shared<ClusterState>(size, 2U);
+		for (auto& p : state->persons) {
+			const double draw = state->rng.NextDouble();
+			if (draw < 0.1) {
+				p.GetHealth() = Health(g_fate, HealthStatus::Immune, 0U);
+			} else if (draw < 0.3) {
+				p.GetHealth() = Health(g_fate, HealthStatus::Recovered, 0U);
+			}
+		}
+		state->Save();
+		return Case{[state, &env]() { state->Execute(env); }, [state]() { state->Restore(); }};
+	});
+}
+
+/// Iterating over a ParallelMap, and over the std::map and std::vector it stands in for.
+void AddParallelMap(Benchmark& benchmark, const Environment& env, std::size_t size)
+{
+	const auto suffix = "/size:" + to_string(size);
+	const auto map_action = [](const int& key, int& value, unsigned int) { value = value * 31 + key; };
+	benchmark.Add("ParallelMap::parallel_for" + suffix, size, "element", [&env, size, map_action]() {
+		auto values = make_shared<parallel::ParallelMap<int, int>>();
+		for (std::size_t i = 0; i < size; i++) {
+			(*values)[static_cast<int>(i)] = 0;
+		}
+		return Case{
+		    [values, &env, map_action]() { parallel::parallel_for(*values, env.num_threads, map_action); }, {}};
+	});
+	benchmark.Add("ParallelMap::serial_for" + suffix, size, "element", [size, map_action]() {
+		auto values = make_shared<parallel::ParallelMap<int, int>>();
+		for (std::size_t i = 0; i < size; i++) {
+			(*values)[static_cast<int>(i)] = 0;
+		}
+		return Case{[values, map_action]() { parallel::serial_for(*values, map_action); }, {}};
+	});
+	benchmark.Add("std::map/serial_for" + suffix, size, "element", [size, map_action]() {
+		auto values = make_shared<map<int, int>>();
+		for (std::size_t i = 0; i < size; i++) {
+			(*values)[static_cast<int>(i)] = 0;
+		}
+		return Case{[values, map_action]() { parallel::serial_for(*values, map_action); }, {}};
+	});
+	benchmark.Add("std::vector/parallel_for" + suffix, size, "element", [&env, size]() {
+		auto values = make_shared<vector<int>>(size, 0);
+		return Case{[values, &env]() {
+				    parallel::parallel_for(*values, env.num_threads, [](int& value, unsigned int) {
+					    value = value * 31 + 1;
+				    });
+			    },
+			    {}};
+	});
+}
+
+/// Population::get_random_persons from a population of the given size.
+void AddRandomPersons(Benchmark& benchmark, std::size_t size, std::size_t count)
+{
+	const auto name = "Population::get_random_persons/size:" + to_string(size) + "/count:" + to_string(count);
+	benchmark.Add(name, count, "person", [size, count]() {
+		struct State
+		{
+			Random rng{3U};
+			Population population;
+		};
+		auto state = make_shared<State>();
+		for (const auto& p : MakePersons(size, 20U, state->rng)) {
+			state->population.emplace(p);
+		}
+		return Case{[state, count]() {
+				    g_sink = g_sink + state->population.get_random_persons(state->rng, count).size();
+			    },
+			    [state]() { state->rng = Random(3U); }};
+	});
+}
+
+/// Generator::FindLocal in a grid of the given number of places, spread over an area of the size of Belgium.
+void AddFindLocal(Benchmark& benchmark, std::size_t places, std::size_t lookups)
+{
+	const auto name = "Generator::FindLocal/places:" + to_string(places);
+	benchmark.Add(name, lookups, "lookup", [places, lookups]() {
+		struct State
+		{
+			State()
+			    : rng(4U), disease(disease::Distribution({1.0}), disease::Distribution({1.0}),
+					       disease::Distribution({1.0}), disease::Distribution({1.0}))
+			{
+			}
+
+			Random rng;
+			disease::Disease disease;
+			map<geo::GeoPosition, std::size_t> places;
+			unique_ptr<geo::GeoGrid<std::size_t>> grid;
+			unique_ptr<population::Generator> generator;
+			vector<geo::GeoPosition> origins;
+		};
+		auto state = make_shared<State>();
+		const auto model = make_shared<population::Model>(
+		    500, 20, 3000, 20, 20, 2000, 10.0, 100000, 0.1,
+		    map<InclusiveRange<int>, double>{{InclusiveRange<int>(1000, 10000), 1.0}},
+		    InclusiveRange<int>(3, 17), InclusiveRange<int>(18, 25), 0.5, 0.5, InclusiveRange<int>(18, 64), 0.7,
+		    0.5);
+		state->generator = make_unique<population::Generator>(
+		    model, nullptr, make_shared<vector<population::ReferenceHousehold>>(), state->disease, state->rng);
+		const auto random_position = [&state]() {
+			return geo::GeoPosition{state->rng(49.5, 51.5), state->rng(2.5, 6.4)};
+		};
+		while (state->places.size() < places) {
+			state->places.emplace(random_position(), state->places.size());
+		}
+		state->grid = make_unique<geo::GeoGrid<std::size_t>>(state->places, model->search_radius);
+		for (std::size_t i = 0; i < lookups; i++) {
+			state->origins.push_back(random_position());
+		}
+		return Case{[state]() {
+				    std::size_t sum = 0;
+				    for (const auto& origin : state->origins) {
+					    sum += state->generator->FindLocal(origin, *state->grid, state->rng);
+				    }
+				    g_sink = g_sink + sum;
+			    },
+			    [state]() { state->rng = Random(4U); }};
+	});
+}
+
+/// Alias::Next with the given number of outcomes.
+void AddAlias(Benchmark& benchmark, std::size_t outcomes, std::size_t draws)
+{
+	benchmark.Add("Alias::Next/outcomes:" + to_string(outcomes), draws, "draw", [outcomes, draws]() {
+		struct State
+		{
+			explicit State(const vector<double>& weights)
+			    : rng(5U), alias(alias::Alias::CreateDistribution(weights, rng))
+			{
+			}
+
+			Random rng;
+			alias::Alias alias;
+		};
+		Random weights_rng(6U);
+		vector<double> weights;
+		for (std::size_t i = 0; i < outcomes; i++) {
+			weights.push_back(weights_rng.NextDouble());
+		}
+		auto state = make_shared<State>(weights);
+		return Case{[state, draws]() {
+				    std::size_t sum = 0;
+				    for (std::size_t i = 0; i < draws; i++) {
+					    sum += state->alias.Next();
+				    }
+				    g_sink = g_sink + sum;
+			    },
+			    [state]() { state->rng = Random(5U); }};
+	});
+}
+
+/// The draws of the RngHandler: one per contact, or in bulk for the TransmissionKernel.
+void AddRngHandler(Benchmark& benchmark, std::size_t draws)
+{
+	benchmark.Add("RngHandler::HasContactAndTransmission", draws, "draw", [draws]() {
+		auto handler = make_shared<RngHandler>(7U, 1U, 0U);
+		return Case{[handler, draws]() {
+				    std::size_t hits = 0;
+				    for (std::size_t i = 0; i < draws; i++) {
+					    hits += handler->HasContactAndTransmission(0.5, 0.2);
+				    }
+				    g_sink = g_sink + hits;
+			    },
+			    [handler]() { *handler = RngHandler(7U, 1U, 0U); }};
+	});
+	benchmark.Add("RngHandler::DrawUniforms", draws, "draw", [draws]() {
+		auto handler = make_shared<RngHandler>(7U, 1U, 0U);
+		auto uniforms = make_shared<vector<double>>(draws);
+		return Case{[handler, uniforms]() {
+				    handler->DrawUniforms(uniforms->data(), uniforms->size());
+				    g_sink = g_sink + static_cast<std::size_t>(uniforms->back() * 2.0);
+			    },
+			    [handler]() { *handler = RngHandler(7U, 1U, 0U); }};
+	});
+}
+
+#if USE_HDF5
+/// Writing a checkpoint of a simulator with the given number of persons to a file, and reading it back.
+void AddCheckPoint(Benchmark& benchmark, const Environment& env, std::size_t size)
+{
+	struct State
+	{
+		~State() { std::remove(file_name.c_str()); }
+
+		std::string file_name;
+		std::shared_ptr<Simulator> sim;
+		std::unique_ptr<checkpoint::CheckPoint> cp;
+	};
+	const auto make_state = [&env, size]() {
+		auto state = make_shared<State>();
+		state->file_name = "stride_bench_" + to_string(size) + ".h5";
+		Random rng(8U);
+		auto population = make_shared<Population>();
+		for (const auto& p : MakePersons(size, 20U, rng)) {
+			population->emplace(p);
+		}
+		state->sim = SimulatorBuilder::Build(env.config, population, env.log, env.num_threads);
+		state->cp = make_unique<checkpoint::CheckPoint>(state->file_name);
+		return state;
+	};
+	const auto write = [](const State& state) {
+		state.cp->CreateFile();
+		state.cp->OpenFile();
+		state.cp->SaveCheckPoint(*state.sim, 0U);
+		state.cp->CloseFile();
+	};
+
+	benchmark.Add("CheckPoint::write/persons:" + to_string(size), size, "person", [make_state, write]() {
+		auto state = make_state();
+		return Case{[state, write]() { write(*state); }, {}};
+	});
+	benchmark.Add("CheckPoint::read/persons:" + to_string(size), size, "person", [make_state, write]() {
+		auto state = make_state();
+		write(*state);
+		return Case{[state]() {
+				    state->cp->OpenFile();
+				    g_sink = g_sink + (state->cp->LoadSnapshot(state->sim->GetDate()) != nullptr);
+				    state->cp->CloseFile();
+			    },
+			    {}};
+	});
+}
+#endif
+
+/// Registers the benchmarks.
+void AddBenchmarks(Benchmark& benchmark, const Environment& env)
+{
+	for (std::size_t size : {8U, 64U, 512U, 4096U}) {
+		for (double prevalence : {0.01, 0.1}) {
+			AddInfector(benchmark, env, size, prevalence);
+		}
+	}
+	for (std::size_t size : {8U, 64U, 512U, 4096U}) {
+		AddSortMembers(benchmark, env, size);
+	}
+	for (std::size_t size : {1000U, 100000U}) {
+		AddParallelMap(benchmark, env, size);
+	}
+	AddRandomPersons(benchmark, 100000U, 1000U);
+	for (std::size_t places : {100U, 10000U}) {
+		AddFindLocal(benchmark, places, 10000U);
+	}
+	for (std::size_t outcomes : {8U, 1024U}) {
+		AddAlias(benchmark, outcomes, 100000U);
+	}
+	AddRngHandler(benchmark, 100000U);
+#if USE_HDF5
+	for (std::size_t size : {10000U, 100000U}) {
+		AddCheckPoint(benchmark, env, size);
+	}
+#endif
+}
+
+} // end_of_namespace
+
+/// Runs the microbenchmarks, and compares them with a baseline.
+int main(int argc, char** argv)
+{
+	int exit_status = EXIT_SUCCESS;
+	try {
+		CmdLine cmd("stride_bench", ' ', "1.0", false);
+		ValueArg<string> filter_Arg(
+		    "f", "filter", "Only run the benchmarks whose name contains this text", false, "", "TEXT", cmd);
+		SwitchArg list_Arg("l", "list", "List the benchmarks instead of running them", cmd, false);
+		ValueArg<unsigned int> repetitions_Arg(
+		    "r", "repetitions", "Number of timed repetitions of every benchmark", false, 10U, "COUNT", cmd);
+		ValueArg<double> warmup_Arg(
+		    "w", "warmup", "Seconds of warmup per benchmark", false, 0.1, "SECONDS", cmd);
+		ValueArg<double> min_time_Arg(
+		    "m", "min-time", "Minimum seconds per repetition", false, 0.05, "SECONDS", cmd);
+		ValueArg<unsigned int> threads_Arg(
+		    "n", "threads", "Number of threads of the parallel benchmarks", false, 0U, "COUNT", cmd);
+		ValueArg<string> json_Arg("j", "json", "Write the results to a JSON file", false, "", "JSON FILE", cmd);
+		ValueArg<string> baseline_Arg(
+		    "b", "baseline", "Compare the results with a JSON file of an earlier run", false, "", "JSON FILE",
+		    cmd);
+		ValueArg<double> tolerance_Arg(
+		    "t", "tolerance", "Percentage by which a benchmark may be slower than the baseline", false, 5.0,
+		    "PERCENTAGE", cmd);
+		ValueArg<string> config_Arg(
+		    "c", "config", "Configuration of the disease and the contacts, in the config directory", false,
+		    "run_default.xml", "CONFIGURATION FILE", cmd);
+		cmd.parse(argc, argv);
+
+		// The disease, contact profiles and calendar of the configuration.
+		Environment env;
+		ptree pt_config;
+		InstallDirs::ReadXmlFile(config_Arg.getValue(), InstallDirs::GetRootDir() / "config", pt_config);
+		env.config.Parse(pt_config.get_child("run"));
+		ptree pt_disease;
+		InstallDirs::ReadXmlFile(
+		    env.config.common_config->disease_config_file_name, InstallDirs::GetDataDir(), pt_disease);
+		env.disease_profile.Initialize(env.config, pt_disease);
+		ptree pt_contact;
+		InstallDirs::ReadXmlFile(
+		    env.config.common_config->contact_matrix_file_name, InstallDirs::GetDataDir(), pt_contact);
+		for (auto type : {ClusterType::Household, ClusterType::School, ClusterType::Work,
+				  ClusterType::PrimaryCommunity, ClusterType::SecondaryCommunity}) {
+			Cluster::AddContactProfile(type, ContactProfile(type, pt_contact));
+		}
+		env.calendar = make_shared<Calendar>(env.config.common_config->initial_calendar);
+		env.log = spdlog::stderr_logger_st("stride_bench");
+		env.log->set_level(spdlog::level::off);
+		env.num_threads =
+		    threads_Arg.getValue() > 0U ? threads_Arg.getValue() : parallel::get_number_of_threads();
+
+		Benchmark benchmark;
+		AddBenchmarks(benchmark, env);
+		if (list_Arg.getValue()) {
+			for (const auto& name : benchmark.GetNames()) {
+				cout << name << endl;
+			}
+			return exit_status;
+		}
+
+		Benchmark::Options options;
+		options.repetitions = repetitions_Arg.getValue();
+		options.warmup_seconds = warmup_Arg.getValue();
+		options.min_repetition_seconds = min_time_Arg.getValue();
+		const auto results = benchmark.Run(options, filter_Arg.getValue(), cout);
+
+		if (!json_Arg.getValue().empty()) {
+			ofstream out(json_Arg.getValue());
+			if (!out) {
+				throw runtime_error("Cannot open " + json_Arg.getValue());
+			}
+			const map<string, string> context{{"date", TimeStamp().ToString()},
+							  {"threads", to_string(env.num_threads)},
+							  {"transmission_kernel", TransmissionKernel::GetName()},
+							  {"repetitions", to_string(options.repetitions)}};
+			Benchmark::WriteJson(results, context, out);
+		}
+		if (!baseline_Arg.getValue().empty()) {
+			cout << endl;
+			const auto baseline = Benchmark::ReadBaseline(baseline_Arg.getValue());
+			const auto tolerance = tolerance_Arg.getValue() / 100.0;
+			const auto slower = Benchmark::Compare(results, baseline, tolerance, cout);
+			if (slower > 0U) {
+				cout << slower << " benchmark(s) slower than the baseline." << endl;
+				exit_status = EXIT_FAILURE;
+			}
+		}
+	} catch (exception& e) {
+		exit_status = EXIT_FAILURE;
+		cerr << "\nEXCEPION THROWN: " << e.what() << endl;
+	}
+	return exit_status;
+}
@@ -6,9 +6,12 @@
 #include <core/Health.h>
 #include <multiregion/TravelModel.h>
 #include <pop/Person.h>
+#include <sim/SimulatorBuilder.h>
 #include <util/Errors.h>
 #include <util/InstallDirs.h>
+#include <util/Parallel.h>
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <sstream>
@@ -22,14 +25,167 @@ using namespace std;
 namespace stride {
 namespace checkpoint {
 
-CheckPoint::CheckPoint(const std::string& filename) : m_filename(filename) {}
+namespace {
+
+/// Writes a vector of values as a one-dimensional dataset.
+template <typename T>
+void WriteColumn(hid_t loc, const std::string& name, hid_t type, const std::vector<T>& data, hid_t plist)
+{
+	hsize_t dims = data.size();
+	hid_t dataspace = H5Screate_simple(1, &dims, nullptr);
+	hid_t dataset = H5Dcreate2(loc, name.c_str(), type, dataspace, H5P_DEFAULT, plist, H5P_DEFAULT);
+	H5Dwrite(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
+	H5Dclose(dataset);
+	H5Sclose(dataspace);
+}
+
+/// Reads a one-dimensional dataset into a vector of values.
+template <typename T>
+std::vector<T> ReadColumn(hid_t loc, const std::string& name, hid_t type)
+{
+	if (H5Lexists(loc, name.c_str(), H5P_DEFAULT) <= 0) {
+		FATAL_ERROR("Missing checkpoint column " + name);
+	}
+	hid_t dataset = H5Dopen2(loc, name.c_str(), H5P_DEFAULT);
+	hid_t dataspace = H5Dget_space(dataset);
+	hsize_t dims;
+	H5Sget_simple_extent_dims(dataspace, &dims, nullptr);
+
+	std::vector<T> result(dims);
+	if (dims > 0) {
+		H5Dread(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, result.data());
+	}
+	H5Sclose(dataspace);
+	H5Dclose(dataset);
+	return result;
+}
+
+} // namespace
+
+CheckPoint::CheckPoint(
+    const std::string& filename, unsigned int chunk_size, unsigned int compression, CheckPointLayout layout)
+    : m_filename(filename), m_chunk_size(std::max(chunk_size, 1U)), m_compression(compression), m_layout(layout),
+      m_has_last_health(false), m_has_last_journals(false)
+{
+}
+
+hid_t CheckPoint::CreatePersonType()
+{
+	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_personType));
+
+	H5Tinsert(newType, "ID", HOFFSET(h_personType, ID), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "OriginalID", HOFFSET(h_personType, OriginalID), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "Age", HOFFSET(h_personType, Age), H5T_NATIVE_DOUBLE);
+	H5Tinsert(newType, "Gender", HOFFSET(h_personType, Gender), H5T_NATIVE_CHAR);
+	H5Tinsert(newType, "Participating", HOFFSET(h_personType, Participating), H5T_NATIVE_HBOOL);
+	H5Tinsert(newType, "Immune", HOFFSET(h_personType, Immune), H5T_NATIVE_HBOOL);
+	H5Tinsert(newType, "Infected", HOFFSET(h_personType, Infected), H5T_NATIVE_HBOOL);
+	H5Tinsert(newType, "StartInf", HOFFSET(h_personType, StartInf), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "EndInf", HOFFSET(h_personType, EndInf), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "StartSympt", HOFFSET(h_personType, StartSympt), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "EndSympt", HOFFSET(h_personType, EndSympt), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "TimeInfected", HOFFSET(h_personType, TimeInfected), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "Household", HOFFSET(h_personType, Household), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "School", HOFFSET(h_personType, School), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "Work", HOFFSET(h_personType, Work), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "Primary", HOFFSET(h_personType, Primary), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "Secondary", HOFFSET(h_personType, Secondary), H5T_NATIVE_UINT);
+
+	return newType;
+}
+
+hid_t CheckPoint::CreateClusterType()
+{
+	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_clusterType));
+
+	H5Tinsert(newType, "ID", HOFFSET(h_clusterType, ID), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "PersonID", HOFFSET(h_clusterType, PersonID), H5T_NATIVE_UINT);
+
+	return newType;
+}
+
+hid_t CheckPoint::CreateVisitorType()
+{
+	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_visitorType));
+
+	H5Tinsert(newType, "DaysLeft", HOFFSET(h_visitorType, DaysLeft), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "RegionID", HOFFSET(h_visitorType, RegionID), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "PersonIDHome", HOFFSET(h_visitorType, PersonIDHome), H5T_NATIVE_UINT);
+	H5Tinsert(newType, "PersonIDVisitor", HOFFSET(h_visitorType, PersonIDVisitor), H5T_NATIVE_UINT);
+
+	return newType;
+}
+
+hid_t CheckPoint::CreateChunkedProperties(hsize_t size) const
+{
+	hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+	if (size == 0) {
+		// Chunks can't be empty; an empty dataset is stored contiguously.
+		return plist;
+	}
+
+	hsize_t chunkDims[1] = {std::min(size, m_chunk_size)};
+	H5Pset_chunk(plist, 1, chunkDims);
+	if (m_compression > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+		H5Pset_shuffle(plist);
+		H5Pset_deflate(plist, std::min(m_compression, 9U));
+	}
+	return plist;
+}
+
+HealthStatus CheckPoint::h_personType::GetStatus() const
+{
+	// Only infected and recovered persons have a non-zero day counter.
+	if (Immune) {
+		return HealthStatus::Immune;
+	} else if (Infected) {
+		disease::Fate fate;
+		fate.start_infectiousness = StartInf;
+		fate.start_symptomatic = StartSympt;
+		fate.end_infectiousness = EndInf;
+		fate.end_symptomatic = EndSympt;
+		return Health::GetInfectedStatus(fate, TimeInfected);
+	} else if (TimeInfected > 0) {
+		return HealthStatus::Recovered;
+	}
+	return HealthStatus::Susceptible;
+}
+
+Person CheckPoint::h_personType::ToPerson(HealthStatus status) const
+{
+	disease::Fate disease;
+	disease.start_infectiousness = StartInf;
+	disease.start_symptomatic = StartSympt;
+	disease.end_infectiousness = EndInf;
+	disease.end_symptomatic = EndSympt;
+
+	Person result(ID, Age, Household, School, Work, Primary, Secondary, disease);
+	result.SetOriginalId(OriginalID);
+
+	if (Participating) {
+		result.ParticipateInSurvey();
+	}
+	result.GetHealth() = Health(disease, status, TimeInfected);
+	return result;
+}
 
 void CheckPoint::CreateFile()
 {
+	ResetCaches();
 	m_file = H5Fcreate(m_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
 	H5Fclose(m_file);
 }
 
+void CheckPoint::ResetCaches()
+{
+	m_static_ids.clear();
+	m_last_health = HealthColumns();
+	m_has_last_health = false;
+	m_last_expatriates.clear();
+	m_last_visitors.clear();
+	m_has_last_journals = false;
+}
+
 void CheckPoint::CloseFile() { H5Fclose(m_file); }
 
 void CheckPoint::WriteConfig(const SingleSimulationConfig& conf)
@@ -143,63 +299,349 @@ void CheckPoint::WriteHolidays(const std::string& filename, unsigned int* group)
 	}
 }
 
-void CheckPoint::WritePopulation(const Population& pop, boost::gregorian::date date)
+void CheckPoint::WritePopulation(const Snapshot& snapshot)
 {
-	std::string datestr = to_iso_string(date);
+	if (m_layout != CheckPointLayout::Compound) {
+		WritePopulationColumns(snapshot);
+		return;
+	}
+
+	std::string datestr = to_iso_string(snapshot.date);
 	htri_t exist = H5Lexists(m_file, datestr.c_str(), H5P_DEFAULT);
 	if (exist <= 0) {
 		hid_t temp = H5Gcreate2(m_file, datestr.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		H5Gclose(temp);
 	}
 
-	hsize_t dims[1] = {pop.size()};
+	const auto& persons = snapshot.persons;
+	hsize_t dims[1] = {persons.size()};
 	hid_t dataspace = H5Screate_simple(1, dims, nullptr);
 	std::string spot = datestr + "/Population";
 
-	hid_t chunkP = H5Pcreate(H5P_DATASET_CREATE);
-	hsize_t chunkDims[1] = {1};
-	H5Pset_chunk(chunkP, 1, chunkDims);
-
-	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_personType));
-
-	H5Tinsert(newType, "ID", HOFFSET(h_personType, ID), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Age", HOFFSET(h_personType, Age), H5T_NATIVE_DOUBLE);
-	H5Tinsert(newType, "Gender", HOFFSET(h_personType, Gender), H5T_NATIVE_CHAR);
-	H5Tinsert(newType, "Participating", HOFFSET(h_personType, Participating), H5T_NATIVE_HBOOL);
-	H5Tinsert(newType, "Immune", HOFFSET(h_personType, Immune), H5T_NATIVE_HBOOL);
-	H5Tinsert(newType, "Infected", HOFFSET(h_personType, Infected), H5T_NATIVE_HBOOL);
-	H5Tinsert(newType, "StartInf", HOFFSET(h_personType, StartInf), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "EndInf", HOFFSET(h_personType, EndInf), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "StartSympt", HOFFSET(h_personType, StartSympt), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "EndSympt", HOFFSET(h_personType, EndSympt), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "TimeInfected", HOFFSET(h_personType, TimeInfected), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Household", HOFFSET(h_personType, Household), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "School", HOFFSET(h_personType, School), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Work", HOFFSET(h_personType, Work), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Primary", HOFFSET(h_personType, Primary), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Secondary", HOFFSET(h_personType, Secondary), H5T_NATIVE_UINT);
-
+	hid_t chunkP = CreateChunkedProperties(dims[0]);
+	hid_t newType = CreatePersonType();
 	hid_t dataset = H5Dcreate2(m_file, spot.c_str(), newType, dataspace, H5P_DEFAULT, chunkP, H5P_DEFAULT);
+	H5Pclose(chunkP);
 
-	chunkP = H5Pcreate(H5P_DATASET_XFER);
-	unsigned int i = 0;
-
-	pop.serial_for([this, &i, &newType, &dataspace, &dataset, &chunkP](const Person& p, unsigned int) {
-		h_personType data(p);
-
-		hsize_t start[1] = {i};
-		hsize_t count[1] = {1};
-		hid_t chunkspace = H5Screate_simple(1, count, nullptr);
-		H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, start, nullptr, count, nullptr);
-		H5Dwrite(dataset, newType, chunkspace, dataspace, chunkP, &data);
-		i++;
+	// The records are written one chunk at a time.
+	for (hsize_t start = 0; start < dims[0]; start += m_chunk_size) {
+		hsize_t count = std::min(dims[0] - start, m_chunk_size);
+		hid_t chunkspace = H5Screate_simple(1, &count, nullptr);
+		H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
+		H5Dwrite(dataset, newType, chunkspace, dataspace, H5P_DEFAULT, persons.data() + start);
 		H5Sclose(chunkspace);
-	});
+	}
+
 	H5Tclose(newType);
 	H5Dclose(dataset);
 	H5Sclose(dataspace);
 }
 
+void CheckPoint::WriteStaticColumns(const Snapshot& snapshot)
+{
+	if (H5Lexists(m_file, "Config", H5P_DEFAULT) <= 0) {
+		hid_t temp = H5Gcreate2(m_file, "Config", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		H5Gclose(temp);
+	}
+	if (H5Lexists(m_file, "Config/Population", H5P_DEFAULT) > 0) {
+		return;
+	}
+
+	const auto& persons = snapshot.persons;
+	std::vector<unsigned int> ids, original_ids, start_inf, end_inf, start_sympt, end_sympt;
+	std::vector<double> ages;
+	std::vector<char> genders;
+	std::vector<unsigned char> participating;
+	std::vector<std::vector<unsigned int>> clusters(NumOfClusterTypes());
+	for (const auto& p : persons) {
+		ids.push_back(p.ID);
+		original_ids.push_back(p.OriginalID);
+		ages.push_back(p.Age);
+		genders.push_back(p.Gender);
+		participating.push_back(p.Participating);
+		start_inf.push_back(p.StartInf);
+		end_inf.push_back(p.EndInf);
+		start_sympt.push_back(p.StartSympt);
+		end_sympt.push_back(p.EndSympt);
+		clusters[0].push_back(p.Household);
+		clusters[1].push_back(p.School);
+		clusters[2].push_back(p.Work);
+		clusters[3].push_back(p.Primary);
+		clusters[4].push_back(p.Secondary);
+	}
+
+	hid_t group = H5Gcreate2(m_file, "Config/Population", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	hid_t plist = CreateChunkedProperties(persons.size());
+	WriteColumn(group, "ID", H5T_NATIVE_UINT, ids, plist);
+	WriteColumn(group, "OriginalID", H5T_NATIVE_UINT, original_ids, plist);
+	WriteColumn(group, "Age", H5T_NATIVE_DOUBLE, ages, plist);
+	WriteColumn(group, "Gender", H5T_NATIVE_CHAR, genders, plist);
+	WriteColumn(group, "Participating", H5T_NATIVE_UCHAR, participating, plist);
+	WriteColumn(group, "StartInf", H5T_NATIVE_UINT, start_inf, plist);
+	WriteColumn(group, "EndInf", H5T_NATIVE_UINT, end_inf, plist);
+	WriteColumn(group, "StartSympt", H5T_NATIVE_UINT, start_sympt, plist);
+	WriteColumn(group, "EndSympt", H5T_NATIVE_UINT, end_sympt, plist);
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		WriteColumn(group, ToString(static_cast<ClusterType>(t)), H5T_NATIVE_UINT, clusters[t], plist);
+	}
+	H5Pclose(plist);
+	H5Gclose(group);
+
+	m_static_ids = std::move(ids);
+}
+
+const std::vector<unsigned int>& CheckPoint::GetStaticIds()
+{
+	if (m_static_ids.empty() && H5Lexists(m_file, "Config/Population", H5P_DEFAULT) > 0) {
+		hid_t group = H5Gopen2(m_file, "Config/Population", H5P_DEFAULT);
+		m_static_ids = ReadColumn<unsigned int>(group, "ID", H5T_NATIVE_UINT);
+		H5Gclose(group);
+	}
+	return m_static_ids;
+}
+
+void CheckPoint::WriteHealth(const std::string& groupname, const HealthColumns& health)
+{
+	hid_t group = H5Gcreate2(m_file, groupname.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	hid_t plist = CreateChunkedProperties(health.ids.size());
+	WriteColumn(group, "ID", H5T_NATIVE_UINT, health.ids, plist);
+	WriteColumn(group, "Status", H5T_NATIVE_UCHAR, health.status, plist);
+	WriteColumn(group, "DaysInfected", H5T_NATIVE_UINT, health.days_infected, plist);
+	H5Pclose(plist);
+	H5Gclose(group);
+}
+
+CheckPoint::HealthColumns CheckPoint::ReadHealth(const std::string& groupname)
+{
+	HealthColumns result;
+	hid_t group = H5Gopen2(m_file, groupname.c_str(), H5P_DEFAULT);
+	result.ids = ReadColumn<unsigned int>(group, "ID", H5T_NATIVE_UINT);
+	result.status = ReadColumn<unsigned char>(group, "Status", H5T_NATIVE_UCHAR);
+	result.days_infected = ReadColumn<unsigned int>(group, "DaysInfected", H5T_NATIVE_UINT);
+	H5Gclose(group);
+	return result;
+}
+
+CheckPoint::HealthColumns CheckPoint::ApplyDelta(
+    const HealthColumns& health, const HealthColumns& changes, const std::vector<unsigned int>& removed)
+{
+	// All three id lists are sorted, so the delta is applied in a single merge.
+	HealthColumns result;
+	std::size_t i = 0, j = 0, k = 0;
+	while (i < health.ids.size() || j < changes.ids.size()) {
+		if (j == changes.ids.size() || (i < health.ids.size() && health.ids[i] < changes.ids[j])) {
+			while (k < removed.size() && removed[k] < health.ids[i]) {
+				k++;
+			}
+			if (k == removed.size() || removed[k] != health.ids[i]) {
+				result.ids.push_back(health.ids[i]);
+				result.status.push_back(health.status[i]);
+				result.days_infected.push_back(health.days_infected[i]);
+			}
+			i++;
+		} else {
+			if (i < health.ids.size() && health.ids[i] == changes.ids[j]) {
+				i++;
+			}
+			result.ids.push_back(changes.ids[j]);
+			result.status.push_back(changes.status[j]);
+			result.days_infected.push_back(changes.days_infected[j]);
+			j++;
+		}
+	}
+	return result;
+}
+
+CheckPoint::HealthColumns CheckPoint::ReplayHealth(boost::gregorian::date date)
+{
+	auto dates = GetDates();
+	dates.erase(std::upper_bound(dates.begin(), dates.end(), date), dates.end());
+
+	// Find the last full health record, then apply every delta after it.
+	std::size_t base = dates.size();
+	for (std::size_t i = dates.size(); i-- > 0;) {
+		if (H5Lexists(m_file, (to_iso_string(dates[i]) + "/Health").c_str(), H5P_DEFAULT) > 0) {
+			base = i;
+			break;
+		}
+	}
+	if (base == dates.size()) {
+		FATAL_ERROR("No full health record before " + to_iso_string(date));
+	}
+
+	HealthColumns result = ReadHealth(to_iso_string(dates[base]) + "/Health");
+	for (std::size_t i = base + 1; i < dates.size(); i++) {
+		const std::string groupname = to_iso_string(dates[i]) + "/Delta";
+		if (H5Lexists(m_file, groupname.c_str(), H5P_DEFAULT) <= 0) {
+			continue;
+		}
+		const HealthColumns changes = ReadHealth(groupname);
+		hid_t group = H5Gopen2(m_file, groupname.c_str(), H5P_DEFAULT);
+		const auto removed = ReadColumn<unsigned int>(group, "Removed", H5T_NATIVE_UINT);
+		H5Gclose(group);
+		result = ApplyDelta(result, changes, removed);
+	}
+	return result;
+}
+
+void CheckPoint::WritePopulationColumns(const Snapshot& snapshot)
+{
+	WriteStaticColumns(snapshot);
+
+	std::string datestr = to_iso_string(snapshot.date);
+	if (H5Lexists(m_file, datestr.c_str(), H5P_DEFAULT) <= 0) {
+		hid_t temp = H5Gcreate2(m_file, datestr.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		H5Gclose(temp);
+	}
+
+	// The health of every person in the static columns. The ids are repeated, as travellers may be abroad.
+	const auto& static_ids = GetStaticIds();
+	const auto& persons = snapshot.persons;
+	HealthColumns health;
+	health.ids.reserve(persons.size());
+	health.status.reserve(persons.size());
+	health.days_infected.reserve(persons.size());
+	std::vector<h_personType> newcomers;
+	for (std::size_t i = 0; i < persons.size(); i++) {
+		if (!std::binary_search(static_ids.begin(), static_ids.end(), persons[i].ID)) {
+			newcomers.push_back(persons[i]);
+			continue;
+		}
+		health.ids.push_back(persons[i].ID);
+		health.status.push_back(snapshot.status[i]);
+		health.days_infected.push_back(persons[i].TimeInfected);
+	}
+
+	if (m_layout == CheckPointLayout::Delta && !m_has_last_health) {
+		// Continue the deltas of a file that was written before, if any.
+		auto dates = GetDates();
+		dates.erase(std::lower_bound(dates.begin(), dates.end(), snapshot.date), dates.end());
+		for (auto it = dates.rbegin(); it != dates.rend() && !m_has_last_health; ++it) {
+			const std::string d = to_iso_string(*it);
+			if (H5Lexists(m_file, (d + "/Health").c_str(), H5P_DEFAULT) > 0 ||
+			    H5Lexists(m_file, (d + "/Delta").c_str(), H5P_DEFAULT) > 0) {
+				m_last_health = ReplayHealth(*it);
+				m_has_last_health = true;
+			}
+		}
+	}
+
+	if (m_layout == CheckPointLayout::Delta && m_has_last_health) {
+		const auto& last = m_last_health;
+		HealthColumns changes;
+		std::vector<unsigned int> removed;
+		std::size_t i = 0, j = 0;
+		while (i < last.ids.size() || j < health.ids.size()) {
+			if (j == health.ids.size() || (i < last.ids.size() && last.ids[i] < health.ids[j])) {
+				removed.push_back(last.ids[i++]);
+				continue;
+			}
+			const bool same = i < last.ids.size() && last.ids[i] == health.ids[j];
+			if (!same || last.status[i] != health.status[j] ||
+			    last.days_infected[i] != health.days_infected[j]) {
+				changes.ids.push_back(health.ids[j]);
+				changes.status.push_back(health.status[j]);
+				changes.days_infected.push_back(health.days_infected[j]);
+			}
+			i += same;
+			j++;
+		}
+
+		WriteHealth(datestr + "/Delta", changes);
+		hid_t group = H5Gopen2(m_file, (datestr + "/Delta").c_str(), H5P_DEFAULT);
+		hid_t plist = CreateChunkedProperties(removed.size());
+		WriteColumn(group, "Removed", H5T_NATIVE_UINT, removed, plist);
+		H5Pclose(plist);
+		H5Gclose(group);
+	} else {
+		WriteHealth(datestr + "/Health", health);
+	}
+	if (m_layout == CheckPointLayout::Delta) {
+		m_last_health = std::move(health);
+		m_has_last_health = true;
+	}
+
+	if (!newcomers.empty()) {
+		hsize_t dims = newcomers.size();
+		hid_t dataspace = H5Screate_simple(1, &dims, nullptr);
+		hid_t newType = CreatePersonType();
+		hid_t dataset = H5Dcreate2(
+		    m_file, (datestr + "/Newcomers").c_str(), newType, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		H5Dwrite(dataset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, newcomers.data());
+		H5Tclose(newType);
+		H5Dclose(dataset);
+		H5Sclose(dataspace);
+	}
+}
+
+void CheckPoint::ReadPopulationColumns(boost::gregorian::date date, Snapshot& snapshot)
+{
+	if (H5Lexists(m_file, "Config/Population", H5P_DEFAULT) <= 0) {
+		FATAL_ERROR("Columnar checkpoint without static population columns");
+	}
+	hid_t group = H5Gopen2(m_file, "Config/Population", H5P_DEFAULT);
+	const auto static_ids = ReadColumn<unsigned int>(group, "ID", H5T_NATIVE_UINT);
+	const auto original_ids = ReadColumn<unsigned int>(group, "OriginalID", H5T_NATIVE_UINT);
+	const auto ages = ReadColumn<double>(group, "Age", H5T_NATIVE_DOUBLE);
+	const auto genders = ReadColumn<char>(group, "Gender", H5T_NATIVE_CHAR);
+	const auto participating = ReadColumn<unsigned char>(group, "Participating", H5T_NATIVE_UCHAR);
+	const auto start_inf = ReadColumn<unsigned int>(group, "StartInf", H5T_NATIVE_UINT);
+	const auto end_inf = ReadColumn<unsigned int>(group, "EndInf", H5T_NATIVE_UINT);
+	const auto start_sympt = ReadColumn<unsigned int>(group, "StartSympt", H5T_NATIVE_UINT);
+	const auto end_sympt = ReadColumn<unsigned int>(group, "EndSympt", H5T_NATIVE_UINT);
+	std::vector<std::vector<unsigned int>> clusters;
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		clusters.push_back(
+		    ReadColumn<unsigned int>(group, ToString(static_cast<ClusterType>(t)), H5T_NATIVE_UINT));
+	}
+	H5Gclose(group);
+
+	const HealthColumns health = ReplayHealth(date);
+	snapshot.persons.reserve(health.ids.size());
+	snapshot.status.reserve(health.ids.size());
+	for (std::size_t i = 0; i < health.ids.size(); i++) {
+		// Both id columns are written in population order, i.e. sorted.
+		auto it = std::lower_bound(static_ids.begin(), static_ids.end(), health.ids[i]);
+		if (it == static_ids.end() || *it != health.ids[i]) {
+			FATAL_ERROR("Person " + std::to_string(health.ids[i]) + " is missing from the static columns");
+		}
+		const std::size_t row = it - static_ids.begin();
+		const auto status = static_cast<HealthStatus>(health.status[i]);
+
+		h_personType p;
+		p.ID = health.ids[i];
+		p.OriginalID = original_ids[row];
+		p.Age = ages[row];
+		p.Gender = genders[row];
+		p.Participating = participating[row];
+		p.Immune = status == HealthStatus::Immune;
+		p.Infected = status != HealthStatus::Susceptible && status != HealthStatus::Recovered &&
+			     status != HealthStatus::Immune;
+		p.StartInf = start_inf[row];
+		p.EndInf = end_inf[row];
+		p.StartSympt = start_sympt[row];
+		p.EndSympt = end_sympt[row];
+		p.TimeInfected = health.days_infected[i];
+		p.Household = clusters[0][row];
+		p.School = clusters[1][row];
+		p.Work = clusters[2][row];
+		p.Primary = clusters[3][row];
+		p.Secondary = clusters[4][row];
+		snapshot.persons.push_back(p);
+		snapshot.status.push_back(health.status[i]);
+	}
+
+	const std::string newcomers = to_iso_string(date) + "/Newcomers";
+	if (H5Lexists(m_file, newcomers.c_str(), H5P_DEFAULT) > 0) {
+		hid_t newType = CreatePersonType();
+		for (const auto& p : ReadColumn<h_personType>(m_file, newcomers, newType)) {
+			snapshot.persons.push_back(p);
+			snapshot.status.push_back(static_cast<unsigned char>(p.GetStatus()));
+		}
+		H5Tclose(newType);
+	}
+}
+
 void CheckPoint::WriteFileDSet(const std::string& filename, const std::string& setname)
 {
 	boost::filesystem::path path = util::InstallDirs::GetDataDir();
@@ -317,27 +759,81 @@ std::string CheckPoint::WriteDSetFile(const std::string& filestr, const std::str
 	return filename.string();
 }
 
-void CheckPoint::SaveCheckPoint(const Simulator& sim, std::size_t day)
+std::shared_ptr<const CheckPoint::Snapshot> CheckPoint::TakeSnapshot(const Simulator& sim, std::size_t day)
+{
+	// The commuters of both regions and their work clusters are not in a snapshot, so a restored simulator would
+	// lose them.
+	if (sim.GetConfiguration().common_config->commuting_model) {
+		FATAL_ERROR("Checkpoints of simulations with a commuting model are not supported");
+	}
+	auto result = std::make_shared<Snapshot>();
+	result->date = sim.GetDate();
+	result->atlas_owner = sim.GetPopulation();
+
+	const auto& pop = *sim.GetPopulation();
+	result->persons.reserve(pop.size());
+	result->status.reserve(pop.size());
+	pop.serial_for([&result](const Person& p, unsigned int) {
+		result->persons.emplace_back(p);
+		result->status.push_back(static_cast<unsigned char>(p.GetHealth().GetHealthStatus()));
+	});
+
+	// Every cluster is stored as a header record (person id 0), followed by a record per member.
+	const ClusterStruct& clusters = sim.GetClusters();
+	const std::vector<Cluster>* cluster_vectors[] = {
+	    &clusters.m_households, &clusters.m_school_clusters, &clusters.m_work_clusters,
+	    &clusters.m_primary_community, &clusters.m_secondary_community};
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		auto& records = result->clusters[t];
+		for (const auto& cluster : *cluster_vectors[t]) {
+			records.push_back({static_cast<unsigned int>(cluster.GetId()), 0});
+			for (const auto& person : cluster.GetPeople()) {
+				records.push_back({static_cast<unsigned int>(cluster.GetId()), person.GetId()});
+			}
+		}
+	}
+
+	auto expatriates = sim.GetExpatriateJournal();
+	expatriates.SerialForeach([&result](const Person& p, unsigned int) { result->expatriates.emplace_back(p); });
+
+	auto visitors = sim.GetVistiorJournal();
+	result->visitors.reserve(visitors.GetVisitorCount());
+	for (auto& days : visitors.GetVisitors()) {
+		for (auto& place : days.second) {
+			for (auto p : place.second) {
+				h_visitorType i;
+				i.DaysLeft = days.first - day;
+				i.RegionID = place.first;
+				i.PersonIDHome = p.home_id;
+				i.PersonIDVisitor = p.visitor_id;
+				result->visitors.push_back(i);
+			}
+		}
+	}
+
+	return result;
+}
+
+void CheckPoint::WriteSnapshot(const Snapshot& snapshot)
 {
 	// TODO: add airport
-	WritePopulation(*sim.GetPopulation(), sim.GetDate());
-	WriteClusters(sim.GetClusters(), sim.GetDate());
-	auto exp = sim.GetExpatriateJournal();
-	WriteExpatriates(exp, sim.GetDate());
-	auto vis = sim.GetVistiorJournal();
-	WriteVisitors(vis, sim.GetDate(), day);
+	WritePopulation(snapshot);
+	WriteClusters(snapshot);
+	WriteExpatriates(snapshot);
+	WriteVisitors(snapshot);
+	m_has_last_journals = m_layout == CheckPointLayout::Delta;
 
-	htri_t exist = H5Lexists(m_file, "Config", H5P_DEFAULT);
-	if (exist <= 0) {
+	if (H5Lexists(m_file, "Config", H5P_DEFAULT) <= 0) {
 		hid_t group = H5Gcreate2(m_file, "Config", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-		htri_t exist2 = H5Lexists(group, "Atlas", H5P_DEFAULT);
-		if (exist2 <= 0) {
-			WriteAtlas(sim.GetPopulation()->get_atlas());
-		}
 		H5Gclose(group);
 	}
+	if (H5Lexists(m_file, "Config/Atlas", H5P_DEFAULT) <= 0) {
+		WriteAtlas(snapshot.atlas_owner->get_atlas());
+	}
 }
 
+void CheckPoint::SaveCheckPoint(const Simulator& sim, std::size_t day) { WriteSnapshot(*TakeSnapshot(sim, day)); }
+
 void CheckPoint::CombineCheckPoint(unsigned int groupnum, const std::string& filename)
 {
 	std::stringstream ss;
@@ -369,143 +865,256 @@ void CheckPoint::CombineCheckPoint(unsigned int groupnum, const std::string& fil
 	H5Gclose(group);
 }
 
-void CheckPoint::LoadCheckPoint(boost::gregorian::date date, Simulator& sim)
+void CheckPoint::ReadPopulationCompound(const std::string& name, Snapshot& snapshot)
 {
-
-	std::string groupname = to_iso_string(date);
-	std::string name = groupname + "/Population";
-	htri_t exist = H5Lexists(m_file, name.c_str(), H5P_DEFAULT);
-	if (exist <= 0) {
-		FATAL_ERROR("Incorrect date loaded");
-	}
-	// loading people
+	// reading people, one chunk at a time
 	hid_t dset = H5Dopen(m_file, name.c_str(), H5P_DEFAULT);
 	hid_t dspace = H5Dget_space(dset);
-	hid_t newType = H5Dget_type(dset);
+	hid_t newType = CreatePersonType();
 
 	hsize_t dims;
 	H5Sget_simple_extent_dims(dspace, &dims, nullptr);
 
-	auto result = make_shared<Population>();
-	for (hsize_t i = 0; i < dims; i++) {
-		hsize_t start = i;
-
-		hsize_t count = 1;
+	snapshot.persons.resize(dims);
+	for (hsize_t start = 0; start < dims; start += m_chunk_size) {
+		hsize_t count = std::min(dims - start, m_chunk_size);
 
 		hid_t subspace = H5Screate_simple(1, &count, nullptr);
-
 		H5Sselect_hyperslab(dspace, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
-
-		h_personType data;
-
-		H5Dread(dset, newType, subspace, dspace, H5P_DEFAULT, &data);
-
-		disease::Fate disease;
-		disease.start_infectiousness = data.StartInf;
-		disease.start_symptomatic = data.StartSympt;
-		disease.end_infectiousness = data.EndInf;
-		disease.end_symptomatic = data.EndSympt;
-
-		Person toAdd(
-		    data.ID, data.Age, data.Household, data.School, data.Work, data.Primary, data.Secondary, disease);
-
-		if (data.Participating) {
-			toAdd.ParticipateInSurvey();
-		}
-
-		if (data.Immune) {
-			toAdd.GetHealth().SetImmune();
-		}
-		if (data.Infected) {
-			toAdd.GetHealth().StartInfection();
-		}
-		for (unsigned int i = 0; i < data.TimeInfected; i++) {
-			toAdd.GetHealth().Update();
-		}
-
-		result->emplace(toAdd);
+		H5Dread(dset, newType, subspace, dspace, H5P_DEFAULT, snapshot.persons.data() + start);
 		H5Sclose(subspace);
 	}
 
+	snapshot.status.reserve(dims);
+	for (const auto& p : snapshot.persons) {
+		snapshot.status.push_back(static_cast<unsigned char>(p.GetStatus()));
+	}
+
 	H5Sclose(dspace);
 	H5Tclose(newType);
 	H5Dclose(dset);
-
-	LoadAtlas(*result);
-
-	sim.SetPopulation(result);
-	sim.SetExpatriates(LoadExpatriates(*result, date));
-	sim.SetVisitors(LoadVisitors(date));
-
-	ClusterStruct clusters;
-	// loading clusters
-	LoadCluster(sim.GetClusters().m_households, ClusterType::Household, groupname, *result);
-	LoadCluster(sim.GetClusters().m_school_clusters, ClusterType::School, groupname, *result);
-	LoadCluster(sim.GetClusters().m_work_clusters, ClusterType::Work, groupname, *result);
-	LoadCluster(sim.GetClusters().m_primary_community, ClusterType::PrimaryCommunity, groupname, *result);
-	LoadCluster(sim.GetClusters().m_secondary_community, ClusterType::SecondaryCommunity, groupname, *result);
 }
 
-void CheckPoint::LoadCluster(
-    std::vector<Cluster>& clusters, const ClusterType& i, const std::string& groupname, const Population& result)
+std::shared_ptr<const CheckPoint::Snapshot> CheckPoint::LoadSnapshot(boost::gregorian::date date)
 {
-	clusters.clear();
-	std::string type = ToString(i);
-	std::string path = groupname + "/" + type;
-	hid_t clusterID = H5Dopen2(m_file, path.c_str(), H5P_DEFAULT);
-	hid_t dspace = H5Dget_space(clusterID);
-	hid_t newType = H5Dget_type(clusterID);
+	auto result = std::make_shared<Snapshot>();
+	result->date = date;
 
-	hsize_t dims;
-	H5Sget_simple_extent_dims(dspace, &dims, nullptr);
+	std::string groupname = to_iso_string(date);
+	std::string name = groupname + "/Population";
+	if (H5Lexists(m_file, name.c_str(), H5P_DEFAULT) > 0) {
+		ReadPopulationCompound(name, *result);
+	} else if (
+	    H5Lexists(m_file, (groupname + "/Health").c_str(), H5P_DEFAULT) > 0 ||
+	    H5Lexists(m_file, (groupname + "/Delta").c_str(), H5P_DEFAULT) > 0) {
+		ReadPopulationColumns(date, *result);
+	} else {
+		FATAL_ERROR("Incorrect date loaded");
+	}
 
-	hsize_t start = 0;
+	// The delta layout only writes the journals when they change.
+	const std::string expatriates = FindLatest(date, "Expatriates");
+	if (!expatriates.empty()) {
+		hid_t newType = CreatePersonType();
+		result->expatriates = ReadColumn<h_personType>(m_file, expatriates, newType);
+		H5Tclose(newType);
+	}
+	const std::string visitors = FindLatest(date, "Visitors");
+	if (!visitors.empty()) {
+		hid_t newType = CreateVisitorType();
+		result->visitors = ReadColumn<h_visitorType>(m_file, visitors, newType);
+		H5Tclose(newType);
+	}
 
-	hsize_t count = 1;
+	// The clusters that the delta layout leaves out follow from the cluster ids of the persons.
+	std::array<std::vector<h_clusterType>, NumOfClusterTypes()> implied;
+	bool has_implied = false;
+	hid_t newType = CreateClusterType();
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		const std::string name = groupname + "/" + ToString(static_cast<ClusterType>(t));
+		if (H5Lexists(m_file, name.c_str(), H5P_DEFAULT) > 0) {
+			result->clusters[t] = ReadColumn<h_clusterType>(m_file, name, newType);
+			continue;
+		}
+		if (!has_implied) {
+			implied = ImpliedClusters(result->persons, result->expatriates);
+			has_implied = true;
+		}
+		result->clusters[t] = std::move(implied[t]);
+	}
+	H5Tclose(newType);
 
-	hid_t subspace = H5Dget_space(clusterID);
-	H5Sselect_hyperslab(subspace, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
-	h_clusterType data;
+	auto atlas_owner = std::make_shared<Population>();
+	LoadAtlas(*atlas_owner);
+	result->atlas_owner = atlas_owner;
 
-	H5Dread(clusterID, newType, H5S_ALL, subspace, H5P_DEFAULT, &data);
+	return result;
+}
 
-	H5Sclose(subspace);
+std::shared_ptr<Population> CheckPoint::RestorePopulation(const Snapshot& snapshot)
+{
+	// The persons are built in parallel, one block of records per task, and then added to the population.
+	const auto& persons = snapshot.persons;
+	const std::size_t block_size = 4096;
+	std::vector<std::vector<Person>> blocks((persons.size() + block_size - 1) / block_size);
+	const auto build_block = [&](std::vector<Person>& block, unsigned int) {
+		const std::size_t begin = (&block - blocks.data()) * block_size;
+		const std::size_t end = std::min(begin + block_size, persons.size());
+		block.reserve(end - begin);
+		for (std::size_t i = begin; i < end; i++) {
+			block.push_back(persons[i].ToPerson(static_cast<HealthStatus>(snapshot.status[i])));
+		}
+	};
+	util::parallel::parallel_for(blocks, util::parallel::get_number_of_threads(), build_block);
 
-	std::unique_ptr<Cluster> CurrentCluster = std::make_unique<Cluster>(data.ID, i);
+	auto result = std::make_shared<Population>();
+	for (const auto& block : blocks) {
+		for (const auto& person : block) {
+			result->emplace(person);
+		}
+	}
+	result->share_atlas(*snapshot.atlas_owner);
+	return result;
+}
 
-	for (hsize_t j = 1; j < dims; j++) {
-		hsize_t start = j;
-		hsize_t count = 1;
+void CheckPoint::RestoreSnapshot(const Snapshot& snapshot, Simulator& sim)
+{
+	RestoreState(snapshot, RestorePopulation(snapshot), sim);
+}
 
-		hid_t subspace = H5Screate_simple(1, &count, nullptr);
+std::shared_ptr<Simulator> CheckPoint::Fork(
+    const Snapshot& snapshot, const SingleSimulationConfig& config, unsigned int fork_index,
+    const std::shared_ptr<spdlog::logger>& log, unsigned int num_threads)
+{
+	// Every fork gets its own contact log, contact matrix and counters files, rather than truncating those of
+	// the other forks.
+	auto fork_config = config;
+	fork_config.log_config = std::make_shared<LogConfig>(*config.log_config);
+	fork_config.log_config->output_prefix += "_fork" + std::to_string(fork_index);
+
+	auto population = RestorePopulation(snapshot);
+	auto sim = SimulatorBuilder::Build(fork_config, population, log, num_threads, false);
+	RestoreState(snapshot, population, *sim);
+	return sim;
+}
 
-		H5Sselect_hyperslab(dspace, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
+void CheckPoint::RestoreState(
+    const Snapshot& snapshot, const std::shared_ptr<Population>& population, Simulator& sim)
+{
+	sim.SetPopulation(population);
 
-		h_clusterType data;
+	multiregion::ExpatriateJournal expatriates;
+	for (const auto& p : snapshot.expatriates) {
+		expatriates.AddExpatriate(p.ToPerson());
+	}
+	sim.SetExpatriates(expatriates);
 
-		H5Dread(clusterID, newType, subspace, dspace, H5P_DEFAULT, &data);
+	multiregion::VisitorJournal visitors;
+	for (const auto& v : snapshot.visitors) {
+		multiregion::VisitorId id;
+		id.home_id = v.PersonIDHome;
+		id.visitor_id = v.PersonIDVisitor;
+		visitors.AddVisitor(id, v.RegionID, v.DaysLeft);
+	}
+	sim.SetVisitors(visitors);
+
+	// restoring clusters, looking up their members by id
+	std::vector<Person> persons;
+	persons.reserve(population->size());
+	population->serial_for([&persons](const Person& p, unsigned int) { persons.push_back(p); });
+	std::sort(
+	    persons.begin(), persons.end(), [](const Person& a, const Person& b) { return a.GetId() < b.GetId(); });
+	ClusterStruct& clusters = sim.GetClusters();
+	std::vector<Cluster>* cluster_vectors[] = {
+	    &clusters.m_households, &clusters.m_school_clusters, &clusters.m_work_clusters,
+	    &clusters.m_primary_community, &clusters.m_secondary_community};
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		*cluster_vectors[t] = BuildClusters(snapshot.clusters[t], static_cast<ClusterType>(t), persons);
+	}
+}
 
-		H5Sclose(subspace);
+void CheckPoint::LoadCheckPoint(boost::gregorian::date date, Simulator& sim)
+{
+	RestoreSnapshot(*LoadSnapshot(date), sim);
+}
 
-		if (data.ID != CurrentCluster->GetId()) {
-			clusters.emplace_back(*CurrentCluster);
-			CurrentCluster = std::make_unique<Cluster>(data.ID, i);
+std::vector<Cluster> CheckPoint::BuildClusters(
+    const std::vector<h_clusterType>& records, ClusterType type, const std::vector<Person>& persons)
+{
+	// Every cluster is a header record (person id 0), followed by a record per member.
+	std::vector<Cluster> result;
+	const auto by_id = [](const Person& p, unsigned int id) { return p.GetId() < id; };
+	for (const auto& record : records) {
+		if (result.empty() || record.ID != result.back().GetId()) {
+			result.emplace_back(record.ID, type);
 			continue;
 		}
+		// Members that are abroad aren't in the population.
+		auto it = std::lower_bound(persons.begin(), persons.end(), record.PersonID, by_id);
+		if (it != persons.end() && it->GetId() == record.PersonID) {
+			result.back().AddPerson(*it);
+		}
+	}
+	return result;
+}
 
-		unsigned int idPersonToAdd = data.PersonID;
+std::array<std::vector<CheckPoint::h_clusterType>, NumOfClusterTypes()> CheckPoint::ImpliedClusters(
+    const std::vector<h_personType>& persons, const std::vector<h_personType>& expatriates)
+{
+	unsigned int h_personType::*const columns[] = {&h_personType::Household, &h_personType::School,
+							&h_personType::Work, &h_personType::Primary,
+							&h_personType::Secondary};
+
+	// Every type has a cluster for every index up to the largest one, and the clusters of all types are numbered
+	// from 1 on. Index 0 means that a person isn't in a cluster of the type.
+	std::array<std::vector<h_clusterType>, NumOfClusterTypes()> result;
+	unsigned int cluster_id = 1;
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		const auto column = columns[t];
+		unsigned int max_index = 0;
+		for (const auto& p : persons) {
+			max_index = std::max(max_index, p.*column);
+		}
+		for (const auto& p : expatriates) {
+			max_index = std::max(max_index, p.*column);
+		}
 
-		result.serial_for([this, &idPersonToAdd, &CurrentCluster](const Person& p, unsigned int) {
-			if (p.GetId() == idPersonToAdd) {
-				CurrentCluster->AddPerson(p);
+		std::vector<std::vector<unsigned int>> members(max_index + 1);
+		for (const auto& p : persons) {
+			if (p.*column > 0) {
+				members[p.*column].push_back(p.ID);
 			}
-		});
+		}
+
+		auto& records = result[t];
+		records.reserve(persons.size() + members.size());
+		for (auto& ids : members) {
+			std::sort(ids.begin(), ids.end());
+			records.push_back({cluster_id, 0});
+			for (const auto id : ids) {
+				records.push_back({cluster_id, id});
+			}
+			cluster_id++;
+		}
 	}
+	return result;
+}
 
-	clusters.emplace_back(*CurrentCluster);
-	H5Tclose(newType);
-	H5Dclose(clusterID);
-	H5Sclose(dspace);
+bool CheckPoint::SameClusters(const std::vector<h_clusterType>& records, const std::vector<h_clusterType>& implied)
+{
+	if (records.size() != implied.size()) {
+		return false;
+	}
+	// The implied records are sorted by cluster and then by person, with the header record first.
+	const auto order = [](const h_clusterType& a, const h_clusterType& b) {
+		return a.ID != b.ID ? a.ID < b.ID : a.PersonID < b.PersonID;
+	};
+	auto sorted = records;
+	std::sort(sorted.begin(), sorted.end(), order);
+	const auto same = [](const h_clusterType& a, const h_clusterType& b) {
+		return a.ID == b.ID && a.PersonID == b.PersonID;
+	};
+	return std::equal(sorted.begin(), sorted.end(), implied.begin(), same);
 }
 
 SingleSimulationConfig CheckPoint::LoadSingleConfig()
@@ -639,10 +1248,10 @@ Calendar CheckPoint::LoadCalendar(boost::gregorian::date date)
 	return result;
 }
 
-void CheckPoint::WriteClusters(const ClusterStruct& clusters, boost::gregorian::date date)
+void CheckPoint::WriteClusters(const Snapshot& snapshot)
 {
 
-	std::string datestr = to_iso_string(date);
+	std::string datestr = to_iso_string(snapshot.date);
 	htri_t exist = H5Lexists(m_file, datestr.c_str(), H5P_DEFAULT);
 	if (exist <= 0) {
 		hid_t temp = H5Gcreate2(m_file, datestr.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -650,70 +1259,53 @@ void CheckPoint::WriteClusters(const ClusterStruct& clusters, boost::gregorian::
 	}
 	hid_t group = H5Gopen2(m_file, datestr.c_str(), H5P_DEFAULT);
 
-	WriteCluster(clusters.m_households, group, ClusterType::Household);
-	WriteCluster(clusters.m_school_clusters, group, ClusterType::School);
-	WriteCluster(clusters.m_work_clusters, group, ClusterType::Work);
-	WriteCluster(clusters.m_primary_community, group, ClusterType::PrimaryCommunity);
-	WriteCluster(clusters.m_secondary_community, group, ClusterType::SecondaryCommunity);
+	std::array<std::vector<h_clusterType>, NumOfClusterTypes()> implied;
+	if (m_layout == CheckPointLayout::Delta) {
+		implied = ImpliedClusters(snapshot.persons, snapshot.expatriates);
+	}
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		if (m_layout == CheckPointLayout::Delta && SameClusters(snapshot.clusters[t], implied[t])) {
+			continue;
+		}
+		WriteCluster(snapshot.clusters[t], group, static_cast<ClusterType>(t));
+	}
 
 	H5Gclose(group);
 }
 
-void CheckPoint::WriteCluster(const std::vector<Cluster>& clvector, hid_t& group, const ClusterType& t)
+void CheckPoint::WriteCluster(const std::vector<h_clusterType>& data, hid_t& group, const ClusterType& t)
 {
 	std::string dsetname = ToString(t);
 
-	unsigned int totalSize = 0;
-	std::vector<unsigned int> sizes;
-
-	for (auto& cluster : clvector) {
-		totalSize += cluster.GetSize() + 1;
-		sizes.push_back(cluster.GetSize());
-	}
-	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_clusterType));
-
-	H5Tinsert(newType, "ID", HOFFSET(h_clusterType, ID), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "PersonID", HOFFSET(h_clusterType, PersonID), H5T_NATIVE_UINT);
+	hid_t newType = CreateClusterType();
 
-	hsize_t dims = totalSize;
+	hsize_t dims = data.size();
 	hid_t dataspace = H5Screate_simple(1, &dims, nullptr);
 
 	hid_t dataset = H5Dcreate2(group, dsetname.c_str(), newType, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	unsigned int spot = 0;
-	for (auto& cluster : clvector) {
-		auto people = cluster.GetPeople();
-
-		std::vector<h_clusterType> data{cluster.GetSize() + 1};
-
-		// Start of new cluster
-		data[0].ID = cluster.GetId();
-		data[0].PersonID = 0;
-		// Data in cluster
-		for (unsigned int i = 1; i <= people.size(); i++) {
-			data[i].ID = cluster.GetId();
-			data[i].PersonID = people[i - 1].GetId();
-		}
-
-		hsize_t start = spot;
-		hsize_t count = cluster.GetSize() + 1;
-		hid_t chunkspace = H5Screate_simple(1, &count, nullptr);
-		H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, &start, nullptr, &count, nullptr);
-
-		hid_t plist = H5Pcreate(H5P_DATASET_XFER);
+	H5Dwrite(dataset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
 
-		H5Dwrite(dataset, newType, chunkspace, dataspace, plist, data.data());
-		spot += cluster.GetSize() + 1;
-		H5Sclose(chunkspace);
-		H5Pclose(plist);
-	}
 	H5Tclose(newType);
 	H5Sclose(dataspace);
 	H5Dclose(dataset);
 }
 
-void CheckPoint::WriteExpatriates(multiregion::ExpatriateJournal& journal, boost::gregorian::date date)
+void CheckPoint::WriteExpatriates(const Snapshot& snapshot)
 {
-	std::string datestr = to_iso_string(date);
+	// Expatriates don't change while they are abroad, so their ids tell whether the journal changed.
+	if (m_layout == CheckPointLayout::Delta) {
+		std::vector<unsigned int> ids;
+		ids.reserve(snapshot.expatriates.size());
+		for (const auto& p : snapshot.expatriates) {
+			ids.push_back(p.ID);
+		}
+		if (m_has_last_journals && ids == m_last_expatriates) {
+			return;
+		}
+		m_last_expatriates = std::move(ids);
+	}
+
+	std::string datestr = to_iso_string(snapshot.date);
 	htri_t exist = H5Lexists(m_file, datestr.c_str(), H5P_DEFAULT);
 	if (exist <= 0) {
 		hid_t temp = H5Gcreate2(m_file, datestr.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -723,46 +1315,36 @@ void CheckPoint::WriteExpatriates(multiregion::ExpatriateJournal& journal, boost
 
 	std::string dsetname = "Expatriates";
 
-	std::vector<h_personType> data;
-
-	journal.SerialForeach([&data](const Person& p, unsigned int) {
-		h_personType tempPerson(p);
-		data.push_back(tempPerson);
-	});
+	hid_t newType = CreatePersonType();
 
-	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_personType));
-
-	H5Tinsert(newType, "ID", HOFFSET(h_personType, ID), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Age", HOFFSET(h_personType, Age), H5T_NATIVE_DOUBLE);
-	H5Tinsert(newType, "Gender", HOFFSET(h_personType, Gender), H5T_NATIVE_CHAR);
-	H5Tinsert(newType, "Participating", HOFFSET(h_personType, Participating), H5T_NATIVE_HBOOL);
-	H5Tinsert(newType, "Immune", HOFFSET(h_personType, Immune), H5T_NATIVE_HBOOL);
-	H5Tinsert(newType, "Infected", HOFFSET(h_personType, Infected), H5T_NATIVE_HBOOL);
-	H5Tinsert(newType, "StartInf", HOFFSET(h_personType, StartInf), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "EndInf", HOFFSET(h_personType, EndInf), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "StartSympt", HOFFSET(h_personType, StartSympt), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "EndSympt", HOFFSET(h_personType, EndSympt), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "TimeInfected", HOFFSET(h_personType, TimeInfected), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Household", HOFFSET(h_personType, Household), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "School", HOFFSET(h_personType, School), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Work", HOFFSET(h_personType, Work), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Primary", HOFFSET(h_personType, Primary), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "Secondary", HOFFSET(h_personType, Secondary), H5T_NATIVE_UINT);
-
-	hsize_t dims = data.size();
+	hsize_t dims = snapshot.expatriates.size();
 	hid_t dataspace = H5Screate_simple(1, &dims, nullptr);
 
 	hid_t dataset = H5Dcreate2(group, dsetname.c_str(), newType, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	H5Dwrite(dataset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
+	H5Dwrite(dataset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, snapshot.expatriates.data());
 
+	H5Tclose(newType);
 	H5Sclose(dataspace);
 	H5Dclose(dataset);
 	H5Gclose(group);
 }
 
-void CheckPoint::WriteVisitors(multiregion::VisitorJournal& journal, boost::gregorian::date date, std::size_t day)
+void CheckPoint::WriteVisitors(const Snapshot& snapshot)
 {
-	std::string datestr = to_iso_string(date);
+	if (m_layout == CheckPointLayout::Delta) {
+		const auto same = [](const h_visitorType& a, const h_visitorType& b) {
+			return a.DaysLeft == b.DaysLeft && a.RegionID == b.RegionID &&
+			       a.PersonIDHome == b.PersonIDHome && a.PersonIDVisitor == b.PersonIDVisitor;
+		};
+		const auto& visitors = snapshot.visitors;
+		if (m_has_last_journals && visitors.size() == m_last_visitors.size() &&
+		    std::equal(visitors.begin(), visitors.end(), m_last_visitors.begin(), same)) {
+			return;
+		}
+		m_last_visitors = visitors;
+	}
+
+	std::string datestr = to_iso_string(snapshot.date);
 	htri_t exist = H5Lexists(m_file, datestr.c_str(), H5P_DEFAULT);
 	if (exist <= 0) {
 		hid_t temp = H5Gcreate2(m_file, datestr.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
@@ -772,33 +1354,13 @@ void CheckPoint::WriteVisitors(multiregion::VisitorJournal& journal, boost::greg
 
 	std::string dsetname = "Visitors";
 
-	std::vector<h_visitorType> data(journal.GetVisitorCount());
+	hid_t newType = CreateVisitorType();
 
-	for (auto& days : journal.GetVisitors()) {
-		for (auto& place : days.second) {
-			for (auto p : place.second) {
-				h_visitorType i;
-				i.DaysLeft = days.first - day;
-				i.RegionID = place.first;
-				i.PersonIDHome = p.home_id;
-				i.PersonIDVisitor = p.visitor_id;
-				data.push_back(i);
-			}
-		}
-	}
-
-	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_visitorType));
-
-	H5Tinsert(newType, "DaysLeft", HOFFSET(h_visitorType, DaysLeft), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "RegionID", HOFFSET(h_visitorType, RegionID), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "PersonIDHome", HOFFSET(h_visitorType, PersonIDHome), H5T_NATIVE_UINT);
-	H5Tinsert(newType, "PersonIDVisitor", HOFFSET(h_visitorType, PersonIDVisitor), H5T_NATIVE_UINT);
-
-	hsize_t dims = data.size();
+	hsize_t dims = snapshot.visitors.size();
 	hid_t dataspace = H5Screate_simple(1, &dims, nullptr);
 
 	hid_t dataset = H5Dcreate2(group, dsetname.c_str(), newType, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
-	H5Dwrite(dataset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
+	H5Dwrite(dataset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, snapshot.visitors.data());
 
 	H5Tclose(newType);
 	H5Sclose(dataspace);
@@ -806,95 +1368,6 @@ void CheckPoint::WriteVisitors(multiregion::VisitorJournal& journal, boost::greg
 	H5Gclose(group);
 }
 
-multiregion::ExpatriateJournal CheckPoint::LoadExpatriates(const Population& pop, boost::gregorian::date date)
-{
-	multiregion::ExpatriateJournal result;
-	std::string dsetName = to_iso_string(date) + "/Expatriates";
-	htri_t exist = H5Lexists(m_file, dsetName.c_str(), H5P_DEFAULT);
-	if (exist <= 0) {
-		return result;
-	}
-	hid_t dset = H5Dopen2(m_file, dsetName.c_str(), H5P_DEFAULT);
-
-	hid_t dspace = H5Dget_space(dset);
-
-	hsize_t dims;
-	H5Sget_simple_extent_dims(dspace, &dims, nullptr);
-
-	hid_t newType = H5Dget_type(dset);
-
-	std::vector<h_personType> data(dims);
-
-	H5Dread(dset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
-
-	H5Sclose(dspace);
-	H5Dclose(dset);
-	H5Tclose(newType);
-
-	for (auto& p : data) {
-
-		disease::Fate disease;
-		disease.start_infectiousness = p.StartInf;
-		disease.start_symptomatic = p.StartSympt;
-		disease.end_infectiousness = p.EndInf;
-		disease.end_symptomatic = p.EndSympt;
-
-		Person toAdd(p.ID, p.Age, p.Household, p.School, p.Work, p.Primary, p.Secondary, disease);
-
-		if (p.Participating) {
-			toAdd.ParticipateInSurvey();
-		}
-
-		if (p.Immune) {
-			toAdd.GetHealth().SetImmune();
-		}
-		if (p.Infected) {
-			toAdd.GetHealth().StartInfection();
-		}
-		for (unsigned int i = 0; i < p.TimeInfected; i++) {
-			toAdd.GetHealth().Update();
-		}
-		result.AddExpatriate(toAdd);
-	}
-	return result;
-}
-
-multiregion::VisitorJournal CheckPoint::LoadVisitors(boost::gregorian::date date)
-{
-	multiregion::VisitorJournal result;
-	std::string dsetName = to_iso_string(date) + "/Visitors";
-	htri_t exist = H5Lexists(m_file, dsetName.c_str(), H5P_DEFAULT);
-	if (exist <= 0) {
-		return result;
-	}
-	hid_t dset = H5Dopen2(m_file, dsetName.c_str(), H5P_DEFAULT);
-
-	hid_t dspace = H5Dget_space(dset);
-
-	hsize_t dims;
-	H5Sget_simple_extent_dims(dspace, &dims, nullptr);
-
-	hid_t newType = H5Dget_type(dset);
-
-	std::vector<h_visitorType> data(dims);
-
-	H5Dread(dset, newType, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data());
-
-	H5Sclose(dspace);
-	H5Dclose(dset);
-	H5Tclose(newType);
-
-	for (auto& p : data) {
-		multiregion::VisitorId id;
-		id.home_id = p.PersonIDHome;
-		id.visitor_id = p.PersonIDVisitor;
-
-		result.AddVisitor(id, p.RegionID, p.DaysLeft);
-	}
-
-	return result;
-}
-
 void CheckPoint::WriteAtlas(const Atlas& atlas)
 {
 	htri_t exist = H5Lexists(m_file, "Config", H5P_DEFAULT);
@@ -904,16 +1377,16 @@ void CheckPoint::WriteAtlas(const Atlas& atlas)
 	}
 
 	std::vector<h_clusterAtlas> data;
-	for (auto& i : atlas.cluster_map) {
+	atlas.ForEachCluster([&data](const Atlas::ClusterKey& key, const geo::GeoPosition& pos) {
 		h_clusterAtlas info;
-		info.ClusterID = i.first.first;
-		info.ClusterType = (unsigned int)i.first.second;
+		info.ClusterID = key.first;
+		info.ClusterType = (unsigned int)key.second;
 
-		info.latitude = i.second.latitude;
-		info.longitude = i.second.longitude;
+		info.latitude = pos.latitude;
+		info.longitude = pos.longitude;
 
 		data.push_back(info);
-	}
+	});
 
 	hid_t newType = H5Tcreate(H5T_COMPOUND, sizeof(h_clusterAtlas));
 
@@ -966,18 +1439,15 @@ void CheckPoint::LoadAtlas(Population& pop)
 	}
 }
 
-boost::gregorian::date CheckPoint::GetLastDate()
+std::vector<boost::gregorian::date> CheckPoint::GetDates()
 {
-	boost::gregorian::date result;
+	std::vector<boost::gregorian::date> result;
 
 	auto op_func = [&result](hid_t loc_id, const char* name, const H5L_info_t* info, void* operator_data) {
 		if (std::string(name) == "Config") {
 			return 0;
 		}
-		boost::gregorian::date toCheck(boost::gregorian::from_undelimited_string(name));
-		if (toCheck > result or result.is_not_a_date()) {
-			result = toCheck;
-		}
+		result.push_back(boost::gregorian::from_undelimited_string(name));
 		return 0;
 	};
 	auto temp = [](hid_t loc_id, const char* name, const H5L_info_t* info, void* operator_data) {
@@ -986,8 +1456,28 @@ boost::gregorian::date CheckPoint::GetLastDate()
 	};
 
 	H5Literate(m_file, H5_INDEX_NAME, H5_ITER_NATIVE, nullptr, temp, &op_func);
+	std::sort(result.begin(), result.end());
 	return result;
 }
 
+std::string CheckPoint::FindLatest(boost::gregorian::date date, const std::string& name)
+{
+	auto dates = GetDates();
+	dates.erase(std::upper_bound(dates.begin(), dates.end(), date), dates.end());
+	for (auto it = dates.rbegin(); it != dates.rend(); ++it) {
+		const std::string path = to_iso_string(*it) + "/" + name;
+		if (H5Lexists(m_file, path.c_str(), H5P_DEFAULT) > 0) {
+			return path;
+		}
+	}
+	return std::string();
+}
+
+boost::gregorian::date CheckPoint::GetLastDate()
+{
+	const auto dates = GetDates();
+	return dates.empty() ? boost::gregorian::date() : dates.back();
+}
+
 } /* namespace checkpoint */
 } /* namespace stride */
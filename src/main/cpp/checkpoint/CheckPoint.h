@@ -1,10 +1,12 @@
 #ifndef CHECKPOINT_H_INCLUDED
 #define CHECKPOINT_H_INCLUDED
 
+#include <array>
 #include <memory>
 #include <vector>
 #include <hdf5.h>
 #include "calendar/Calendar.h"
+#include "checkpoint/CheckPointLayout.h"
 #include "core/Cluster.h"
 #include "pop/Population.h"
 #include "sim/SimulationConfig.h"
@@ -16,14 +18,19 @@ namespace checkpoint {
 class CheckPoint
 {
 public:
-	/// Constructor The string is the file for the checkpoints.
-	CheckPoint(const std::string& filename);
+	/// Constructor The string is the file for the checkpoints. Large datasets are written in chunks of
+	/// `chunk_size` records, deflated with the given level (0 disables compression). The layout determines how
+	/// the population is stored: see WritePopulation and WritePopulationColumns.
+	CheckPoint(
+	    const std::string& filename, unsigned int chunk_size = 65536, unsigned int compression = 0,
+	    CheckPointLayout layout = CheckPointLayout::Compound);
 
 	/// Creates the wanted file and immediately closes it. It will overwrite a file if one of the same name already
 	/// exists.
 	void CreateFile();
 
-	/// Opens the wanted file. This is necessary for any of the following functions.
+	/// Opens the wanted file. This is necessary for any of the following functions. The caches of the delta
+	/// layout outlive the file being closed and reopened, so a CheckPoint must be the only writer of its file.
 	void OpenFile();
 
 	/// Closes the wanted file. This is necessary for any of the following functions.
@@ -41,6 +48,34 @@ public:
 	/// Saves the current simulation to a checkpoint with the date as Identifier.
 	void SaveCheckPoint(const Simulator& simulation, std::size_t day);
 
+	/// A copy of everything SaveCheckPoint writes, detached from the simulator.
+	struct Snapshot;
+
+	/// Copies the simulator's state into a snapshot, which can be written later (and from another thread)
+	/// while the simulation goes on. Fails for a simulator with a commuting model.
+	static std::shared_ptr<const Snapshot> TakeSnapshot(const Simulator& simulation, std::size_t day);
+
+	/// Writes a snapshot to a checkpoint with the snapshot's date as Identifier.
+	void WriteSnapshot(const Snapshot& snapshot);
+
+	/// Reads the checkpoint of the given date into a snapshot. A snapshot can be restored any number of times,
+	/// without going back to the file.
+	std::shared_ptr<const Snapshot> LoadSnapshot(boost::gregorian::date date);
+
+	/// Builds a population with the persons of a snapshot, which shares the snapshot's atlas.
+	static std::shared_ptr<Population> RestorePopulation(const Snapshot& snapshot);
+
+	/// Loads a snapshot into a Simulator, like LoadCheckPoint. It will not load the configuration.
+	static void RestoreSnapshot(const Snapshot& snapshot, Simulator& sim);
+
+	/// Builds a new simulator that continues from a snapshot with the given configuration, e.g. with another
+	/// seed or r0. The configuration's calendar should start at the snapshot's date. Every fork owns its
+	/// population, so forks of the same snapshot can run side by side. The files that the simulator writes
+	/// itself get the output prefix followed by "_fork" and the given index, which tells the forks apart.
+	static std::shared_ptr<Simulator> Fork(
+	    const Snapshot& snapshot, const SingleSimulationConfig& config, unsigned int fork_index,
+	    const std::shared_ptr<spdlog::logger>& log, unsigned int num_threads = 1U);
+
 	/// Copies the info in the filename under the data of the given simulation
 	void CombineCheckPoint(unsigned int simulation, const std::string& filename);
 
@@ -60,32 +95,94 @@ public:
 	boost::gregorian::date GetLastDate();
 
 private:
-	/// Writes the current population to a checkpoint.
-	void WritePopulation(const Population&, boost::gregorian::date);
+	struct h_personType;
+	struct h_clusterType;
+	struct h_visitorType;
+	struct h_clusterAtlas;
+
+	/// The health of a set of persons, as parallel columns sorted by id.
+	struct HealthColumns
+	{
+		std::vector<unsigned int> ids;
+		std::vector<unsigned char> status;
+		std::vector<unsigned int> days_infected;
+	};
+
+	/// Writes the snapshot's population to a checkpoint.
+	void WritePopulation(const Snapshot&);
+
+	/// Writes the current population as one dataset per attribute. Attributes that never change (age,
+	/// cluster ids, disease fate, ...) are written once to Config/Population; the health status and
+	/// days infected are written to the date's Health group. In the delta layout, only the first date
+	/// written gets a Health group; later dates get a Delta group with the persons whose health changed
+	/// since the previous date, and the ids of the persons that left. Persons that are missing from the
+	/// static columns (visitors) are written as compound records to the date's Newcomers dataset.
+	void WritePopulationColumns(const Snapshot&);
+
+	/// Writes the static population columns, unless the file already has them.
+	void WriteStaticColumns(const Snapshot&);
+
+	/// The ids in the static population columns.
+	const std::vector<unsigned int>& GetStaticIds();
+
+	/// Writes health columns to a new group.
+	void WriteHealth(const std::string& groupname, const HealthColumns&);
+
+	/// Reads health columns from a group.
+	HealthColumns ReadHealth(const std::string& groupname);
+
+	/// Restores the health columns of a date, from its Health group or by replaying the Delta groups
+	/// since the last date with a Health group.
+	HealthColumns ReplayHealth(boost::gregorian::date);
+
+	/// Applies a date's Delta group to health columns.
+	static HealthColumns ApplyDelta(
+	    const HealthColumns& health, const HealthColumns& changes, const std::vector<unsigned int>& removed);
+
+	/// Reads a population written as a compound dataset with the given name into a snapshot.
+	void ReadPopulationCompound(const std::string& name, Snapshot&);
+
+	/// Reads a population written by WritePopulationColumns into a snapshot.
+	void ReadPopulationColumns(boost::gregorian::date, Snapshot&);
+
+	/// Gives a simulator the population, journals and clusters of a snapshot.
+	static void RestoreState(const Snapshot&, const std::shared_ptr<Population>&, Simulator&);
+
+	/// All dates in the file, in chronological order.
+	std::vector<boost::gregorian::date> GetDates();
 
 	/// Writes the Atlas
 	void WriteAtlas(const Atlas&);
 
-	/// Writes the clusters to a checkpoint.
-	void WriteClusters(const ClusterStruct&, boost::gregorian::date);
+	/// Writes the snapshot's clusters to a checkpoint. The delta layout leaves out the clusters of a type if
+	/// they follow from the cluster ids of the persons; LoadSnapshot rebuilds those with ImpliedClusters.
+	void WriteClusters(const Snapshot&);
+
+	/// Writes the snapshot's visitors to a checkpoint. The delta layout only writes them when they change.
+	void WriteVisitors(const Snapshot&);
 
-	/// Writes the visitors to a checkpoint.
-	void WriteVisitors(multiregion::VisitorJournal&, boost::gregorian::date, std::size_t day);
+	/// Writes the snapshot's expatriates to a checkpoint. The delta layout only writes them when they change.
+	void WriteExpatriates(const Snapshot&);
 
-	/// Writes the expatriates to a checkpoint.
-	void WriteExpatriates(multiregion::ExpatriateJournal&, boost::gregorian::date);
+	/// The path of the dataset with the given name of the last date up to the given one that has it, or an empty
+	/// string if there is none.
+	std::string FindLatest(boost::gregorian::date, const std::string& name);
 
-	/// Loads one type Cluster
-	void WriteCluster(const std::vector<Cluster>&, hid_t&, const ClusterType&);
+	/// Writes one type Cluster
+	void WriteCluster(const std::vector<h_clusterType>&, hid_t&, const ClusterType&);
 
-	/// Loads one type Cluster
-	void LoadCluster(std::vector<Cluster>&, const ClusterType&, const std::string& groupname, const Population&);
+	/// Builds the clusters of one type from the records written by WriteCluster. The persons are sorted by id.
+	static std::vector<Cluster> BuildClusters(
+	    const std::vector<h_clusterType>&, ClusterType, const std::vector<Person>& persons);
 
-	/// Loads the Expatriate journal
-	multiregion::ExpatriateJournal LoadExpatriates(const Population&, boost::gregorian::date);
+	/// The cluster records of the clusters that SimulatorBuilder::InitializeClusters builds for the persons,
+	/// with their members in id order. The expatriates only count for the number of clusters.
+	static std::array<std::vector<h_clusterType>, NumOfClusterTypes()> ImpliedClusters(
+	    const std::vector<h_personType>& persons, const std::vector<h_personType>& expatriates);
 
-	/// Loads the Visitor journal
-	multiregion::VisitorJournal LoadVisitors(boost::gregorian::date);
+	/// Whether cluster records hold the same clusters as the records of ImpliedClusters, regardless of the
+	/// order of their members.
+	static bool SameClusters(const std::vector<h_clusterType>& records, const std::vector<h_clusterType>& implied);
 
 	/// Loads the Atlas directly into the population
 	void LoadAtlas(Population&);
@@ -98,13 +195,35 @@ private:
 	/// name of the dataset
 	std::string WriteDSetFile(const std::string&, const std::string&);
 
-	hid_t m_file;		      //< current hdf5 workspace
-	const std::string m_filename; //< filename
+	/// Creates the memory type of h_personType.
+	static hid_t CreatePersonType();
+
+	/// Creates the memory type of h_clusterType.
+	static hid_t CreateClusterType();
+
+	/// Creates the memory type of h_visitorType.
+	static hid_t CreateVisitorType();
+
+	/// Forgets the static ids, the health and the journals that were cached for the file.
+	void ResetCaches();
+
+	/// Creates the dataset creation properties for a chunked (and possibly compressed) dataset of the given size.
+	hid_t CreateChunkedProperties(hsize_t size) const;
+
+	hid_t m_file;		       //< current hdf5 workspace
+	const std::string m_filename;  //< filename
+	const hsize_t m_chunk_size;    //< number of records per chunk
+	const unsigned int m_compression; //< deflate level, 0 if uncompressed
+	const CheckPointLayout m_layout;  //< how populations are written
+	std::vector<unsigned int> m_static_ids; //< cache of the static population column ids
+	HealthColumns m_last_health;		//< health at the last date written in the delta layout
+	bool m_has_last_health;			//< whether m_last_health is known
 
 	struct h_personType
 	{
 		// basic info
 		unsigned int ID;
+		unsigned int OriginalID;
 		double Age;
 		char Gender;
 		hbool_t Participating;
@@ -125,6 +244,7 @@ private:
 		h_personType(const Person& p)
 		{
 			ID = p.GetId();
+			OriginalID = p.GetOriginalId();
 			Age = p.GetAge();
 			Gender = p.GetGender();
 			Participating = p.IsParticipatingInSurvey();
@@ -143,6 +263,15 @@ private:
 			Secondary = p.GetClusterId(ClusterType::SecondaryCommunity);
 		}
 		h_personType() {}
+
+		/// The health status of the person described by this record.
+		HealthStatus GetStatus() const;
+
+		/// Restores the person described by this record, with the given health status.
+		Person ToPerson(HealthStatus status) const;
+
+		/// Restores the person described by this record.
+		Person ToPerson() const { return ToPerson(GetStatus()); }
 	};
 
 	struct h_clusterType
@@ -166,6 +295,35 @@ private:
 		double latitude;
 		double longitude;
 	};
+
+	std::vector<unsigned int> m_last_expatriates; //< ids of the expatriates last written in the delta layout
+	std::vector<h_visitorType> m_last_visitors;   //< visitors last written in the delta layout
+	bool m_has_last_journals;		      //< whether the last expatriates and visitors are known
+};
+
+struct CheckPoint::Snapshot
+{
+	/// The date of the snapshot.
+	boost::gregorian::date date;
+
+	/// The population's persons, in id order.
+	std::vector<h_personType> persons;
+
+	/// The health status of each of the persons.
+	std::vector<unsigned char> status;
+
+	/// The cluster records of every ClusterType, as laid out by WriteCluster.
+	std::array<std::vector<h_clusterType>, NumOfClusterTypes()> clusters;
+
+	/// The persons that are abroad.
+	std::vector<h_personType> expatriates;
+
+	/// The visitors that are in the region.
+	std::vector<h_visitorType> visitors;
+
+	/// The population whose atlas is written: the atlas doesn't change during a simulation. Snapshots that
+	/// are read from a file get a population with only the atlas.
+	PopulationRef atlas_owner;
 };
 
 } /* namespace checkpoint */
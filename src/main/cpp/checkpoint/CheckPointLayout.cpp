@@ -0,0 +1,42 @@
+#include "CheckPointLayout.h"
+
+#include <map>
+#include <string>
+#include <boost/algorithm/string.hpp>
+
+namespace {
+
+using stride::checkpoint::CheckPointLayout;
+using boost::to_upper;
+using namespace std;
+
+map<CheckPointLayout, string> g_layout_name{
+    make_pair(CheckPointLayout::Compound, "Compound"), make_pair(CheckPointLayout::Columnar, "Columnar"),
+    make_pair(CheckPointLayout::Delta, "Delta"), make_pair(CheckPointLayout::Null, "Null")};
+
+map<string, CheckPointLayout> g_name_layout{
+    make_pair("COMPOUND", CheckPointLayout::Compound), make_pair("COLUMNAR", CheckPointLayout::Columnar),
+    make_pair("DELTA", CheckPointLayout::Delta), make_pair("NULL", CheckPointLayout::Null)};
+}
+
+namespace stride {
+namespace checkpoint {
+
+string ToString(CheckPointLayout l) { return (g_layout_name.count(l) == 1) ? g_layout_name[l] : "Null"; }
+
+bool IsCheckPointLayout(const string& s)
+{
+	std::string t{s};
+	to_upper(t);
+	return (g_name_layout.count(t) == 1);
+}
+
+CheckPointLayout ToCheckPointLayout(const string& s)
+{
+	std::string t{s};
+	to_upper(t);
+	return (g_name_layout.count(t) == 1) ? g_name_layout[t] : CheckPointLayout::Null;
+}
+
+} // namespace checkpoint
+} // namespace stride
@@ -0,0 +1,35 @@
+#ifndef CHECKPOINTLAYOUT_H_INCLUDED
+#define CHECKPOINTLAYOUT_H_INCLUDED
+
+#include <string>
+
+namespace stride {
+namespace checkpoint {
+
+/**
+* Enum specifying how a checkpoint stores the population:
+* \li one compound record per person and date
+* \li one dataset per attribute, with the health columns repeated per date
+* \li one dataset per attribute, with only the changed health, journals and cluster memberships per date.
+*/
+enum class CheckPointLayout
+{
+	Compound = 0U,
+	Columnar = 1U,
+	Delta = 2U,
+	Null
+};
+
+/// Converts a CheckPointLayout value to corresponding name.
+std::string ToString(CheckPointLayout l);
+
+/// Check whether string is name of CheckPointLayout value.
+bool IsCheckPointLayout(const std::string& s);
+
+/// Converts a string with name to CheckPointLayout value.
+CheckPointLayout ToCheckPointLayout(const std::string& s);
+
+} // namespace checkpoint
+} // namespace stride
+
+#endif // include-guard
@@ -0,0 +1,85 @@
+#include "CheckPointWriter.h"
+
+#include "util/Trace.h"
+
+#include <algorithm>
+
+namespace stride {
+namespace checkpoint {
+
+CheckPointWriter::CheckPointWriter(const std::shared_ptr<CheckPoint>& checkpoint, std::size_t capacity)
+    : m_checkpoint(checkpoint), m_capacity(std::max<std::size_t>(capacity, 1)), m_busy(false), m_stop(false),
+      m_thread(&CheckPointWriter::Run, this)
+{
+}
+
+CheckPointWriter::~CheckPointWriter()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+		m_stop = true;
+	}
+	m_changed.notify_all();
+	m_thread.join();
+}
+
+void CheckPointWriter::Enqueue(const std::shared_ptr<const CheckPoint::Snapshot>& snapshot)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this] { return m_queue.size() < m_capacity; });
+		m_queue.push_back(snapshot);
+	}
+	m_changed.notify_all();
+}
+
+void CheckPointWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_changed.wait(lock, [this] { return m_queue.empty() && !m_busy; });
+	if (m_error) {
+		auto error = m_error;
+		m_error = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void CheckPointWriter::Run()
+{
+	while (true) {
+		std::shared_ptr<const CheckPoint::Snapshot> snapshot;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_changed.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty()) {
+				return;
+			}
+			snapshot = m_queue.front();
+			m_queue.pop_front();
+			m_busy = true;
+		}
+		m_changed.notify_all();
+
+		try {
+			util::TraceSpan span("WriteSnapshot", "checkpoint");
+			m_checkpoint->OpenFile();
+			m_checkpoint->WriteSnapshot(*snapshot);
+			m_checkpoint->CloseFile();
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_error) {
+				m_error = std::current_exception();
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_busy = false;
+		}
+		m_changed.notify_all();
+	}
+}
+
+} /* namespace checkpoint */
+} /* namespace stride */
@@ -0,0 +1,59 @@
+#ifndef CHECKPOINT_WRITER_H_INCLUDED
+#define CHECKPOINT_WRITER_H_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "CheckPoint.h"
+
+namespace stride {
+namespace checkpoint {
+
+/**
+ * Writes checkpoint snapshots on a background thread, so the simulation doesn't wait on HDF5.
+ * The writer owns all access to the checkpoint file while it runs: call Flush before using the
+ * CheckPoint directly.
+ */
+class CheckPointWriter
+{
+public:
+	/// Constructor. At most `capacity` snapshots wait to be written; Enqueue blocks beyond that.
+	CheckPointWriter(const std::shared_ptr<CheckPoint>& checkpoint, std::size_t capacity = 2);
+
+	CheckPointWriter(const CheckPointWriter&) = delete;
+	CheckPointWriter& operator=(const CheckPointWriter&) = delete;
+
+	/// Writes all pending snapshots, then stops the writer thread.
+	~CheckPointWriter();
+
+	/// Queues a snapshot to be written.
+	void Enqueue(const std::shared_ptr<const CheckPoint::Snapshot>& snapshot);
+
+	/// Blocks until every queued snapshot has been written. Rethrows the first error the writer ran into.
+	void Flush();
+
+private:
+	/// The writer thread's loop.
+	void Run();
+
+	std::shared_ptr<CheckPoint> m_checkpoint; //< the checkpoint file that is written to
+	const std::size_t m_capacity;		   //< the maximum number of queued snapshots
+
+	std::deque<std::shared_ptr<const CheckPoint::Snapshot>> m_queue; //< snapshots waiting to be written
+	bool m_busy;		    //< whether a snapshot is being written
+	bool m_stop;		    //< whether the writer thread should stop
+	std::exception_ptr m_error; //< the first error the writer ran into
+
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::thread m_thread;
+};
+
+} /* namespace checkpoint */
+} /* namespace stride */
+
+#endif /* CHECKPOINT_WRITER_H_INCLUDED */
@@ -7,6 +7,52 @@
 
 namespace stride {
 
-// This entire file exists to initialise this static member.
 std::size_t Atlas::Town::newId = 0;
-}
\ No newline at end of file
+
+constexpr std::uint32_t Atlas::no_cluster;
+constexpr std::uint32_t Atlas::no_town;
+
+void Atlas::RegisterTowns(const TownMap& towns)
+{
+	m_town_map = towns;
+	m_town_table.clear();
+	m_town_index.clear();
+	for (const auto& t : m_town_map) {
+		m_town_index.emplace(t.first, m_town_table.size());
+		m_town_table.push_back(t.second);
+	}
+
+	// Clusters that were stored before the towns are resolved again.
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		for (std::size_t id = 0; id < m_towns[t].size(); id++) {
+			if (m_towns[t][id] != no_cluster) {
+				m_towns[t][id] = FindTown(m_positions[t][id]);
+			}
+		}
+	}
+}
+
+util::MemoryUsage Atlas::GetMemoryUsage() const
+{
+	util::MemoryUsage usage;
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		usage += util::GetMemoryUsage(m_positions[t]);
+		usage += util::GetMemoryUsage(m_towns[t]);
+	}
+	usage += util::GetMemoryUsage(m_town_table);
+	usage += util::GetMemoryUsage(m_town_index);
+	usage += util::GetMemoryUsage(m_town_map);
+	for (const auto& town : m_town_table) {
+		const auto name_bytes = util::GetHeapBytes(town.name);
+		usage.used += name_bytes;
+		usage.allocated += name_bytes;
+	}
+	for (const auto& town : m_town_map) {
+		const auto name_bytes = util::GetHeapBytes(town.second.name);
+		usage.used += name_bytes;
+		usage.allocated += name_bytes;
+	}
+	return usage;
+}
+
+} // namespace stride
@@ -6,17 +6,25 @@
  * Header for the Atlas class.
  */
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <string>
 #include <utility>
+#include <vector>
 #include "core/ClusterType.h"
 #include "geo/GeoPosition.h"
+#include "util/MemoryAccount.h"
 
 namespace stride {
+
 /**
- * A map storing geopositions for clusters, and town data for geopositions.
+ * Stores geopositions for clusters, and town data for geopositions.
+ * Clusters are stored in flat arrays per cluster type, indexed by cluster id, together with the index of their
+ * town in a town table. Looking up a cluster's position or town is a pair of array reads.
  */
 class Atlas
 {
@@ -26,8 +34,10 @@ public:
 	{
 		// The name of the town or city
 		std::string name;
+
 		// The number of inhabitants
 		unsigned int size;
+
 		// The unique ID
 		std::size_t id;
 
@@ -43,29 +53,121 @@ public:
 	using TownMap = std::map<geo::GeoPosition, Town>;
 
 	Atlas() {}
-	Atlas(const ClusterMap& cluster_map) : cluster_map(cluster_map) {}
+
+	Atlas(const ClusterMap& cluster_map)
+	{
+		for (const auto& c : cluster_map) {
+			EmplaceCluster(c.first, c.second);
+		}
+	}
 
 	/// Look up a cluster's position. If it isn't found, throw std::out_of_range.
-	const geo::GeoPosition& LookupPosition(const ClusterKey& key) const { return cluster_map.at(key); }
+	const geo::GeoPosition& LookupPosition(const ClusterKey& key) const
+	{
+		return m_positions[ToSizeType(key.second)][Index(key)];
+	}
+
+	/// Look up a cluster's position. Returns null if it isn't found.
+	const geo::GeoPosition* FindPosition(const ClusterKey& key) const
+	{
+		const auto& towns = m_towns[ToSizeType(key.second)];
+		if (key.first >= towns.size() || towns[key.first] == no_cluster) {
+			return nullptr;
+		}
+		return &m_positions[ToSizeType(key.second)][key.first];
+	}
 
 	/// Look up a cluster's town. If it isn't found, throw std::out_of_range.
-	const Town& LookupTown(const ClusterKey& key) const { return town_map.at(cluster_map.at(key)); }
+	const Town& LookupTown(const ClusterKey& key) const
+	{
+		const std::uint32_t town = m_towns[ToSizeType(key.second)][Index(key)];
+		if (town == no_town) {
+			throw std::out_of_range("Atlas::LookupTown: cluster is not in a town");
+		}
+		return m_town_table[town];
+	}
+
+	/// Marks a cluster that isn't at the position of a town.
+	static constexpr std::uint32_t no_town = std::numeric_limits<std::uint32_t>::max() - 1;
+
+	/// Look up the index of a cluster's town in GetTowns(). Returns no_town if the cluster is unknown or
+	/// isn't in a town.
+	std::uint32_t FindTownIndex(const ClusterKey& key) const
+	{
+		const auto& towns = m_towns[ToSizeType(key.second)];
+		if (key.first >= towns.size() || towns[key.first] == no_cluster) {
+			return no_town;
+		}
+		return towns[key.first];
+	}
 
 	/// Get the map of towns.
-	const TownMap& getTownMap() const { return town_map; }
+	const TownMap& getTownMap() const { return m_town_map; }
 
-	/// Store a cluster's GeoPosition in the atlas.
-	auto EmplaceCluster(const Atlas::ClusterKey& key, const geo::GeoPosition& pos)
-	    -> decltype(ClusterMap().emplace(key, pos))
+	/// Get the towns, in the order of the map of towns.
+	const std::vector<Town>& GetTowns() const { return m_town_table; }
+
+	/// Store a cluster's GeoPosition in the atlas. Returns false if the cluster already had one.
+	bool EmplaceCluster(const Atlas::ClusterKey& key, const geo::GeoPosition& pos)
 	{
-		return cluster_map.emplace(key, pos);
+		auto& positions = m_positions[ToSizeType(key.second)];
+		auto& towns = m_towns[ToSizeType(key.second)];
+		if (key.first >= towns.size()) {
+			positions.resize(key.first + 1);
+			towns.resize(key.first + 1, no_cluster);
+		} else if (towns[key.first] != no_cluster) {
+			return false;
+		}
+		positions[key.first] = pos;
+		towns[key.first] = FindTown(pos);
+		return true;
 	}
 
 	/// Associate a GeoPosition with a specific Town.
-	void RegisterTowns(const TownMap& towns) { town_map = towns; }
+	void RegisterTowns(const TownMap& towns);
+
+	/// The memory of the cluster arrays and the towns.
+	util::MemoryUsage GetMemoryUsage() const;
+
+	/// Calls `action(key, position)` for every cluster, in the order of the keys.
+	template <typename TAction>
+	void ForEachCluster(const TAction& action) const
+	{
+		for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+			for (std::size_t id = 0; id < m_towns[t].size(); id++) {
+				if (m_towns[t][id] != no_cluster) {
+					action(ClusterKey(id, static_cast<ClusterType>(t)), m_positions[t][id]);
+				}
+			}
+		}
+	}
+
+private:
+	/// Marks an id without a cluster.
+	static constexpr std::uint32_t no_cluster = std::numeric_limits<std::uint32_t>::max();
+
+	/// The array index of a cluster. If it isn't found, throw std::out_of_range.
+	std::size_t Index(const ClusterKey& key) const
+	{
+		const auto& towns = m_towns[ToSizeType(key.second)];
+		if (key.first >= towns.size() || towns[key.first] == no_cluster) {
+			throw std::out_of_range("Atlas: unknown cluster");
+		}
+		return key.first;
+	}
+
+	/// The index of the town at the given position, or no_town.
+	std::uint32_t FindTown(const geo::GeoPosition& pos) const
+	{
+		const auto it = m_town_index.find(pos);
+		return it == m_town_index.end() ? no_town : it->second;
+	}
 
-	ClusterMap cluster_map;
-	TownMap town_map;
+	std::array<std::vector<geo::GeoPosition>, NumOfClusterTypes()> m_positions; ///< Positions by type and id.
+	std::array<std::vector<std::uint32_t>, NumOfClusterTypes()> m_towns;	  ///< Town indices by type and id.
+	std::vector<Town> m_town_table;						  ///< Towns, in TownMap order.
+	std::map<geo::GeoPosition, std::uint32_t> m_town_index;			  ///< Town index by position.
+	TownMap m_town_map;
 };
 
 } // end_of_namespace
@@ -7,6 +7,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 #include <spdlog/spdlog.h>
 
@@ -55,40 +56,29 @@ void Cluster::RemovePerson(const Person& p)
 	}
 }
 
-tuple<bool, std::size_t> Cluster::SortMembers()
+void Cluster::RemovePersons(const std::unordered_set<PersonId>& ids)
 {
-	bool infectious_cases = false;
-	std::size_t num_cases = 0;
-
-	for (size_t i_member = 0; i_member < m_index_immune; i_member++) {
-		// if immune, move to back
-		if (m_members[i_member].first.GetHealth().IsImmune()) {
-			bool swapped = false;
-			std::size_t new_place = m_index_immune - 1;
-			m_index_immune--;
-			while (!swapped && new_place > i_member) {
-				if (m_members[new_place].first.GetHealth().IsImmune()) {
-					m_index_immune--;
-					new_place--;
-				} else {
-					swap(m_members[i_member], m_members[new_place]);
-					swapped = true;
-				}
-			}
-		}
-		// else, if not susceptible, move to front
-		else if (!m_members[i_member].first.GetHealth().IsSusceptible()) {
-			if (!infectious_cases && m_members[i_member].first.GetHealth().IsInfectious()) {
-				infectious_cases = true;
+	// The members that stay keep their order, so the ones that aren't immune stay in front.
+	std::size_t index_immune = m_index_immune;
+	std::size_t kept = 0;
+	for (std::size_t index = 0; index < m_members.size(); index++) {
+		if (ids.count(m_members[index].first.GetId()) > 0) {
+			if (index < m_index_immune) {
+				index_immune--;
 			}
-			if (i_member > num_cases) {
-				swap(m_members[i_member], m_members[num_cases]);
-			}
-			num_cases++;
+		} else {
+			m_members[kept++] = m_members[index];
 		}
 	}
+	m_members.erase(m_members.begin() + kept, m_members.end());
+	m_index_immune = index_immune;
+}
 
-	return make_tuple(infectious_cases, num_cases);
+tuple<bool, std::size_t> Cluster::SortMembers()
+{
+	return SortMembers(
+	    m_index_immune, [this](std::size_t i) -> const Health& { return m_members[i].first.GetHealth(); },
+	    [this](std::size_t a, std::size_t b) { swap(m_members[a], m_members[b]); });
 }
 
 void Cluster::UpdateMemberPresence()
@@ -6,9 +6,12 @@
 #include "core/ContactProfile.h"
 #include "core/LogMode.h"
 #include "pop/Person.h"
+#include "util/MemoryAccount.h"
 
 #include <array>
 #include <cstddef>
+#include <tuple>
+#include <unordered_set>
 #include <vector>
 //#include <memory>
 
@@ -28,12 +31,18 @@ public:
 	/// Constructor
 	Cluster(ClusterId cluster_id, ClusterType cluster_type);
 
-	/// Add the given Person to the Cluster.
+	/// Add the given Person to the Cluster. Members that are not immune are kept in front of the immune ones.
 	void AddPerson(const Person& p);
 
+	/// Reserves room for the given number of members.
+	void Reserve(std::size_t size) { m_members.reserve(size); }
+
 	/// Removes the given person from this cluster.
 	void RemovePerson(const Person& p);
 
+	/// Removes the persons with the given ids from this cluster, in a single pass over its members.
+	void RemovePersons(const std::unordered_set<PersonId>& ids);
+
 	/// Returns the ID of the cluster.
 	ClusterId GetId() const { return m_cluster_id; }
 
@@ -43,6 +52,12 @@ public:
 	/// Return number of persons in this cluster.
 	std::size_t GetSize() const { return m_members.size(); }
 
+	/// The memory of the member vector: its members, and its capacity.
+	util::MemoryUsage GetMemoryUsage() const { return util::GetMemoryUsage(m_members); }
+
+	/// The number of bytes of a member in the member vector.
+	static constexpr std::size_t GetMemberSize() { return sizeof(std::pair<Person, bool>); }
+
 	/// Return the type of this cluster.
 	ClusterType GetClusterType() const { return m_cluster_type; }
 
@@ -60,10 +75,21 @@ private:
 	/// Sort members w.r.t. health status (order: exposed/infected/recovered, susceptible, immune).
 	std::tuple<bool, std::size_t> SortMembers();
 
+	/// Sorts members like SortMembers, through `health(i)`, which gets the health of the i-th member, and
+	/// `swap_members(i, j)`. Updates the index of the first immune member and returns whether there are
+	/// infectious cases, and the number of cases.
+	template <typename THealth, typename TSwap>
+	static std::tuple<bool, std::size_t> SortMembers(
+	    std::size_t& index_immune, const THealth& health, const TSwap& swap_members);
+
 	/// Infector calculates contacts and transmissions.
 	template <LogMode log_level, bool track_index_case, typename local_information_policy>
 	friend class Infector;
 
+	/// HouseholdInfector runs the households.
+	template <LogMode log_level, bool track_index_case, typename local_information_policy>
+	friend class HouseholdInfector;
+
 	/// Calculate which members are present in the cluster on the current day.
 	void UpdateMemberPresence();
 
@@ -86,6 +112,42 @@ private:
 	static std::array<ContactProfile, NumOfClusterTypes()> g_profiles;
 };
 
+template <typename THealth, typename TSwap>
+std::tuple<bool, std::size_t> Cluster::SortMembers(
+    std::size_t& index_immune, const THealth& health, const TSwap& swap_members)
+{
+	bool infectious_cases = false;
+	std::size_t num_cases = 0;
+
+	for (std::size_t i_member = 0; i_member < index_immune; i_member++) {
+		// if immune, move to back
+		if (health(i_member).IsImmune()) {
+			bool swapped = false;
+			std::size_t new_place = index_immune - 1;
+			index_immune--;
+			while (!swapped && new_place > i_member) {
+				if (health(new_place).IsImmune()) {
+					index_immune--;
+					new_place--;
+				} else {
+					swap_members(i_member, new_place);
+					swapped = true;
+				}
+			}
+		}
+		// else, if not susceptible, move to front
+		else if (!health(i_member).IsSusceptible()) {
+			infectious_cases = infectious_cases || health(i_member).IsInfectious();
+			if (i_member > num_cases) {
+				swap_members(i_member, num_cases);
+			}
+			num_cases++;
+		}
+	}
+
+	return std::make_tuple(infectious_cases, num_cases);
+}
+
 } // end_of_namespace
 
 #endif // include-guard
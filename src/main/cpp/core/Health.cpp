@@ -1,11 +1,18 @@
 #include "Health.h"
 
+#include <algorithm>
+#include <array>
 #include <assert.h>
 
 namespace stride {
 
 Health::Health(disease::Fate fate) : m_days_infected(0), m_status(HealthStatus::Susceptible), m_fate(fate) {}
 
+Health::Health(disease::Fate fate, HealthStatus status, unsigned int days_infected)
+    : m_days_infected(days_infected), m_status(status), m_fate(fate)
+{
+}
+
 void Health::SetImmune()
 {
 	m_status = HealthStatus::Immune;
@@ -28,32 +35,58 @@ void Health::Update()
 {
 	if (IsInfected()) {
 		IncrementDaysInfected();
-		if (GetDaysInfected() == GetStartInfectiousness()) {
-			if (m_status == HealthStatus::Symptomatic) {
-				m_status = HealthStatus::InfectiousAndSymptomatic;
-			} else {
-				m_status = HealthStatus::Infectious;
-			}
-		} else if (GetDaysInfected() == GetEndInfectiousness()) {
-			if (m_status == HealthStatus::InfectiousAndSymptomatic) {
-				m_status = HealthStatus::Symptomatic;
-			} else {
-				StopInfection();
-			}
-		} else if (GetDaysInfected() == GetStartSymptomatic()) {
-			if (m_status == HealthStatus::Infectious) {
-				m_status = HealthStatus::InfectiousAndSymptomatic;
-			} else {
-				m_status = HealthStatus::Symptomatic;
-			}
-		} else if (GetDaysInfected() == GetEndSymptomatic()) {
-			if (m_status == HealthStatus::InfectiousAndSymptomatic) {
-				m_status = HealthStatus::Infectious;
-			} else {
-				StopInfection();
-			}
+		m_status = NextStatus(m_status, GetDaysInfected(), m_fate);
+	}
+}
+
+HealthStatus Health::NextStatus(HealthStatus status, unsigned int day, const disease::Fate& fate)
+{
+	if (day == fate.start_infectiousness) {
+		if (status == HealthStatus::Symptomatic) {
+			return HealthStatus::InfectiousAndSymptomatic;
+		} else {
+			return HealthStatus::Infectious;
+		}
+	} else if (day == fate.end_infectiousness) {
+		if (status == HealthStatus::InfectiousAndSymptomatic) {
+			return HealthStatus::Symptomatic;
+		} else {
+			return HealthStatus::Recovered;
+		}
+	} else if (day == fate.start_symptomatic) {
+		if (status == HealthStatus::Infectious) {
+			return HealthStatus::InfectiousAndSymptomatic;
+		} else {
+			return HealthStatus::Symptomatic;
+		}
+	} else if (day == fate.end_symptomatic) {
+		if (status == HealthStatus::InfectiousAndSymptomatic) {
+			return HealthStatus::Infectious;
+		} else {
+			return HealthStatus::Recovered;
+		}
+	}
+	return status;
+}
+
+HealthStatus Health::GetInfectedStatus(const disease::Fate& fate, unsigned int days_infected)
+{
+	// The status only changes on the days of the fate, so only those days need to be visited.
+	std::array<unsigned int, 4> days{
+	    {fate.start_infectiousness, fate.end_infectiousness, fate.start_symptomatic, fate.end_symptomatic}};
+	std::sort(days.begin(), days.end());
+
+	HealthStatus status = HealthStatus::Exposed;
+	for (std::size_t i = 0; i < days.size() && days[i] <= days_infected; i++) {
+		if (days[i] == 0 || (i > 0 && days[i] == days[i - 1])) {
+			continue;
+		}
+		status = NextStatus(status, days[i], fate);
+		if (status == HealthStatus::Recovered) {
+			break;
 		}
 	}
+	return status;
 }
 
 } // namespace stride
@@ -5,6 +5,7 @@
 
 namespace stride {
 
+/// The statuses are numbered from 0, with Immune last: the time series file writes a count per status.
 enum class HealthStatus
 {
 	Susceptible = 0U,
@@ -25,6 +26,9 @@ public:
 	/// Initially, a person is Susceptible, and the "days infected" counter is set to 0.
 	Health(disease::Fate fate);
 
+	/// Restores a health state that was stored earlier, e.g. in a checkpoint.
+	Health(disease::Fate fate, HealthStatus status, unsigned int days_infected);
+
 	/// Return the person's current health status.
 	HealthStatus GetHealthStatus() const { return m_status; }
 
@@ -90,6 +94,10 @@ public:
 	/// Get the disease counter.
 	unsigned int GetDaysInfected() const { return m_days_infected; }
 
+	/// Return the status of a person with the given fate who got infected `days_infected` days ago, as if
+	/// StartInfection and `days_infected` Updates were called, but in constant time.
+	static HealthStatus GetInfectedStatus(const disease::Fate& fate, unsigned int days_infected);
+
 private:
 	/// Increment disease counter.
 	void IncrementDaysInfected() { m_days_infected++; }
@@ -97,6 +105,9 @@ private:
 	/// Reset the disease counter.
 	void ResetDaysInfected() { m_days_infected = 0U; }
 
+	/// The status an infected person moves to on the given day of the infection.
+	static HealthStatus NextStatus(HealthStatus status, unsigned int day, const disease::Fate& fate);
+
 private:
 	/// The day counter (starts at 0, increased daily while the person is infected).
 	unsigned int m_days_infected;
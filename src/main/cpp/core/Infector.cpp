@@ -3,10 +3,14 @@
 #include "core/Health.h"
 #include "core/Infector.h"
 #include "core/LogMode.h"
+#include "core/TransmissionKernel.h"
 #include "pop/Person.h"
+#include "pop/TownInfectionCounter.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <spdlog/spdlog.h>
@@ -17,13 +21,16 @@ namespace stride {
 using namespace std;
 
 /**
- * Primary R0_POLICY: do nothing i.e. track all cases.
+ * Primary R0_POLICY: track all cases, i.e. count the new case in its hometown.
  */
 template <bool track_index_case = false>
 class R0_POLICY
 {
 public:
-	static void Execute(const Person& p) {}
+	static void Execute(const Person& p, TownInfectionCounter::Delta& town_infections)
+	{
+		town_infections.Add(p, 1);
+	}
 };
 
 /**
@@ -33,7 +40,7 @@ template <>
 class R0_POLICY<true>
 {
 public:
-	static void Execute(const Person& p) { p.GetHealth().StopInfection(); }
+	static void Execute(const Person& p, TownInfectionCounter::Delta&) { p.GetHealth().StopInfection(); }
 };
 
 /**
@@ -44,8 +51,8 @@ class LOG_POLICY
 {
 public:
 	static void Execute(
-	    const shared_ptr<spdlog::logger>& logger, const Person& p1, const Person& p2, ClusterType cluster_type,
-	    const CalendarRef& environ)
+	    const shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log, const Person& p1,
+	    const Person& p2, ClusterType cluster_type, const CalendarRef& environ)
 	{
 	}
 };
@@ -58,11 +65,19 @@ class LOG_POLICY<LogMode::Transmissions>
 {
 public:
 	static void Execute(
-	    const shared_ptr<spdlog::logger>& logger, const Person& p1, const Person& p2, ClusterType cluster_type,
-	    const CalendarRef& environ)
+	    const shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log, const Person& p1,
+	    const Person& p2, ClusterType cluster_type, const CalendarRef& environ)
 	{
+		if (contact_log) {
+			contact_log->Push(
+			    {output::ContactRecord::Transmission, static_cast<uint8_t>(cluster_type), 0U,
+			     static_cast<uint32_t>(environ->GetSimulationDay()), p1.GetOriginalId(), p2.GetOriginalId(),
+			     p1.GetAge(), p2.GetAge()});
+			return;
+		}
 		logger->info(
-		    "[TRAN] {} {} {} {}", p1.GetId(), p2.GetId(), ToString(cluster_type), environ->GetSimulationDay());
+		    "[TRAN] {} {} {} {}", p1.GetOriginalId(), p2.GetOriginalId(), ToString(cluster_type),
+		    environ->GetSimulationDay());
 	}
 };
 
@@ -74,9 +89,16 @@ class LOG_POLICY<LogMode::Contacts>
 {
 public:
 	static void Execute(
-	    const shared_ptr<spdlog::logger>& logger, const Person& p1, const Person& p2, ClusterType cluster_type,
-	    const CalendarRef& calendar)
+	    const shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log, const Person& p1,
+	    const Person& p2, ClusterType cluster_type, const CalendarRef& calendar)
 	{
+		if (contact_log) {
+			contact_log->Push(
+			    {output::ContactRecord::Contact, static_cast<uint8_t>(cluster_type), 0U,
+			     static_cast<uint32_t>(calendar->GetSimulationDay()), p1.GetOriginalId(), p2.GetOriginalId(),
+			     p1.GetAge(), p2.GetAge()});
+			return;
+		}
 		unsigned int home = (cluster_type == ClusterType::Household);
 		unsigned int work = (cluster_type == ClusterType::Work);
 		unsigned int school = (cluster_type == ClusterType::School);
@@ -84,8 +106,8 @@ public:
 		unsigned int secundary_community = (cluster_type == ClusterType::SecondaryCommunity);
 
 		logger->info(
-		    "[CONT] {} {} {} {} {} {} {} {} {}", p1.GetId(), p1.GetAge(), p2.GetAge(), home, school, work,
-		    primary_community, secundary_community, calendar->GetSimulationDay());
+		    "[CONT] {} {} {} {} {} {} {} {} {}", p1.GetOriginalId(), p1.GetAge(), p2.GetAge(), home, school,
+		    work, primary_community, secundary_community, calendar->GetSimulationDay());
 	}
 };
 
@@ -98,7 +120,8 @@ public:
 template <LogMode log_level, bool track_index_case, typename local_information_policy>
 void Infector<log_level, track_index_case, local_information_policy>::Execute(
     Cluster& cluster, DiseaseProfile disease_profile, RngHandler& contact_handler, const CalendarRef& calendar,
-    const std::shared_ptr<spdlog::logger>& logger)
+    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+    output::ContactMatrices::Counts* contact_matrix, TownInfectionCounter::Delta& town_infections)
 {
 	cluster.UpdateMemberPresence();
 
@@ -132,16 +155,16 @@ void Infector<log_level, track_index_case, local_information_policy>::Execute(
 							if (p1.GetHealth().IsInfectious() &&
 							    p2.GetHealth().IsSusceptible()) {
 								LOG_POLICY<log_level>::Execute(
-								    logger, p1, p2, c_type, calendar);
+								    logger, contact_log, p1, p2, c_type, calendar);
 								p2.GetHealth().StartInfection();
-								R0_POLICY<track_index_case>::Execute(p2);
+								R0_POLICY<track_index_case>::Execute(p2, town_infections);
 							} else if (
 							    p2.GetHealth().IsInfectious() &&
 							    p1.GetHealth().IsSusceptible()) {
 								LOG_POLICY<log_level>::Execute(
-								    logger, p2, p1, c_type, calendar);
+								    logger, contact_log, p2, p1, c_type, calendar);
 								p1.GetHealth().StartInfection();
-								R0_POLICY<track_index_case>::Execute(p1);
+								R0_POLICY<track_index_case>::Execute(p1, town_infections);
 							}
 						}
 					}
@@ -157,7 +180,9 @@ void Infector<log_level, track_index_case, local_information_policy>::Execute(
 template <LogMode log_level, bool track_index_case>
 void Infector<log_level, track_index_case, NoLocalInformation>::Execute(
     Cluster& cluster, DiseaseProfile disease_profile, RngHandler& contact_handler, const CalendarRef& calendar,
-    const std::shared_ptr<spdlog::logger>& logger)
+    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+    output::ContactMatrices::Counts* contact_matrix, TownInfectionCounter::Delta& town_infections,
+    std::size_t min_batched_contacts)
 {
 	// check if the cluster has infected members and sort
 	bool infectious_cases;
@@ -173,6 +198,14 @@ void Infector<log_level, track_index_case, NoLocalInformation>::Execute(
 		const auto& c_members = cluster.m_members;
 		const auto transmission_rate = disease_profile.GetTransmissionRate();
 
+		// large clusters select the infected contacts in batches
+		if (c_immune - num_cases >= min_batched_contacts) {
+			ExecuteBatched(
+			    cluster, num_cases, transmission_rate, contact_handler, calendar, logger, contact_log,
+			    town_infections);
+			return;
+		}
+
 		// match infectious in first part with susceptible in second part, skip last part (immune)
 		for (size_t i_infected = 0; i_infected < num_cases; i_infected++) {
 			// check if member is present today
@@ -188,12 +221,14 @@ void Infector<log_level, track_index_case, NoLocalInformation>::Execute(
 						// check if member is present today
 						if (c_members[i_contact].second) {
 							auto p2 = c_members[i_contact].first;
+							// A member can be infected by another member earlier.
 							if (contact_handler.HasContactAndTransmission(
-								contact_rate, transmission_rate)) {
+								contact_rate, transmission_rate) &&
+							    p2.GetHealth().IsSusceptible()) {
 								LOG_POLICY<log_level>::Execute(
-								    logger, p1, p2, c_type, calendar);
+								    logger, contact_log, p1, p2, c_type, calendar);
 								p2.GetHealth().StartInfection();
-								R0_POLICY<track_index_case>::Execute(p2);
+								R0_POLICY<track_index_case>::Execute(p2, town_infections);
 							}
 						}
 					}
@@ -203,13 +238,62 @@ void Infector<log_level, track_index_case, NoLocalInformation>::Execute(
 	}
 }
 
+template <LogMode log_level, bool track_index_case>
+void Infector<log_level, track_index_case, NoLocalInformation>::ExecuteBatched(
+    Cluster& cluster, std::size_t num_cases, double transmission_rate, RngHandler& contact_handler,
+    const CalendarRef& calendar, const std::shared_ptr<spdlog::logger>& logger,
+    output::ContactLog::Buffer* contact_log, TownInfectionCounter::Delta& town_infections)
+{
+	const auto c_type = cluster.m_cluster_type;
+	const auto& c_members = cluster.m_members;
+
+	// pack the contacts that are present today; the buffers are reused by the clusters of a thread
+	thread_local vector<uint32_t> contacts;
+	thread_local vector<uint8_t> susceptible;
+	thread_local vector<double> uniforms;
+	thread_local vector<uint32_t> hits;
+	contacts.clear();
+	for (size_t i_contact = num_cases; i_contact < cluster.m_index_immune; i_contact++) {
+		if (c_members[i_contact].second) {
+			contacts.push_back(static_cast<uint32_t>(i_contact));
+		}
+	}
+	const size_t num_contacts = contacts.size();
+	susceptible.assign(num_contacts, 1U);
+	uniforms.resize(num_contacts);
+	hits.resize(num_contacts);
+
+	for (size_t i_infected = 0; i_infected < num_cases; i_infected++) {
+		if (c_members[i_infected].second) {
+			const auto p1 = c_members[i_infected].first;
+			if (p1.GetHealth().IsInfectious()) {
+				const double probability = contact_handler.ContactAndTransmissionProbability(
+				    cluster.GetContactRate(p1), transmission_rate);
+				contact_handler.DrawUniforms(uniforms.data(), num_contacts);
+				const size_t num_hits = TransmissionKernel::Select(
+				    uniforms.data(), susceptible.data(), num_contacts, probability, hits.data());
+				for (size_t i_hit = 0; i_hit < num_hits; i_hit++) {
+					auto p2 = c_members[contacts[hits[i_hit]]].first;
+					susceptible[hits[i_hit]] = 0U;
+					if (p2.GetHealth().IsSusceptible()) {
+						LOG_POLICY<log_level>::Execute(logger, contact_log, p1, p2, c_type, calendar);
+						p2.GetHealth().StartInfection();
+						R0_POLICY<track_index_case>::Execute(p2, town_infections);
+					}
+				}
+			}
+		}
+	}
+}
+
 //-------------------------------------------------------------------------------------------
 // Definition of partial specialization for LogMode::Contacts and NoLocalInformation policy.
 //-------------------------------------------------------------------------------------------
 template <bool track_index_case>
 void Infector<LogMode::Contacts, track_index_case, NoLocalInformation>::Execute(
     Cluster& cluster, DiseaseProfile disease_profile, RngHandler& contact_handler, const CalendarRef& calendar,
-    const std::shared_ptr<spdlog::logger>& logger)
+    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+    output::ContactMatrices::Counts* contact_matrix, TownInfectionCounter::Delta& town_infections)
 {
 	cluster.UpdateMemberPresence();
 
@@ -221,9 +305,14 @@ void Infector<LogMode::Contacts, track_index_case, NoLocalInformation>::Execute(
 	// check all contacts
 	for (size_t i_person1 = 0; i_person1 < c_members.size(); i_person1++) {
 		// check if member participates in the social contact survey && member is present today
-		if (c_members[i_person1].second && c_members[i_person1].first.IsParticipatingInSurvey()) {
-			auto p1 = c_members[i_person1].first;
+		const auto& member = c_members[i_person1].first;
+		if (c_members[i_person1].second &&
+		    (contact_matrix ? contact_matrix->IsParticipant(member) : member.IsParticipatingInSurvey())) {
+			auto p1 = member;
 			const double contact_rate = cluster.GetContactRate(p1);
+			if (contact_matrix) {
+				contact_matrix->AddParticipant(c_type, p1.GetAge());
+			}
 			// loop over possible contacts
 			for (size_t i_person2 = i_person1 + 1; i_person2 < c_members.size(); i_person2++) {
 				// check if member is present today
@@ -237,17 +326,21 @@ void Infector<LogMode::Contacts, track_index_case, NoLocalInformation>::Execute(
 							if (p1.GetHealth().IsInfectious() &&
 							    p2.GetHealth().IsSusceptible()) {
 								p2.GetHealth().StartInfection();
-								R0_POLICY<track_index_case>::Execute(p2);
+								R0_POLICY<track_index_case>::Execute(p2, town_infections);
 							} else if (
 							    p2.GetHealth().IsInfectious() &&
 							    p1.GetHealth().IsSusceptible()) {
 								p1.GetHealth().StartInfection();
-								R0_POLICY<track_index_case>::Execute(p1);
+								R0_POLICY<track_index_case>::Execute(p1, town_infections);
 							}
 						}
 
-						LOG_POLICY<LogMode::Contacts>::Execute(
-						    logger, p1, p2, c_type, calendar);
+						if (contact_matrix) {
+							contact_matrix->AddContact(c_type, p1.GetAge(), p2.GetAge());
+						} else {
+							LOG_POLICY<LogMode::Contacts>::Execute(
+							    logger, contact_log, p1, p2, c_type, calendar);
+						}
 					}
 				}
 			}
@@ -255,6 +348,119 @@ void Infector<LogMode::Contacts, track_index_case, NoLocalInformation>::Execute(
 	}
 }
 
+//-------------------------------------------------------------------------------------------
+// Definition of the household kernels.
+//-------------------------------------------------------------------------------------------
+template <LogMode log_level, bool track_index_case, typename local_information_policy>
+void HouseholdInfector<log_level, track_index_case, local_information_policy>::Execute(
+    std::vector<Cluster>& households, std::size_t first, std::size_t last, DiseaseProfile disease_profile,
+    RngHandler& contact_handler, const CalendarRef& calendar, const std::shared_ptr<spdlog::logger>& logger,
+    output::ContactLog::Buffer* contact_log, output::ContactMatrices::Counts* contact_matrix,
+    TownInfectionCounter::Delta& town_infections)
+{
+	// Logging every contact, or sharing information, involves every pair of members.
+	constexpr bool use_kernels =
+	    is_same<local_information_policy, NoLocalInformation>::value && log_level != LogMode::Contacts;
+	const auto transmission_rate = disease_profile.GetTransmissionRate();
+
+	for (size_t i = first; i < last; i++) {
+		auto& household = households[i];
+		switch (use_kernels ? household.GetSize() : MaxSize + 1) {
+		case 0:
+			break;
+		case 1:
+			ExecuteFixed<1>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		case 2:
+			ExecuteFixed<2>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		case 3:
+			ExecuteFixed<3>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		case 4:
+			ExecuteFixed<4>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		case 5:
+			ExecuteFixed<5>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		case 6:
+			ExecuteFixed<6>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		case 7:
+			ExecuteFixed<7>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		case 8:
+			ExecuteFixed<8>(
+			    household, transmission_rate, contact_handler, calendar, logger, contact_log, town_infections);
+			break;
+		default:
+			Infector<log_level, track_index_case, local_information_policy>::Execute(
+			    household, disease_profile, contact_handler, calendar, logger, contact_log, contact_matrix,
+			    town_infections);
+		}
+	}
+}
+
+template <LogMode log_level, bool track_index_case, typename local_information_policy>
+template <std::size_t size>
+void HouseholdInfector<log_level, track_index_case, local_information_policy>::ExecuteFixed(
+    Cluster& household, double transmission_rate, RngHandler& contact_handler, const CalendarRef& calendar,
+    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+    TownInfectionCounter::Delta& town_infections)
+{
+	auto& members = household.m_members;
+
+	// Look up the health of the members once, and sort them like Cluster::SortMembers does:
+	// exposed/infected/recovered, susceptible, immune.
+	Health* health[size];
+	for (size_t i = 0; i < size; i++) {
+		health[i] = &members[i].first.GetHealth();
+	}
+	bool infectious_cases = false;
+	size_t num_cases = 0;
+	tie(infectious_cases, num_cases) = Cluster::SortMembers(
+	    household.m_index_immune, [&health](size_t i) -> const Health& { return *health[i]; },
+	    [&members, &health](size_t a, size_t b) {
+		    swap(members[a], members[b]);
+		    swap(health[a], health[b]);
+	    });
+	const size_t index_immune = household.m_index_immune;
+	if (!infectious_cases) {
+		return;
+	}
+
+	bool present[size];
+	for (size_t i = 0; i < size; i++) {
+		present[i] = members[i].second = members[i].first.IsInCluster(ClusterType::Household);
+	}
+
+	// match infectious in first part with susceptible in second part, skip last part (immune)
+	for (size_t i_infected = 0; i_infected < num_cases; i_infected++) {
+		if (present[i_infected] && health[i_infected]->IsInfectious()) {
+			const auto& p1 = members[i_infected].first;
+			const double contact_rate = household.GetContactRate(p1);
+			for (size_t i_contact = num_cases; i_contact < index_immune; i_contact++) {
+				if (present[i_contact] &&
+				    contact_handler.HasContactAndTransmission(contact_rate, transmission_rate) &&
+				    health[i_contact]->IsSusceptible()) {
+					const auto& p2 = members[i_contact].first;
+					LOG_POLICY<log_level>::Execute(
+					    logger, contact_log, p1, p2, ClusterType::Household, calendar);
+					health[i_contact]->StartInfection();
+					R0_POLICY<track_index_case>::Execute(p2, town_infections);
+				}
+			}
+		}
+	}
+}
+
 //--------------------------------------------------------------------------
 // All explicit instantiations.
 //--------------------------------------------------------------------------
@@ -270,4 +476,16 @@ template class Infector<LogMode::Contacts, false, NoLocalInformation>;
 
 template class Infector<LogMode::Contacts, true, NoLocalInformation>;
 
+template class HouseholdInfector<LogMode::None, false, NoLocalInformation>;
+
+template class HouseholdInfector<LogMode::None, true, NoLocalInformation>;
+
+template class HouseholdInfector<LogMode::Transmissions, false, NoLocalInformation>;
+
+template class HouseholdInfector<LogMode::Transmissions, true, NoLocalInformation>;
+
+template class HouseholdInfector<LogMode::Contacts, false, NoLocalInformation>;
+
+template class HouseholdInfector<LogMode::Contacts, true, NoLocalInformation>;
+
 } // end_of_namespace
@@ -3,8 +3,14 @@
 
 #include "core/DiseaseProfile.h"
 #include "core/LogMode.h"
+#include "core/TransmissionKernel.h"
+#include "output/ContactLog.h"
+#include "output/ContactMatrices.h"
+#include "pop/TownInfectionCounter.h"
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 #include <spdlog/spdlog.h>
 
 namespace stride {
@@ -20,10 +26,13 @@ template <LogMode log_level, bool track_index_case, typename local_information_p
 class Infector
 {
 public:
-	///
+	/// Simulates the contacts in the cluster. Contacts are counted in `contact_matrix` if it isn't null, or
+	/// logged to `contact_log` if that isn't null, and to `logger` otherwise. New cases are counted in
+	/// `town_infections`.
 	static void Execute(
 	    Cluster& cluster, DiseaseProfile disease_profile, RngHandler& contact_handler, const CalendarRef& sim_state,
-	    const std::shared_ptr<spdlog::logger>& logger);
+	    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+	    output::ContactMatrices::Counts* contact_matrix, TownInfectionCounter::Delta& town_infections);
 };
 
 /**
@@ -33,10 +42,23 @@ template <LogMode log_level, bool track_index_case>
 class Infector<log_level, track_index_case, NoLocalInformation>
 {
 public:
-	///
+	/// Simulates the contacts in the cluster. Contacts are counted in `contact_matrix` if it isn't null, or
+	/// logged to `contact_log` if that isn't null, and to `logger` otherwise. New cases are counted in
+	/// `town_infections`. Clusters with at least `min_batched_contacts` susceptible contacts go through
+	/// ExecuteBatched, which gives the same results as the loop over every pair.
 	static void Execute(
 	    Cluster& cluster, DiseaseProfile disease_profile, RngHandler& contact_handler, const CalendarRef& sim_state,
-	    const std::shared_ptr<spdlog::logger>& logger);
+	    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+	    output::ContactMatrices::Counts* contact_matrix, TownInfectionCounter::Delta& town_infections,
+	    std::size_t min_batched_contacts = TransmissionKernel::MinContacts);
+
+private:
+	/// Matches the infectious members with the contacts that are present, in batches through the
+	/// TransmissionKernel. Draws the same numbers, and infects the same contacts, as Execute.
+	static void ExecuteBatched(
+	    Cluster& cluster, std::size_t num_cases, double transmission_rate, RngHandler& contact_handler,
+	    const CalendarRef& calendar, const std::shared_ptr<spdlog::logger>& logger,
+	    output::ContactLog::Buffer* contact_log, TownInfectionCounter::Delta& town_infections);
 };
 
 /**
@@ -47,10 +69,46 @@ template <bool track_index_case>
 class Infector<LogMode::Contacts, track_index_case, NoLocalInformation>
 {
 public:
-	///
+	/// Simulates the contacts in the cluster. Contacts are counted in `contact_matrix` if it isn't null, or
+	/// logged to `contact_log` if that isn't null, and to `logger` otherwise. New cases are counted in
+	/// `town_infections`.
 	static void Execute(
 	    Cluster& cluster, DiseaseProfile disease_profile, RngHandler& contact_handler, const CalendarRef& calendar,
-	    const std::shared_ptr<spdlog::logger>& logger);
+	    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+	    output::ContactMatrices::Counts* contact_matrix, TownInfectionCounter::Delta& town_infections);
+};
+
+/**
+ * Contacts and transmissions in households, which are run in batches rather than one cluster at a time. With the
+ * NoLocalInformation policy and without logging every contact, households of up to MaxSize members are run by a
+ * kernel for their size, which reads the health and presence of the members into small fixed size arrays and
+ * only looks at the pairs of an infectious and a susceptible member. The kernels give the same results as the
+ * Infector; other households are run by the Infector.
+ */
+template <LogMode log_level, bool track_index_case, typename local_information_policy>
+class HouseholdInfector
+{
+public:
+	/// The number of households in a batch.
+	static constexpr std::size_t BatchSize = 4096;
+
+	/// The largest household size with a kernel.
+	static constexpr std::size_t MaxSize = 8;
+
+	/// Simulates the contacts in the households with index in [first, last).
+	static void Execute(
+	    std::vector<Cluster>& households, std::size_t first, std::size_t last, DiseaseProfile disease_profile,
+	    RngHandler& contact_handler, const CalendarRef& calendar, const std::shared_ptr<spdlog::logger>& logger,
+	    output::ContactLog::Buffer* contact_log, output::ContactMatrices::Counts* contact_matrix,
+	    TownInfectionCounter::Delta& town_infections);
+
+private:
+	/// Simulates the contacts in a household with `size` members.
+	template <std::size_t size>
+	static void ExecuteFixed(
+	    Cluster& household, double transmission_rate, RngHandler& contact_handler, const CalendarRef& calendar,
+	    const std::shared_ptr<spdlog::logger>& logger, output::ContactLog::Buffer* contact_log,
+	    TownInfectionCounter::Delta& town_infections);
 };
 
 /// Explicit instantiations in cpp file.
@@ -61,6 +119,13 @@ extern template class Infector<LogMode::Transmissions, true, NoLocalInformation>
 extern template class Infector<LogMode::Contacts, false, NoLocalInformation>;
 extern template class Infector<LogMode::Contacts, true, NoLocalInformation>;
 
+extern template class HouseholdInfector<LogMode::None, false, NoLocalInformation>;
+extern template class HouseholdInfector<LogMode::None, true, NoLocalInformation>;
+extern template class HouseholdInfector<LogMode::Transmissions, false, NoLocalInformation>;
+extern template class HouseholdInfector<LogMode::Transmissions, true, NoLocalInformation>;
+extern template class HouseholdInfector<LogMode::Contacts, false, NoLocalInformation>;
+extern template class HouseholdInfector<LogMode::Contacts, true, NoLocalInformation>;
+
 } // end_of_namespace
 
 #endif // include-guard
@@ -2,6 +2,7 @@
 #define RNG_HANDLER_H_INCLUDED
 
 #include "math.h"
+#include <cstddef>
 #include "util/Random.h"
 
 namespace stride {
@@ -21,10 +22,24 @@ public:
 	/// Convert rate into probability
 	double RateToProbability(double rate) { return 1 - exp(-rate); }
 
+	/// Probability that two individuals have contact and transmission.
+	double ContactAndTransmissionProbability(double contact_rate, double transmission_rate)
+	{
+		return RateToProbability(transmission_rate * contact_rate);
+	}
+
 	/// Check if two individuals have transmission.
 	bool HasContactAndTransmission(double contact_rate, double transmission_rate)
 	{
-		return m_rng.NextDouble() < RateToProbability(transmission_rate * contact_rate);
+		return m_rng.NextDouble() < ContactAndTransmissionProbability(contact_rate, transmission_rate);
+	}
+
+	/// Draws the uniform numbers of a batch of contacts, in the order HasContactAndTransmission would.
+	void DrawUniforms(double* uniforms, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; i++) {
+			uniforms[i] = m_rng.NextDouble();
+		}
 	}
 
 	/// Check if two individuals have contact.
@@ -0,0 +1,167 @@
+#include "TransmissionKernel.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STRIDE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace stride {
+
+using namespace std;
+
+namespace {
+
+using SelectFunction = size_t (*)(const double*, const uint8_t*, size_t, double, uint32_t*);
+
+#ifdef STRIDE_X86_KERNELS
+
+/// Select with AVX2: compares eight contacts at a time and compresses the hits from the bit mask.
+__attribute__((target("avx2,bmi"))) size_t Avx2Kernel(
+    const double* uniforms, const uint8_t* susceptible, size_t count, double probability, uint32_t* hits)
+{
+	const __m256d threshold = _mm256_set1_pd(probability);
+	const __m128i zero = _mm_setzero_si128();
+	size_t num_hits = 0;
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const unsigned int below = static_cast<unsigned int>(
+		    _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(uniforms + i), threshold, _CMP_LT_OQ)) |
+		    (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(uniforms + i + 4), threshold, _CMP_LT_OQ))
+		     << 4));
+		const __m128i flags = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(susceptible + i));
+		const unsigned int susceptible_mask =
+		    ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(flags, zero)));
+		unsigned int mask = below & susceptible_mask & 0xFFU;
+		while (mask) {
+			hits[num_hits++] = static_cast<uint32_t>(i + _tzcnt_u32(mask));
+			mask = _blsr_u32(mask);
+		}
+	}
+	for (; i < count; i++) {
+		if (uniforms[i] < probability && susceptible[i]) {
+			hits[num_hits++] = static_cast<uint32_t>(i);
+		}
+	}
+	return num_hits;
+}
+
+/// Select with AVX-512: compares sixteen contacts at a time and compress-stores the hits.
+__attribute__((target("avx512f"))) size_t Avx512Kernel(
+    const double* uniforms, const uint8_t* susceptible, size_t count, double probability, uint32_t* hits)
+{
+	const __m512d threshold = _mm512_set1_pd(probability);
+	const __m512i offsets = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	size_t num_hits = 0;
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __mmask8 below_low = _mm512_cmp_pd_mask(_mm512_loadu_pd(uniforms + i), threshold, _CMP_LT_OQ);
+		const __mmask8 below_high =
+		    _mm512_cmp_pd_mask(_mm512_loadu_pd(uniforms + i + 8), threshold, _CMP_LT_OQ);
+		const __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(susceptible + i));
+		const unsigned int susceptible_mask =
+		    ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(flags, _mm_setzero_si128())));
+		const __mmask16 mask = static_cast<__mmask16>(
+		    susceptible_mask & (below_low | (static_cast<unsigned int>(below_high) << 8)));
+		const __m512i indices = _mm512_add_epi32(offsets, _mm512_set1_epi32(static_cast<int>(i)));
+		_mm512_mask_compressstoreu_epi32(hits + num_hits, mask, indices);
+		num_hits += static_cast<size_t>(__builtin_popcount(mask));
+	}
+	for (; i < count; i++) {
+		if (uniforms[i] < probability && susceptible[i]) {
+			hits[num_hits++] = static_cast<uint32_t>(i);
+		}
+	}
+	return num_hits;
+}
+
+#endif
+
+/// Picks the widest implementation that the CPU supports.
+SelectFunction PickSelect()
+{
+#ifdef STRIDE_X86_KERNELS
+	if (TransmissionKernel::SupportsAvx512()) {
+		return Avx512Kernel;
+	}
+	if (TransmissionKernel::SupportsAvx2()) {
+		return Avx2Kernel;
+	}
+#endif
+	return TransmissionKernel::SelectScalar;
+}
+
+} // end_of_namespace
+
+const TransmissionKernel::SelectFunction TransmissionKernel::g_select = PickSelect();
+
+constexpr std::size_t TransmissionKernel::MinContacts;
+
+std::size_t TransmissionKernel::SelectScalar(
+    const double* uniforms, const std::uint8_t* susceptible, std::size_t count, double probability,
+    std::uint32_t* hits)
+{
+	size_t num_hits = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (uniforms[i] < probability && susceptible[i]) {
+			hits[num_hits++] = static_cast<uint32_t>(i);
+		}
+	}
+	return num_hits;
+}
+
+std::size_t TransmissionKernel::SelectAvx2(
+    const double* uniforms, const std::uint8_t* susceptible, std::size_t count, double probability,
+    std::uint32_t* hits)
+{
+#ifdef STRIDE_X86_KERNELS
+	return Avx2Kernel(uniforms, susceptible, count, probability, hits);
+#else
+	return SelectScalar(uniforms, susceptible, count, probability, hits);
+#endif
+}
+
+std::size_t TransmissionKernel::SelectAvx512(
+    const double* uniforms, const std::uint8_t* susceptible, std::size_t count, double probability,
+    std::uint32_t* hits)
+{
+#ifdef STRIDE_X86_KERNELS
+	return Avx512Kernel(uniforms, susceptible, count, probability, hits);
+#else
+	return SelectScalar(uniforms, susceptible, count, probability, hits);
+#endif
+}
+
+bool TransmissionKernel::SupportsAvx2()
+{
+#ifdef STRIDE_X86_KERNELS
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi");
+#else
+	return false;
+#endif
+}
+
+bool TransmissionKernel::SupportsAvx512()
+{
+#ifdef STRIDE_X86_KERNELS
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx512f");
+#else
+	return false;
+#endif
+}
+
+const char* TransmissionKernel::GetName()
+{
+#ifdef STRIDE_X86_KERNELS
+	if (g_select == Avx512Kernel) {
+		return "avx512";
+	}
+	if (g_select == Avx2Kernel) {
+		return "avx2";
+	}
+#endif
+	return "scalar";
+}
+
+} // end_of_namespace
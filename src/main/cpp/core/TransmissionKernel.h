@@ -0,0 +1,62 @@
+#ifndef TRANSMISSION_KERNEL_H_INCLUDED
+#define TRANSMISSION_KERNEL_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+namespace stride {
+
+/**
+ * Selects the contacts of an infectious person that are infected, over packed arrays: the uniform draws and
+ * susceptibility of the contacts that are present. The selection is vectorized with AVX-512 or AVX2 when the
+ * CPU supports it, and done one contact at a time otherwise. Every implementation selects the same contacts.
+ */
+class TransmissionKernel
+{
+public:
+	/// The minimal number of contacts for which the Infector uses the kernel.
+	static constexpr std::size_t MinContacts = 16;
+
+	/// Writes the index of every contact i < count with uniforms[i] < probability and susceptible[i] != 0 to
+	/// `hits`, in increasing order, and returns their number. `hits` has room for `count` indices.
+	static std::size_t Select(
+	    const double* uniforms, const std::uint8_t* susceptible, std::size_t count, double probability,
+	    std::uint32_t* hits)
+	{
+		return g_select(uniforms, susceptible, count, probability, hits);
+	}
+
+	/// Select, one contact at a time.
+	static std::size_t SelectScalar(
+	    const double* uniforms, const std::uint8_t* susceptible, std::size_t count, double probability,
+	    std::uint32_t* hits);
+
+	/// Select with AVX2, eight contacts at a time. Only call it if SupportsAvx2().
+	static std::size_t SelectAvx2(
+	    const double* uniforms, const std::uint8_t* susceptible, std::size_t count, double probability,
+	    std::uint32_t* hits);
+
+	/// Select with AVX-512, sixteen contacts at a time. Only call it if SupportsAvx512().
+	static std::size_t SelectAvx512(
+	    const double* uniforms, const std::uint8_t* susceptible, std::size_t count, double probability,
+	    std::uint32_t* hits);
+
+	/// Whether this build and the CPU support SelectAvx2.
+	static bool SupportsAvx2();
+
+	/// Whether this build and the CPU support SelectAvx512.
+	static bool SupportsAvx512();
+
+	/// The name of the implementation used by Select: "avx512", "avx2" or "scalar".
+	static const char* GetName();
+
+private:
+	using SelectFunction = std::size_t (*)(const double*, const std::uint8_t*, std::size_t, double, std::uint32_t*);
+
+	/// The implementation of Select, picked for the CPU on startup.
+	static const SelectFunction g_select;
+};
+
+} // end_of_namespace
+
+#endif // end-of-include-guard
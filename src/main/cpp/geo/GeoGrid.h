@@ -0,0 +1,172 @@
+#ifndef GEO_GEOGRID_H_INCLUDED
+#define GEO_GEOGRID_H_INCLUDED
+
+/**
+ * @file
+ * Header file for a uniform latitude/longitude grid index over a GeoPosition map.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <vector>
+#include "GeoPosition.h"
+
+namespace stride {
+namespace geo {
+
+/// A spatial index over the entries of a std::map<GeoPosition, T>, bucketing them into a uniform grid of
+/// latitude/longitude cells. Radius queries only inspect the cells that can contain a match, and return hits in
+/// the map's iteration order, so the result is identical to a linear scan of the map.
+/// The indexed map must outlive the grid and must not have entries added or removed after construction.
+template <typename T>
+class GeoGrid
+{
+public:
+	/// Build a grid over the given map, with cells of roughly `cell_size` kilometres.
+	GeoGrid(std::map<GeoPosition, T>& map, double cell_size)
+	{
+		entries.reserve(map.size());
+		for (auto& p : map) {
+			entries.push_back({p.first, &p.second});
+		}
+		if (entries.empty()) {
+			return;
+		}
+
+		// Determine the bounding box of all entries.
+		min_lat = max_lat = entries.front().position.latitude;
+		min_long = max_long = entries.front().position.longitude;
+		for (const auto& e : entries) {
+			min_lat = std::min(min_lat, e.position.latitude);
+			max_lat = std::max(max_lat, e.position.latitude);
+			min_long = std::min(min_long, e.position.longitude);
+			max_long = std::max(max_long, e.position.longitude);
+		}
+
+		// Cells are square in degrees; keep the grid dimensions bounded for tiny cell sizes.
+		cell_degrees = std::max(KilometresToDegrees(cell_size), 1e-9);
+		const double span = std::max(max_lat - min_lat, max_long - min_long);
+		cell_degrees = std::max(cell_degrees, span / max_cells_per_axis);
+		rows = static_cast<std::size_t>((max_lat - min_lat) / cell_degrees) + 1;
+		cols = static_cast<std::size_t>((max_long - min_long) / cell_degrees) + 1;
+
+		// Counting sort of entry indices by cell; indices stay ascending within each cell.
+		cell_start.assign(rows * cols + 1, 0);
+		std::vector<std::size_t> cell_of(entries.size());
+		for (std::size_t i = 0; i < entries.size(); i++) {
+			cell_of[i] = Row(entries[i].position.latitude) * cols + Col(entries[i].position.longitude);
+			cell_start[cell_of[i] + 1]++;
+		}
+		std::partial_sum(cell_start.begin(), cell_start.end(), cell_start.begin());
+		cell_entries.resize(entries.size());
+		std::vector<std::size_t> fill(cell_start.begin(), cell_start.end() - 1);
+		for (std::size_t i = 0; i < entries.size(); i++) {
+			cell_entries[fill[cell_of[i]]++] = i;
+		}
+	}
+
+	/// The number of indexed entries.
+	std::size_t Size() const { return entries.size(); }
+
+	/// Whether the grid indexes no entries.
+	bool Empty() const { return entries.empty(); }
+
+	/// The i-th entry's value, in the map's iteration order.
+	T& ValueAt(std::size_t i) const { return *entries[i].value; }
+
+	/// The i-th entry's position, in the map's iteration order.
+	const GeoPosition& PositionAt(std::size_t i) const { return entries[i].position; }
+
+	/// Collect references to all values whose position lies strictly within `radius` kilometres of `origin`, in
+	/// the map's iteration order.
+	void FindWithin(
+	    const GeoPosition& origin, double radius, std::vector<std::reference_wrapper<T>>& hits) const
+	{
+		if (entries.empty()) {
+			return;
+		}
+
+		std::vector<std::size_t> candidates;
+		const double dlat = KilometresToDegrees(radius) + epsilon;
+		const double dlong = LongitudeBound(origin.latitude, radius);
+		if (dlong < 0.0 || origin.longitude - dlong < -180.0 || origin.longitude + dlong > 180.0) {
+			// Polar regions or the antimeridian: don't bother being clever.
+			for (std::size_t i = 0; i < entries.size(); i++) {
+				candidates.push_back(i);
+			}
+		} else {
+			if (origin.latitude + dlat < min_lat || origin.latitude - dlat > max_lat ||
+			    origin.longitude + dlong < min_long || origin.longitude - dlong > max_long) {
+				return;
+			}
+			const std::size_t row_lo = Row(origin.latitude - dlat), row_hi = Row(origin.latitude + dlat);
+			const std::size_t col_lo = Col(origin.longitude - dlong), col_hi = Col(origin.longitude + dlong);
+			for (std::size_t row = row_lo; row <= row_hi; row++) {
+				const auto begin = cell_entries.begin() + cell_start[row * cols + col_lo];
+				const auto end = cell_entries.begin() + cell_start[row * cols + col_hi + 1];
+				candidates.insert(candidates.end(), begin, end);
+			}
+			std::sort(candidates.begin(), candidates.end());
+		}
+
+		for (std::size_t i : candidates) {
+			if (entries[i].position.Distance(origin) < radius) {
+				hits.emplace_back(*entries[i].value);
+			}
+		}
+	}
+
+private:
+	struct Entry
+	{
+		GeoPosition position;
+		T* value;
+	};
+
+	static constexpr double earth_radius = 6371.0;
+	static constexpr double epsilon = 1e-6;
+	static constexpr double max_cells_per_axis = 1024.0;
+
+	std::vector<Entry> entries;
+	std::vector<std::size_t> cell_start;
+	std::vector<std::size_t> cell_entries;
+
+	double min_lat = 0.0, max_lat = 0.0;
+	double min_long = 0.0, max_long = 0.0;
+	double cell_degrees = 1.0;
+	std::size_t rows = 0, cols = 0;
+
+	static double KilometresToDegrees(double km) { return km / earth_radius * 180.0 / M_PI; }
+
+	/// The largest longitude difference (in degrees) at which a point can still be within `radius` kilometres of
+	/// a point at latitude `lat`, or a negative value if every longitude qualifies.
+	static double LongitudeBound(double lat, double radius)
+	{
+		const double angle = radius / earth_radius;
+		const double c = std::cos(lat * M_PI / 180.0);
+		if (angle >= M_PI / 2.0 || std::sin(angle) >= c) {
+			return -1.0;
+		}
+		return std::asin(std::sin(angle) / c) * 180.0 / M_PI + epsilon;
+	}
+
+	std::size_t Row(double lat) const { return Clamp((lat - min_lat) / cell_degrees, rows); }
+	std::size_t Col(double lng) const { return Clamp((lng - min_long) / cell_degrees, cols); }
+
+	static std::size_t Clamp(double x, std::size_t n)
+	{
+		if (x <= 0.0) {
+			return 0;
+		}
+		return std::min(static_cast<std::size_t>(x), n - 1);
+	}
+};
+
+} // namespace geo
+} // namespace stride
+
+#endif // end-of-include-guard
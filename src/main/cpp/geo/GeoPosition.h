@@ -8,6 +8,8 @@
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/register/multi_point.hpp>
 #include <boost/geometry/geometries/register/point.hpp>
+#include "alias/Alias.h"
+#include "util/Errors.h"
 #include "util/Random.h"
 
 namespace stride {
@@ -75,35 +77,66 @@ namespace geo {
 using GeoPolygon = boost::geometry::model::polygon<GeoPosition>;
 using GeoBox = boost::geometry::model::box<GeoPosition>;
 
+/// Samples uniformly distributed points from the convex hull of a set of points. The hull is fan-triangulated
+/// once; a sample picks a triangle proportionally to its area and then a uniform point inside that triangle.
 class HullSampler
 {
 public:
-	HullSampler(const std::vector<GeoPosition>& points)
+	HullSampler(const std::vector<GeoPosition>& points) : triangle_alias(alias::Alias::CreateDistribution({1.0}))
 	{
 		boost::geometry::convex_hull(points, hull);
-		boost::geometry::envelope(hull, box);
+
+		// The hull's ring is closed: its last point repeats the first one.
+		const auto& ring = hull.outer();
+		std::vector<double> areas;
+		for (std::size_t i = 1; i + 2 < ring.size(); i++) {
+			const Triangle t{ring[0], ring[i], ring[i + 1]};
+			const double area = std::abs(
+			    (t.b.latitude - t.a.latitude) * (t.c.longitude - t.a.longitude) -
+			    (t.c.latitude - t.a.latitude) * (t.b.longitude - t.a.longitude));
+			if (area > 0.0) {
+				triangles.push_back(t);
+				areas.push_back(area);
+			}
+		}
+		if (!areas.empty()) {
+			triangle_alias = alias::Alias::CreateDistribution(areas);
+		}
 	}
 
+	HullSampler(HullSampler&&) = default;
+	HullSampler& operator=(HullSampler&&) = default;
+
 	GeoPosition Sample(util::Random& random) const
 	{
-		GeoPosition point;
-		do {
-			GeoPosition a = box.min_corner();
-			GeoPosition b = box.max_corner();
-			double ax = a.latitude, ay = a.longitude;
-			double bx = b.latitude, by = b.longitude;
-			double t = random.NextDouble();
-			double u = random.NextDouble();
-			point.latitude = ax * t + bx * (1.0 - t);
-			point.longitude = ay * u + by * (1.0 - u);
-		} while (!boost::geometry::within(point, hull));
-
-		return point;
+		if (triangles.empty()) {
+			// A degenerate hull (fewer than three points, or all of them collinear) has no inside.
+			if (hull.outer().empty()) {
+				FATAL_ERROR("HullSampler::Sample called on an empty hull.");
+			}
+			return hull.outer()[random(hull.outer().size())];
+		}
+
+		const Triangle& t = triangles[triangle_alias.Next(random)];
+		double u = random.NextDouble();
+		double v = random.NextDouble();
+		if (u + v > 1.0) {
+			u = 1.0 - u;
+			v = 1.0 - v;
+		}
+		return {t.a.latitude + u * (t.b.latitude - t.a.latitude) + v * (t.c.latitude - t.a.latitude),
+			t.a.longitude + u * (t.b.longitude - t.a.longitude) + v * (t.c.longitude - t.a.longitude)};
 	}
 
 private:
+	struct Triangle
+	{
+		GeoPosition a, b, c;
+	};
+
 	GeoPolygon hull;
-	GeoBox box;
+	std::vector<Triangle> triangles;
+	alias::Alias triangle_alias;
 };
 
 } // namespace
@@ -15,8 +15,8 @@ using ProfileRef = std::shared_ptr<const Profile>;
 class Profile
 {
 public:
-	Profile(const std::vector<City>& cities, const HullSampler& hull_sampler)
-	    : m_cities(cities), m_hull_sampler(hull_sampler)
+	Profile(const std::vector<City>& cities, HullSampler&& hull_sampler)
+	    : m_cities(cities), m_hull_sampler(std::move(hull_sampler))
 	{
 		std::sort(m_cities.begin(), m_cities.end(), [](const City& a, const City& b) {
 			return a.relative_population > b.relative_population;
@@ -0,0 +1,103 @@
+#include "CommutingModel.h"
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <boost/tokenizer.hpp>
+#include "geo/Profile.h"
+#include "util/InstallDirs.h"
+#include "util/StringUtils.h"
+
+namespace stride {
+namespace multiregion {
+
+CommutingModel::CommutingModel(const std::vector<std::vector<geo::City>>& region_cities, std::istream& flows_file)
+    : m_region_cities(region_cities), m_connected_regions(region_cities.size())
+{
+	// A city that is in more than one profile belongs to the first region.
+	std::unordered_map<geo::CityId, RegionId> city_regions;
+	for (RegionId region_id = 0; region_id < m_region_cities.size(); region_id++) {
+		for (const auto& city : m_region_cities[region_id]) {
+			city_regions.emplace(city.id, region_id);
+		}
+	}
+
+	// Skip the header line:
+	// "city_depart","city_arrival","proportion"
+	std::vector<std::string> tokens;
+	std::string line;
+	getline(flows_file, line);
+
+	while (getline(flows_file, line)) {
+		boost::tokenizer<boost::escaped_list_separator<char>> tok(line);
+		tokens.assign(tok.begin(), tok.end());
+		if (tokens.size() < 3) {
+			continue;
+		}
+		const auto depart = city_regions.find(util::StringUtils::FromString<geo::CityId>(tokens[0]));
+		const auto arrival = city_regions.find(util::StringUtils::FromString<geo::CityId>(tokens[1]));
+		const auto fraction = util::StringUtils::FromString<double>(tokens[2]);
+		if (depart == city_regions.end() || arrival == city_regions.end() ||
+		    depart->second == arrival->second || fraction <= 0.0) {
+			continue;
+		}
+		m_flows[depart->first].push_back({arrival->first, arrival->second, fraction});
+		m_connected_regions[depart->second].insert(arrival->second);
+		m_connected_regions[arrival->second].insert(depart->second);
+	}
+}
+
+const std::vector<geo::City>& CommutingModel::GetCities(RegionId region_id) const
+{
+	static const std::vector<geo::City> no_cities;
+	return region_id < m_region_cities.size() ? m_region_cities[region_id] : no_cities;
+}
+
+const std::vector<CommutingFlow>& CommutingModel::GetFlows(geo::CityId city_id) const
+{
+	static const std::vector<CommutingFlow> no_flows;
+	const auto it = m_flows.find(city_id);
+	return it == m_flows.end() ? no_flows : it->second;
+}
+
+const std::unordered_set<RegionId>& CommutingModel::GetConnectedRegions(RegionId region_id) const
+{
+	static const std::unordered_set<RegionId> no_regions;
+	return region_id < m_connected_regions.size() ? m_connected_regions[region_id] : no_regions;
+}
+
+const geo::City* CommutingModel::FindNearestCity(RegionId region_id, const geo::GeoPosition& position) const
+{
+	const geo::City* result = nullptr;
+	double nearest = std::numeric_limits<double>::infinity();
+	for (const auto& city : GetCities(region_id)) {
+		const double distance = position.Distance(city.geo_position);
+		if (distance < nearest) {
+			nearest = distance;
+			result = &city;
+		}
+	}
+	return result;
+}
+
+CommutingModelRef CommutingModel::Parse(const std::string& file_name, const std::vector<RegionTravelRef>& region_models)
+{
+	// Regions that read their population from a file have no profile, and thus no cities.
+	std::vector<std::vector<geo::City>> region_cities(region_models.size());
+	for (const auto& region : region_models) {
+		const auto profile_path = region->GetRegionGeodistributionProfilePath();
+		if (!profile_path.empty()) {
+			const auto profile_file = util::InstallDirs::OpenDataFile(profile_path);
+			region_cities.at(region->GetRegionId()) = geo::Profile::Parse(*profile_file)->GetCities();
+		}
+	}
+
+	const auto flows_file = util::InstallDirs::OpenDataFile(file_name);
+	return std::make_shared<CommutingModel>(region_cities, *flows_file);
+}
+
+} // namespace
+} // namespace
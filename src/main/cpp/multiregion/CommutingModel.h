@@ -0,0 +1,78 @@
+#ifndef COMMUTING_MODEL_H_INCLUDED
+#define COMMUTING_MODEL_H_INCLUDED
+
+/**
+ * @file
+ * Data structures that describe daily commuting between regions.
+ */
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "geo/City.h"
+#include "geo/GeoPosition.h"
+#include "multiregion/TravelModel.h"
+
+namespace stride {
+namespace multiregion {
+
+class CommutingModel;
+using CommutingModelRef = std::shared_ptr<const CommutingModel>;
+
+/**
+ * A flow of commuters: the fraction of the workers of a city who work in a city of another region.
+ */
+struct CommutingFlow final
+{
+	/// The city where the commuters work.
+	geo::CityId city_id;
+
+	/// The region of that city.
+	RegionId region_id;
+
+	/// The fraction of the workers of the departure city who work there.
+	double fraction;
+};
+
+/**
+ * Describes the daily commuting between regions, with the origin-destination flows of a commuting file. Every city
+ * belongs to the first region whose geodistribution profile lists it. Only the flows between cities of different
+ * regions are kept: commuting within a region is part of its population model.
+ */
+class CommutingModel final
+{
+public:
+	/// Creates a commuting model from the cities of every region, indexed by region id, and a file of flows with
+	/// the columns city_depart, city_arrival and proportion.
+	CommutingModel(const std::vector<std::vector<geo::City>>& region_cities, std::istream& flows_file);
+
+	/// Gets the cities of the given region.
+	const std::vector<geo::City>& GetCities(RegionId region_id) const;
+
+	/// Gets the flows from the given city to cities of other regions.
+	const std::vector<CommutingFlow>& GetFlows(geo::CityId city_id) const;
+
+	/// Gets the set of region ids for regions that exchange commuters with the given region.
+	const std::unordered_set<RegionId>& GetConnectedRegions(RegionId region_id) const;
+
+	/// Finds the city of the given region that is nearest to a position. Returns null if the region has no
+	/// cities.
+	const geo::City* FindNearestCity(RegionId region_id, const geo::GeoPosition& position) const;
+
+	/// Parses the commuting file with the given name in the data directory, for the cities of the
+	/// geodistribution profiles of the given regions.
+	static CommutingModelRef Parse(const std::string& file_name, const std::vector<RegionTravelRef>& region_models);
+
+private:
+	std::vector<std::vector<geo::City>> m_region_cities;
+	std::unordered_map<geo::CityId, std::vector<CommutingFlow>> m_flows;
+	std::vector<std::unordered_set<RegionId>> m_connected_regions;
+};
+
+} // namespace
+} // namespace
+
+#endif // end-of-include-guard
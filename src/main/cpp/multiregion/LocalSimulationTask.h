@@ -12,6 +12,7 @@
 #include "multiregion/Visitor.h"
 #include "sim/Simulator.h"
 #include "sim/SimulatorBuilder.h"
+#include "util/Trace.h"
 
 namespace stride {
 namespace multiregion {
@@ -26,8 +27,14 @@ public:
 	template <typename... TInitialResultArgs>
 	LocalSimulationTask(
 	    const std::shared_ptr<Simulator>& sim, const TCommunicator& communicator, TInitialResultArgs... args)
-	    : sim(sim), communicator(communicator), result(args...)
+	    : sim(sim), communicator(communicator), result(args...),
+	      connected_regions(sim->GetConfiguration().travel_model->GetConnectedRegions())
 	{
+		const auto& commuting_model = sim->GetConfiguration().common_config->commuting_model;
+		if (commuting_model) {
+			const auto& commuting_regions = commuting_model->GetConnectedRegions(sim->GetRegionId());
+			connected_regions.insert(commuting_regions.begin(), commuting_regions.end());
+		}
 	}
 
 	/// Fetches this simulation task's result.
@@ -39,10 +46,16 @@ public:
 	/// Performs a single step in the simulation.
 	void Step()
 	{
-		auto pull_data = communicator.Pull();
+		const int region = sim->GetRegionId();
+		SimulationStepInput pull_data;
+		{
+			util::TraceSpan span("Pull", "multiregion", region);
+			pull_data = communicator.Pull();
+		}
 		result.BeforeSimulatorStep(*sim);
 		auto push_data = sim->TimeStep(pull_data);
 		result.AfterSimulatorStep(*sim);
+		util::TraceSpan span("Push", "multiregion", region);
 		communicator.Push(push_data);
 	}
 
@@ -52,16 +65,14 @@ public:
 		return apply(sim->GetPopulation());
 	}
 
-	/// Gets the set of all regions that are connected to this region by an air route.
-	const std::unordered_set<RegionId>& GetConnectedRegions() const
-	{
-		return sim->GetConfiguration().travel_model->GetConnectedRegions();
-	}
+	/// Gets the set of all regions that are connected to this region by an air route or by commuters.
+	const std::unordered_set<RegionId>& GetConnectedRegions() const { return connected_regions; }
 
 private:
 	std::shared_ptr<Simulator> sim;
 	TCommunicator communicator;
 	TResult result;
+	std::unordered_set<RegionId> connected_regions;
 };
 }
 }
@@ -6,6 +6,8 @@
  * Parallel multi-region data structures for the simulator.
  */
 
+#include <exception>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -15,6 +17,7 @@
 #include "multiregion/SimulationManager.h"
 #include "sim/Simulator.h"
 #include "sim/SimulatorBuilder.h"
+#include "util/Trace.h"
 
 namespace stride {
 namespace multiregion {
@@ -67,6 +70,7 @@ private:
 	std::size_t number_of_task_threads;
 	unsigned int number_of_sim_threads;
 	volatile std::size_t active_task_count;
+	std::exception_ptr failure;
 
 public:
 	ParallelSimulationManager(std::size_t number_of_task_threads, unsigned int number_of_sim_threads)
@@ -91,13 +95,17 @@ public:
 		return task;
 	}
 
-	/// Waits for all tasks to complete.
+	/// Waits for all tasks to complete. Rethrows the first exception of a step, once every thread has stopped.
 	void WaitAll() final override
 	{
 		// Start 'number_of_task_threads' threads.
 		std::vector<std::thread> threads;
 		for (std::size_t i = 0; i < number_of_task_threads; i++) {
 			threads.emplace_back([this]() {
+				// The time this thread started waiting for a task that is ready, if it is waiting.
+				bool waiting = false;
+				util::Tracer::Clock::time_point wait_start;
+
 				// We will leave at least one thread running until the number of active tasks reaches
 				// zero.
 				while (active_task_count > 0) {
@@ -105,9 +113,21 @@ public:
 					// task twice.
 					comm_mutex.lock();
 
+					// A failed task stops every thread, as the tasks that depend on it can't go on.
+					if (failure) {
+						comm_mutex.unlock();
+						break;
+					}
+
 					// Try to pop a task that's ready to perform a time step.
 					RegionId ready_id;
 					if (TryPopReady(ready_id)) {
+						if (waiting) {
+							util::Tracer::AddSpan(
+							    "WaitForRegion", "multiregion", util::Tracer::NoRegion,
+							    wait_start, util::Tracer::Clock::now());
+							waiting = false;
+						}
 						auto task = tasks[ready_id];
 						if (task->IsDone()) {
 							// This task's done. We ought to decrement the active task
@@ -123,12 +143,23 @@ public:
 							// Have the task perform a single step. Release the
 							// communication lock early so other threads can proceed.
 							comm_mutex.unlock();
-							task->Step();
+							try {
+								task->Step();
+							} catch (...) {
+								std::lock_guard<std::mutex> lock(comm_mutex);
+								if (!failure) {
+									failure = std::current_exception();
+								}
+							}
 						}
 					} else {
 						// No task was ready. Free the lock to give the other tasks the
 						// opportunity to push their outputs and try again.
 						comm_mutex.unlock();
+						if (!waiting && util::Tracer::IsEnabled()) {
+							waiting = true;
+							wait_start = util::Tracer::Clock::now();
+						}
 					}
 				}
 			});
@@ -137,6 +168,9 @@ public:
 		for (auto& t : threads) {
 			t.join();
 		}
+		if (failure) {
+			std::rethrow_exception(failure);
+		}
 	}
 };
 
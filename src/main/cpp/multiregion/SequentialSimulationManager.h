@@ -55,6 +55,22 @@ public:
 		pull_buffers[source_region_phase].expatriates.emplace_back(expatriate);
 	}
 
+	/// Pushes the report on the commuters of the given region into this buffer.
+	void PushCommuters(std::size_t source_region_phase, RegionId source_region_id, const CommuterReport& report)
+	{
+		auto& commuters = pull_buffers[source_region_phase].commuters;
+		commuters.push_back(report);
+		commuters.back().region_id = source_region_id;
+	}
+
+	/// Pushes the commuters of this buffer's region who were infected in the given region into this buffer.
+	void PushCommuterInfections(
+	    std::size_t source_region_phase, RegionId source_region_id, const CommuterInfections& infections)
+	{
+		pull_buffers[source_region_phase].commuter_infections.push_back(
+		    {source_region_id, infections.commuters});
+	}
+
 	/// Sets this buffer's dependencies to the given set of dependencies.
 	void ResetDependencies(const std::unordered_set<RegionId>& new_unsatisfied_dependencies)
 	{
@@ -104,6 +120,12 @@ public:
 		for (const auto& returning_expatriate : data.expatriates) {
 			buffers[returning_expatriate.visited_region].PushExpatriate(phase, returning_expatriate.person);
 		}
+		for (const auto& report : data.commuters) {
+			buffers[report.region_id].PushCommuters(phase, id, report);
+		}
+		for (const auto& infections : data.commuter_infections) {
+			buffers[infections.region_id].PushCommuterInfections(phase, id, infections);
+		}
 		for (const auto& dep : dependencies) {
 			auto& buf = buffers[dep];
 			buf.SatisfyDependency(id);
@@ -2,6 +2,8 @@
 #define VISITOR_H_INCLUDED
 
 #include <vector>
+#include "core/Health.h"
+#include "geo/City.h"
 #include "multiregion/TravelModel.h"
 #include "pop/Person.h"
 
@@ -52,6 +54,38 @@ struct IncomingVisitor final
 	std::size_t return_day;
 };
 
+/**
+ * The daily report of a home region on its commuters who work in another region: their health, in the order of
+ * the home region's list of those commuters. The first report also describes the commuters, so the work region
+ * can assign them to its work clusters.
+ */
+struct CommuterReport final
+{
+	/// The work region in a step's output, and the home region in a step's input.
+	RegionId region_id;
+
+	/// The health of every commuter.
+	std::vector<Health> health;
+
+	/// The age of every commuter, in the first report only.
+	std::vector<double> ages;
+
+	/// The city where every commuter works, in the first report only.
+	std::vector<geo::CityId> cities;
+};
+
+/**
+ * The commuters of a home region who were infected at work, as indices in the home region's list of commuters.
+ */
+struct CommuterInfections final
+{
+	/// The home region in a step's output, and the work region in a step's input.
+	RegionId region_id;
+
+	/// The indices of the infected commuters.
+	std::vector<std::size_t> commuters;
+};
+
 /// The input for a single step in the simulation and the result
 /// of a pull operation.
 struct SimulationStepInput final
@@ -61,6 +95,12 @@ struct SimulationStepInput final
 
 	/// The list of all returning expatriates.
 	std::vector<Person> expatriates;
+
+	/// The reports of the home regions of the commuters who work in this region.
+	std::vector<CommuterReport> commuters;
+
+	/// The commuters of this region who were infected at work in other regions.
+	std::vector<CommuterInfections> commuter_infections;
 };
 
 /// The output for a single step in the simulation and the result
@@ -72,6 +112,12 @@ struct SimulationStepOutput final
 
 	/// The list of all returning expatriates.
 	std::vector<OutgoingVisitor> expatriates;
+
+	/// The reports on this region's commuters, per work region.
+	std::vector<CommuterReport> commuters;
+
+	/// The commuters of other regions who were infected at work in this region, per home region.
+	std::vector<CommuterInfections> commuter_infections;
 };
 }
 }
@@ -8,6 +8,7 @@
 #include "multiregion/TravelModel.h"
 #include "pop/Person.h"
 #include "util/Errors.h"
+#include "util/MemoryAccount.h"
 #include "util/Parallel.h"
 
 /**
@@ -70,6 +71,16 @@ public:
 		}
 	}
 
+	/// The memory of the journal, with the data of the expatriates, which isn't in the population while
+	/// they're away.
+	util::MemoryUsage GetMemoryUsage() const
+	{
+		auto usage = util::GetMemoryUsage(expatriates);
+		usage.used += expatriates.size() * sizeof(PersonData);
+		usage.allocated += expatriates.size() * (sizeof(PersonData) + 2 * sizeof(void*));
+		return usage;
+	}
+
 private:
 	/// A dictionary that maps expatriate person ids to personal information.
 	std::unordered_map<PersonId, Person> expatriates;
@@ -117,6 +128,20 @@ public:
 		return visitors;
 	}
 
+	/// The memory of the journal: the visitors per day and region, and the set of their ids.
+	util::MemoryUsage GetMemoryUsage() const
+	{
+		auto usage = util::GetMemoryUsage(visitors);
+		for (const auto& day : visitors) {
+			usage += util::GetMemoryUsage(day.second);
+			for (const auto& region : day.second) {
+				usage += util::GetMemoryUsage(region.second);
+			}
+		}
+		usage += util::GetMemoryUsage(visitor_ids);
+		return usage;
+	}
+
 private:
 	/// A dictionary of visitors, grouped by the day of their return trip and the region
 	/// that sent them.
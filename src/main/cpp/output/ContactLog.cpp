@@ -0,0 +1,127 @@
+/**
+ * @file
+ * Implementation of the ContactLog class.
+ */
+
+#include "ContactLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <spdlog/spdlog.h>
+#include "util/Errors.h"
+
+namespace stride {
+namespace output {
+
+using namespace std;
+
+constexpr std::uint32_t ContactLog::Version;
+
+void* ContactLog::Buffer::operator new(std::size_t size)
+{
+	void* result = nullptr;
+	if (posix_memalign(&result, alignof(Buffer), size) != 0) {
+		throw bad_alloc();
+	}
+	return result;
+}
+
+std::size_t ContactLog::Buffer::Drain(std::ostream& out)
+{
+	auto tail = m_tail.load(memory_order_relaxed);
+	const auto head = m_head.load(memory_order_acquire);
+	const auto count = head - tail;
+	while (tail != head) {
+		// Write up to the end of the ring in one go.
+		const auto begin = tail & (m_records.size() - 1);
+		const auto length = min(head - tail, m_records.size() - begin);
+		out.write(reinterpret_cast<const char*>(&m_records[begin]), length * sizeof(ContactRecord));
+		tail += length;
+	}
+	m_tail.store(tail, memory_order_release);
+	return count;
+}
+
+ContactLog::ContactLog(const std::string& file, unsigned int num_threads, std::size_t buffer_capacity)
+    : m_stop(false)
+{
+	if (buffer_capacity == 0 || (buffer_capacity & (buffer_capacity - 1)) != 0) {
+		FATAL_ERROR("The buffer capacity has to be a power of two.");
+	}
+	m_fstream.open(file.c_str(), ios::binary);
+	m_fstream.write("STRIDECL", 8);
+	const uint32_t header[] = {Version, sizeof(ContactRecord)};
+	m_fstream.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	for (unsigned int i = 0; i < max(num_threads, 1U); i++) {
+		m_buffers.emplace_back(new Buffer(buffer_capacity));
+	}
+	m_writer = thread(&ContactLog::WriterLoop, this);
+}
+
+ContactLog::~ContactLog()
+{
+	m_stop = true;
+	m_writer.join();
+	m_fstream.close();
+}
+
+std::size_t ContactLog::DrainAll()
+{
+	size_t count = 0;
+	for (auto& buffer : m_buffers) {
+		count += buffer->Drain(m_fstream);
+	}
+	return count;
+}
+
+void ContactLog::WriterLoop()
+{
+	while (!m_stop) {
+		if (DrainAll() == 0) {
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+	// The simulator is done: write what is left.
+	DrainAll();
+	m_fstream.flush();
+}
+
+void ContactLog::Decode(std::istream& in, std::ostream& out)
+{
+	char magic[8];
+	uint32_t header[2];
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (!in || memcmp(magic, "STRIDECL", sizeof(magic)) != 0) {
+		FATAL_ERROR("Not a contact log.");
+	}
+	if (header[0] != Version || header[1] != sizeof(ContactRecord)) {
+		FATAL_ERROR("Unsupported contact log version " + to_string(header[0]) + ".");
+	}
+
+	ContactRecord r;
+	fmt::MemoryWriter line;
+	while (in.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+		const auto cluster_type = static_cast<ClusterType>(r.cluster_type);
+		line.clear();
+		if (r.kind == ContactRecord::Transmission) {
+			line.write("[TRAN] {} {} {} {}", r.person1, r.person2, ToString(cluster_type), r.day);
+		} else {
+			line.write(
+			    "[CONT] {} {} {} {} {} {} {} {} {}", r.person1, r.age1, r.age2,
+			    static_cast<unsigned int>(cluster_type == ClusterType::Household),
+			    static_cast<unsigned int>(cluster_type == ClusterType::School),
+			    static_cast<unsigned int>(cluster_type == ClusterType::Work),
+			    static_cast<unsigned int>(cluster_type == ClusterType::PrimaryCommunity),
+			    static_cast<unsigned int>(cluster_type == ClusterType::SecondaryCommunity), r.day);
+		}
+		out << line.str() << '\n';
+	}
+}
+
+} // end_of_namespace
+} // end_of_namespace
@@ -0,0 +1,126 @@
+#ifndef CONTACT_LOG_H_INCLUDED
+#define CONTACT_LOG_H_INCLUDED
+
+/**
+ * @file
+ * Header for the ContactLog class.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/ClusterType.h"
+
+namespace stride {
+namespace output {
+
+/**
+ * A contact or transmission, as a fixed size record. A contact is logged as
+ * "[CONT] <person1 id> <person1 age> <person2 age> <at home> <at school> <at work> <at primary community>
+ * <at secondary community> <day>", a transmission as "[TRAN] <infecter id> <infected id> <cluster type> <day>".
+ */
+struct ContactRecord
+{
+	enum Kind : std::uint8_t
+	{
+		Contact = 0U,
+		Transmission = 1U
+	};
+
+	std::uint8_t kind;
+	std::uint8_t cluster_type;
+	std::uint16_t reserved;
+	std::uint32_t day;
+	std::uint32_t person1;
+	std::uint32_t person2;
+	double age1;
+	double age2;
+};
+
+/**
+ * Writes contact and transmission records to a binary file. Every thread of the simulator appends its records
+ * to its own lock-free ring buffer, and a writer thread moves them from the buffers to the file, so the
+ * simulator never waits on the file unless a buffer is full. The file holds "STRIDECL", a uint32 version,
+ * a uint32 record size and the records, in native byte order. Decode turns it back into the text log.
+ */
+class ContactLog
+{
+public:
+	/// The version of the file format.
+	static constexpr std::uint32_t Version = 1;
+
+	/// A ring buffer with a single producer (a simulator thread) and a single consumer (the writer thread).
+	class Buffer
+	{
+	public:
+		/// Creates a buffer with room for `capacity` records, which has to be a power of two.
+		explicit Buffer(std::size_t capacity) : m_records(capacity), m_head(0), m_tail(0) {}
+
+		/// Appends a record. If the buffer is full, this waits until the writer has made room.
+		void Push(const ContactRecord& record)
+		{
+			const auto head = m_head.load(std::memory_order_relaxed);
+			while (head - m_tail.load(std::memory_order_acquire) == m_records.size()) {
+				std::this_thread::yield();
+			}
+			m_records[head & (m_records.size() - 1)] = record;
+			m_head.store(head + 1, std::memory_order_release);
+		}
+
+		/// Moves the records that were pushed so far to the stream. Returns the number of records.
+		std::size_t Drain(std::ostream& out);
+
+		/// Allocates a buffer on a cache line boundary, which new doesn't do for extended alignments
+		/// before C++17.
+		static void* operator new(std::size_t size);
+
+		/// Frees a buffer allocated by operator new.
+		static void operator delete(void* buffer) { std::free(buffer); }
+
+	private:
+		// The simulator thread writes the head and the writer thread writes the tail, so each gets a cache line.
+		std::vector<ContactRecord> m_records;
+		alignas(64) std::atomic<std::size_t> m_head; ///< The number of records pushed.
+		alignas(64) std::atomic<std::size_t> m_tail; ///< The number of records drained.
+	};
+
+	/// Opens the file and starts the writer thread, with a buffer for each of the simulator's threads.
+	ContactLog(const std::string& file, unsigned int num_threads, std::size_t buffer_capacity = 1U << 16);
+
+	/// Writes the remaining records, stops the writer thread and closes the file.
+	~ContactLog();
+
+	ContactLog(const ContactLog&) = delete;
+	ContactLog& operator=(const ContactLog&) = delete;
+
+	/// Gets the buffer of a thread. Each thread should only push to its own buffer.
+	Buffer& GetBuffer(unsigned int thread) { return *m_buffers[thread]; }
+
+	/// Reads a binary contact log and writes it as text, with one "[CONT]" or "[TRAN]" line per record.
+	static void Decode(std::istream& in, std::ostream& out);
+
+private:
+	/// Moves records from the buffers to the file until the log is destroyed.
+	void WriterLoop();
+
+	/// Moves the records of every buffer to the file. Returns the number of records.
+	std::size_t DrainAll();
+
+private:
+	std::ofstream m_fstream;
+	std::vector<std::unique_ptr<Buffer>> m_buffers;
+	std::atomic<bool> m_stop;
+	std::thread m_writer;
+};
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end of include guard
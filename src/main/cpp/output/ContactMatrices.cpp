@@ -0,0 +1,94 @@
+/**
+ * @file
+ * Implementation of the ContactMatrices class.
+ */
+
+#include "ContactMatrices.h"
+
+#include <algorithm>
+#include "util/Errors.h"
+
+namespace stride {
+namespace output {
+
+using namespace std;
+
+constexpr unsigned int ContactMatrices::MaxAge;
+constexpr std::size_t ContactMatrices::NumOfAges;
+
+void ContactMatrices::Counts::Clear()
+{
+	fill(m_participants.begin(), m_participants.end(), 0U);
+	fill(m_contacts.begin(), m_contacts.end(), 0U);
+}
+
+ContactMatrices::ContactMatrices(const std::string& file, unsigned int num_threads, bool per_day, double sample_rate)
+    : m_per_day(per_day), m_thread_counts(max(num_threads, 1U), Counts(sample_rate)), m_total(sample_rate)
+{
+	if (sample_rate < 0.0 || sample_rate > 1.0) {
+		FATAL_ERROR("The contact sample rate has to be between 0 and 1.");
+	}
+	m_fstream.open(file.c_str());
+	m_fstream << "day;cluster_type;part_age;participants";
+	for (size_t age = 0; age < NumOfAges; age++) {
+		m_fstream << ";age" << age;
+	}
+	m_fstream << '\n';
+}
+
+ContactMatrices::~ContactMatrices()
+{
+	if (!m_per_day) {
+		Print("all");
+	}
+	m_fstream.close();
+}
+
+void ContactMatrices::EndDay(std::size_t day)
+{
+	for (auto& counts : m_thread_counts) {
+		for (size_t i = 0; i < counts.m_participants.size(); i++) {
+			m_total.m_participants[i] += counts.m_participants[i];
+		}
+		for (size_t i = 0; i < counts.m_contacts.size(); i++) {
+			m_total.m_contacts[i] += counts.m_contacts[i];
+		}
+		counts.Clear();
+	}
+	if (m_per_day) {
+		Print(to_string(day));
+		m_total.Clear();
+	}
+}
+
+bool ContactMatrices::IsSampled(std::uint32_t id, double sample_rate)
+{
+	// A fixed mix of the id (splitmix64), so that the sample doesn't depend on the order of the contacts.
+	uint64_t z = id + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z = z ^ (z >> 31);
+	return static_cast<double>(z >> 11) / static_cast<double>(1ULL << 53) < sample_rate;
+}
+
+void ContactMatrices::Print(const std::string& day)
+{
+	for (size_t type = 0; type < NumOfClusterTypes(); type++) {
+		const auto cluster_type = ToString(static_cast<ClusterType>(type));
+		for (size_t part_age = 0; part_age < NumOfAges; part_age++) {
+			const auto row = type * NumOfAges + part_age;
+			if (m_total.m_participants[row] == 0) {
+				continue;
+			}
+			m_fstream << day << ';' << cluster_type << ';' << part_age << ';' << m_total.m_participants[row];
+			for (size_t cnt_age = 0; cnt_age < NumOfAges; cnt_age++) {
+				m_fstream << ';' << m_total.m_contacts[row * NumOfAges + cnt_age];
+			}
+			m_fstream << '\n';
+		}
+	}
+	m_fstream.flush();
+}
+
+} // end_of_namespace
+} // end_of_namespace
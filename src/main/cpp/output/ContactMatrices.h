@@ -0,0 +1,125 @@
+#ifndef CONTACT_MATRICES_H_INCLUDED
+#define CONTACT_MATRICES_H_INCLUDED
+
+/**
+ * @file
+ * Header for the ContactMatrices class.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "core/ClusterType.h"
+#include "pop/Person.h"
+
+namespace stride {
+namespace output {
+
+/**
+ * Aggregates the contacts of participants (the survey participants, or a sample of the population) into age
+ * by age contact matrices per cluster type, instead of logging every contact. Every thread of the simulator
+ * counts in its own matrices, which are added up and written at the end of every day, or once at the end of
+ * the run.
+ *
+ * The file has a header line and a line per day, cluster type and participant age:
+ * "day;cluster_type;part_age;participants;age0;...;age100", where "participants" is the number of times a
+ * participant of that age was present in a cluster of that type, and "ageN" the number of contacts with
+ * persons of age N. Ages above 100 are counted as 100. When the matrices are written per run, the day is "all".
+ */
+class ContactMatrices
+{
+public:
+	/// The highest age of the matrices.
+	static constexpr unsigned int MaxAge = 100;
+
+	/// The number of ages in the matrices.
+	static constexpr std::size_t NumOfAges = MaxAge + 1;
+
+	/// The contacts counted by one thread.
+	class Counts
+	{
+	public:
+		explicit Counts(double sample_rate)
+		    : m_sample_rate(sample_rate), m_participants(NumOfClusterTypes() * NumOfAges),
+		      m_contacts(NumOfClusterTypes() * NumOfAges * NumOfAges)
+		{
+		}
+
+		/// Whether the contacts of a person are counted. With a sample rate, that fraction of the persons
+		/// takes part, chosen by original id, so renumbering the population doesn't change the sample;
+		/// otherwise the survey participants do.
+		bool IsParticipant(const Person& person) const
+		{
+			return m_sample_rate > 0.0 ? IsSampled(person.GetOriginalId(), m_sample_rate)
+						   : person.IsParticipatingInSurvey();
+		}
+
+		/// Counts a participant that is present in a cluster.
+		void AddParticipant(ClusterType cluster_type, double age)
+		{
+			m_participants[Index(cluster_type, age)]++;
+		}
+
+		/// Counts a contact of a participant in a cluster.
+		void AddContact(ClusterType cluster_type, double participant_age, double contact_age)
+		{
+			m_contacts[Index(cluster_type, participant_age) * NumOfAges + Age(contact_age)]++;
+		}
+
+	private:
+		friend class ContactMatrices;
+
+		/// The index of a cluster type and age in m_participants.
+		static std::size_t Index(ClusterType cluster_type, double age)
+		{
+			return ToSizeType(cluster_type) * NumOfAges + Age(age);
+		}
+
+		/// The age in the matrices of a person with the given age.
+		static std::size_t Age(double age) { return age < MaxAge ? static_cast<std::size_t>(age) : MaxAge; }
+
+		/// Clears the counts.
+		void Clear();
+
+		double m_sample_rate;
+		std::vector<std::uint64_t> m_participants; ///< By cluster type and participant age.
+		std::vector<std::uint64_t> m_contacts;	 ///< By cluster type, participant age and contact age.
+	};
+
+	/// Opens the file. Counts are written every day if `per_day` is set, and at the end of the run otherwise.
+	/// A sample rate in (0, 1] picks that fraction of the population as participants; 0 picks the survey
+	/// participants.
+	ContactMatrices(const std::string& file, unsigned int num_threads, bool per_day, double sample_rate);
+
+	/// Writes the counts of the run, if they aren't written per day, and closes the file.
+	~ContactMatrices();
+
+	ContactMatrices(const ContactMatrices&) = delete;
+	ContactMatrices& operator=(const ContactMatrices&) = delete;
+
+	/// Gets the counts of a thread. Each thread should only count in its own counts.
+	Counts& GetCounts(unsigned int thread) { return m_thread_counts[thread]; }
+
+	/// Adds up the counts of the threads at the end of a day, and writes them if they are written per day.
+	void EndDay(std::size_t day);
+
+	/// Whether the person with the given id is part of a sample with the given rate.
+	static bool IsSampled(std::uint32_t id, double sample_rate);
+
+private:
+	/// Writes the total counts, as the counts of the given day.
+	void Print(const std::string& day);
+
+private:
+	std::ofstream m_fstream;
+	bool m_per_day;
+	std::vector<Counts> m_thread_counts;
+	Counts m_total;
+};
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end of include guard
@@ -2,39 +2,113 @@
 
 #include "core/Health.h"
 
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
+#include <spdlog/spdlog.h>
 
 namespace stride {
 namespace output {
 
 using namespace std;
 
-PersonFile::PersonFile(const std::string& file) { Initialize(file); }
+constexpr std::uint32_t PersonFile::Version;
+constexpr std::size_t PersonFile::NumOfColumns;
+
+PersonFile::PersonFile(const std::string& file, bool binary) : m_binary(binary) { Initialize(file); }
 
 PersonFile::~PersonFile() { m_fstream.close(); }
 
+const std::vector<std::string>& PersonFile::GetColumnNames()
+{
+	static const vector<string> names{"id",		     "is_recovered",      "is_immune",      "start_infectiousness",
+					  "end_infectiousness", "start_symptomatic", "end_symptomatic"};
+	return names;
+}
+
 void PersonFile::Initialize(const std::string& file)
 {
-	m_fstream.open((file + "_person.csv").c_str());
+	if (m_binary) {
+		m_fstream.open((file + "_person.bin").c_str(), ios::binary);
+	} else {
+		m_fstream.open((file + "_person.csv").c_str());
+
+		// add header
+		m_fstream << "id,is_recovered,is_immune,start_infectiousness;"
+			  << "end_infectiousness,start_symptomatic,end_symptomatic\n";
+	}
+}
+
+void PersonFile::Print(const PopulationRef& population, unsigned int num_threads)
+{
+	num_threads = max(num_threads, 1U);
+	if (m_binary) {
+		PrintBinary(population, num_threads);
+	} else {
+		PrintText(population, num_threads);
+	}
+	m_fstream.flush();
+}
 
-	// add header
-	m_fstream << "id,is_recovered,is_immune,start_infectiousness;"
-		  << "end_infectiousness,start_symptomatic,end_symptomatic" << endl;
+void PersonFile::PrintText(const PopulationRef& population, unsigned int num_threads)
+{
+	// Every thread gets a contiguous range of ids, so the buffers are in the order of the population.
+	vector<fmt::MemoryWriter> buffers(num_threads);
+	population->parallel_for(num_threads, [&buffers](const Person& p, unsigned int thread) {
+		const auto& h = p.GetHealth();
+		if (!h.IsSusceptible()) {
+			buffers[thread] << p.GetOriginalId() << ',' << static_cast<unsigned int>(h.IsRecovered())
+					<< ',' << static_cast<unsigned int>(h.IsImmune()) << ','
+					<< h.GetStartInfectiousness() << ',' << h.GetEndInfectiousness() << ','
+					<< h.GetStartSymptomatic() << ',' << h.GetEndSymptomatic() << '\n';
+		}
+	});
+	for (const auto& buffer : buffers) {
+		m_fstream.write(buffer.data(), buffer.size());
+	}
 }
 
-void PersonFile::Print(const PopulationRef& population)
+void PersonFile::PrintBinary(const PopulationRef& population, unsigned int num_threads)
 {
-	population->serial_for([this](const Person& p, unsigned int) {
+	using Columns = array<vector<uint32_t>, NumOfColumns>;
+	vector<Columns> buffers(num_threads);
+	population->parallel_for(num_threads, [&buffers](const Person& p, unsigned int thread) {
 		const auto& h = p.GetHealth();
 		if (!h.IsSusceptible()) {
-			m_fstream << p.GetId() << "," << h.IsRecovered() << "," << h.IsImmune() << ","
-				  << h.GetStartInfectiousness() << "," << h.GetEndInfectiousness() << ","
-				  << h.GetStartSymptomatic() << "," << h.GetEndSymptomatic() << endl;
+			auto& columns = buffers[thread];
+			columns[0].push_back(p.GetOriginalId());
+			columns[1].push_back(h.IsRecovered());
+			columns[2].push_back(h.IsImmune());
+			columns[3].push_back(h.GetStartInfectiousness());
+			columns[4].push_back(h.GetEndInfectiousness());
+			columns[5].push_back(h.GetStartSymptomatic());
+			columns[6].push_back(h.GetEndSymptomatic());
 		}
 	});
+
+	uint64_t num_rows = 0;
+	for (const auto& columns : buffers) {
+		num_rows += columns[0].size();
+	}
+	m_fstream.write("STRIDEPF", 8);
+	const uint32_t header[] = {Version, NumOfColumns};
+	m_fstream.write(reinterpret_cast<const char*>(header), sizeof(header));
+	m_fstream.write(reinterpret_cast<const char*>(&num_rows), sizeof(num_rows));
+	for (const auto& name : GetColumnNames()) {
+		const uint32_t length = name.size();
+		m_fstream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+		m_fstream.write(name.data(), length);
+	}
+	for (size_t column = 0; column < NumOfColumns; column++) {
+		for (const auto& columns : buffers) {
+			m_fstream.write(
+			    reinterpret_cast<const char*>(columns[column].data()), columns[column].size() * sizeof(uint32_t));
+		}
+	}
 }
 
 } // end_of_namespace
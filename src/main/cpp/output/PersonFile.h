@@ -3,6 +3,7 @@
 
 #include "pop/Population.h"
 
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <string>
@@ -12,25 +13,47 @@ namespace stride {
 namespace output {
 
 /**
- * Produces a file with daily cases count.
+ * Produces a file with the health of every person that isn't susceptible at the end of the run.
+ *
+ * By default, this is the "<file>_person.csv" text file. The binary variant, "<file>_person.bin", is stored
+ * by column: it holds "STRIDEPF", a uint32 version, a uint32 number of columns, a uint64 number of rows, the
+ * column names (each a uint32 length and the characters), and then every column as uint32 values, in native
+ * byte order. Either way, the persons are in the order of the population and have their original ids.
  */
 class PersonFile
 {
 public:
+	/// The version of the binary file format.
+	static constexpr std::uint32_t Version = 1;
+
+	/// The number of columns of the file.
+	static constexpr std::size_t NumOfColumns = 7;
+
 	/// Constructor: initialize.
-	PersonFile(const std::string& file = "stride_person");
+	PersonFile(const std::string& file = "stride_person", bool binary = false);
 
 	/// Destructor: close the file stream.
 	~PersonFile();
 
-	/// Print the given cases with corresponding tag.
-	void Print(const PopulationRef& population);
+	/// Print the persons of the population. Every thread formats a chunk of the population in its own
+	/// buffer; the buffers are then written in order.
+	void Print(const PopulationRef& population, unsigned int num_threads = 1);
+
+	/// Gets the names of the columns.
+	static const std::vector<std::string>& GetColumnNames();
 
 private:
 	/// Generate file name and open the file stream.
 	void Initialize(const std::string& file);
 
+	/// Print the persons as text.
+	void PrintText(const PopulationRef& population, unsigned int num_threads);
+
+	/// Print the persons by column.
+	void PrintBinary(const PopulationRef& population, unsigned int num_threads);
+
 private:
+	bool m_binary;
 	std::ofstream m_fstream;
 };
 
@@ -1,8 +1,10 @@
 #include "SummaryFile.h"
 
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <boost/property_tree/ptree.hpp>
+#include <spdlog/spdlog.h>
 #include "util/Parallel.h"
 
 namespace stride {
@@ -17,7 +19,7 @@ SummaryFile::SummaryFile(const std::string& file)
 	// add header
 	m_fstream << "pop_file,num_days,pop_size,seeding_rate,"
 		  << "R0,transm_rate,immunity_rate,num_threads,rng_seed,run_time,"
-		  << "total_time,num_cases,AR" << endl;
+		  << "total_time,num_cases,AR\n";
 }
 
 SummaryFile::~SummaryFile() { m_fstream.close(); }
@@ -28,13 +30,17 @@ void SummaryFile::Print(
 {
 	unsigned int num_threads = util::parallel::get_number_of_threads();
 
-	m_fstream << config.GetPopulationPath() << "," << config.common_config->number_of_days << "," << population_size
-		  << "," << config.common_config->seeding_rate << "," << config.common_config->r0 << ","
-		  << "NA"
-		  << "," // << pt_config.get<double>("run.transmission_rate") << ";"
-		  << config.common_config->immunity_rate << "," << num_threads << "," << config.common_config->rng_seed
-		  << "," << run_time << "," << total_time << "," << num_cases << ","
-		  << static_cast<double>(num_cases) / population_size << endl;
+	// Format the line in memory and write it at once.
+	fmt::MemoryWriter line;
+	line << config.GetPopulationPath() << ',' << config.common_config->number_of_days << ',' << population_size
+	     << ',' << config.common_config->seeding_rate << ',' << config.common_config->r0 << ','
+	     << "NA"
+	     << ',' // << pt_config.get<double>("run.transmission_rate") << ";"
+	     << config.common_config->immunity_rate << ',' << num_threads << ',' << config.common_config->rng_seed
+	     << ',' << run_time << ',' << total_time << ',' << num_cases << ','
+	     << static_cast<double>(num_cases) / population_size << '\n';
+	m_fstream.write(line.data(), line.size());
+	m_fstream.flush();
 }
 
 } // end namespace
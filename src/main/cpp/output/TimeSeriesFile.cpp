@@ -0,0 +1,121 @@
+/**
+ * @file
+ * Implementation of the TimeSeriesFile class.
+ */
+
+#include "TimeSeriesFile.h"
+
+#include <algorithm>
+#include "core/Health.h"
+#include "sim/Simulator.h"
+#include "util/Parallel.h"
+
+namespace stride {
+namespace output {
+
+using namespace std;
+
+constexpr std::size_t TimeSeriesRecord::NumOfStatuses;
+constexpr unsigned int TimeSeriesRecord::AgeGroupWidth;
+constexpr std::size_t TimeSeriesRecord::NumOfAgeGroups;
+constexpr unsigned int TimeSeriesFile::Version;
+
+TimeSeriesRecord TimeSeriesRecord::Count(const Simulator& sim, multiregion::RegionId region, unsigned int day)
+{
+	TimeSeriesRecord result;
+	result.region = region;
+	result.day = day;
+	result.infected_by_town = sim.GetTownInfections();
+
+	// Every thread counts into its own record, which are added up afterwards.
+	const auto num_threads = util::parallel::get_number_of_threads();
+	vector<TimeSeriesRecord> counts(num_threads);
+	for (auto& c : counts) {
+		c.status.fill(0U);
+		c.infected_by_age.fill(0U);
+	}
+	sim.GetPopulation()->parallel_for(num_threads, [&counts](const Person& p, unsigned int thread) {
+		const auto& health = p.GetHealth();
+		counts[thread].status[static_cast<size_t>(health.GetHealthStatus())]++;
+		if (health.IsInfected()) {
+			const auto group = min(static_cast<size_t>(p.GetAge() / AgeGroupWidth), NumOfAgeGroups - 1);
+			counts[thread].infected_by_age[group]++;
+		}
+	});
+
+	result.status.fill(0U);
+	result.infected_by_age.fill(0U);
+	for (const auto& c : counts) {
+		for (size_t i = 0; i < NumOfStatuses; i++) {
+			result.status[i] += c.status[i];
+		}
+		for (size_t i = 0; i < NumOfAgeGroups; i++) {
+			result.infected_by_age[i] += c.infected_by_age[i];
+		}
+	}
+	return result;
+}
+
+unsigned int TimeSeriesRecord::GetCases() const
+{
+	unsigned int cases = 0;
+	for (size_t i = static_cast<size_t>(HealthStatus::Exposed); i <= static_cast<size_t>(HealthStatus::Recovered);
+	     i++) {
+		cases += status[i];
+	}
+	return cases;
+}
+
+TimeSeriesFile::TimeSeriesFile(const std::string& file, const Atlas* atlas) : m_num_towns(0)
+{
+	Initialize(file);
+	PrintHeader(atlas);
+}
+
+TimeSeriesFile::~TimeSeriesFile() { m_fstream.close(); }
+
+void TimeSeriesFile::Initialize(const std::string& file)
+{
+	m_fstream.open((file + "_timeseries.bin").c_str(), ios::binary);
+}
+
+void TimeSeriesFile::PrintHeader(const Atlas* atlas)
+{
+	m_fstream.write("STRIDETS", 8);
+	Write<uint32_t>(Version);
+	Write<uint32_t>(TimeSeriesRecord::NumOfStatuses);
+	Write<uint32_t>(TimeSeriesRecord::NumOfAgeGroups);
+	Write<uint32_t>(TimeSeriesRecord::AgeGroupWidth);
+
+	m_num_towns = atlas ? atlas->GetTowns().size() : 0;
+	Write<uint32_t>(m_num_towns);
+	if (atlas) {
+		for (const auto& town : atlas->getTownMap()) {
+			Write<uint32_t>(town.second.name.size());
+			m_fstream.write(town.second.name.data(), town.second.name.size());
+			Write<uint32_t>(town.second.size);
+			Write<double>(town.first.latitude);
+			Write<double>(town.first.longitude);
+		}
+	}
+	m_fstream.flush();
+}
+
+void TimeSeriesFile::Print(const TimeSeriesRecord& record)
+{
+	// The record is laid out in one buffer, so that it takes a single write.
+	vector<uint32_t> buffer;
+	buffer.reserve(2 + TimeSeriesRecord::NumOfStatuses + TimeSeriesRecord::NumOfAgeGroups + m_num_towns);
+	buffer.push_back(record.region);
+	buffer.push_back(record.day);
+	buffer.insert(buffer.end(), record.status.begin(), record.status.end());
+	buffer.insert(buffer.end(), record.infected_by_age.begin(), record.infected_by_age.end());
+	buffer.insert(buffer.end(), record.infected_by_town.begin(), record.infected_by_town.end());
+	buffer.resize(2 + TimeSeriesRecord::NumOfStatuses + TimeSeriesRecord::NumOfAgeGroups + m_num_towns, 0U);
+
+	m_fstream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(uint32_t));
+	m_fstream.flush();
+}
+
+} // end_of_namespace
+} // end_of_namespace
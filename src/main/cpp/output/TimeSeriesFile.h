@@ -0,0 +1,103 @@
+#ifndef TIME_SERIES_FILE_H_INCLUDED
+#define TIME_SERIES_FILE_H_INCLUDED
+
+/**
+ * @file
+ * Header for the TimeSeriesFile class.
+ */
+
+#include <array>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "core/Atlas.h"
+#include "core/Health.h"
+#include "multiregion/TravelModel.h"
+
+namespace stride {
+
+class Simulator;
+
+namespace output {
+
+/**
+ * The counts of one simulated day: the number of persons with every health status, and the number of
+ * infected persons in every age group and every town.
+ */
+struct TimeSeriesRecord
+{
+	/// The number of health statuses: Immune is the last one.
+	static constexpr std::size_t NumOfStatuses = static_cast<std::size_t>(HealthStatus::Immune) + 1;
+
+	/// The number of years in an age group.
+	static constexpr unsigned int AgeGroupWidth = 10;
+
+	/// The number of age groups. The last group holds everyone older than the other groups.
+	static constexpr std::size_t NumOfAgeGroups = 11;
+
+	multiregion::RegionId region;
+	unsigned int day;
+	std::array<unsigned int, NumOfStatuses> status;
+	std::array<unsigned int, NumOfAgeGroups> infected_by_age;
+	std::vector<unsigned int> infected_by_town;
+
+	/// Counts the persons that are present in a simulator. The towns are counted by the simulator
+	/// itself; only the statuses and age groups take a (parallel) pass over the population.
+	static TimeSeriesRecord Count(const Simulator& sim, multiregion::RegionId region, unsigned int day);
+
+	/// The number of cases, as in the cases file: the persons that are infected or recovered.
+	unsigned int GetCases() const;
+};
+
+/**
+ * Produces a binary file with a fixed size record per simulated day. Records are appended and flushed as
+ * the simulation goes on, so the cost of a day doesn't grow with the number of days. All numbers are
+ * written in native byte order:
+ *
+ * header: "STRIDETS", uint32 version, uint32 number of statuses, uint32 number of age groups,
+ *         uint32 age group width, uint32 number of towns, and for every town: uint32 name length,
+ *         the name, uint32 size, double latitude, double longitude.
+ * record: uint32 region, uint32 day, uint32 per status, uint32 infected per age group,
+ *         uint32 infected per town.
+ *
+ * The timeseries_convert.py script turns the file into a cases file and a visualization file.
+ */
+class TimeSeriesFile
+{
+public:
+	/// The version of the file format.
+	static constexpr unsigned int Version = 1;
+
+	/// Constructor: open the file and write the header with the towns of the atlas, if there is one.
+	TimeSeriesFile(const std::string& file, const Atlas* atlas);
+
+	/// Destructor: close the file stream.
+	~TimeSeriesFile();
+
+	/// Append the record of a day.
+	void Print(const TimeSeriesRecord& record);
+
+private:
+	/// Generate file name and open the file stream.
+	void Initialize(const std::string& file);
+
+	/// Write the header.
+	void PrintHeader(const Atlas* atlas);
+
+	/// Write a number in native byte order.
+	template <typename T>
+	void Write(T value)
+	{
+		m_fstream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+private:
+	std::ofstream m_fstream;
+	std::size_t m_num_towns; ///< The number of towns in every record.
+};
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end of include guard
@@ -5,75 +5,41 @@
 
 #include "VisualizerData.h"
 
+#include <stdexcept>
+
 namespace stride {
 
 using namespace std;
-using boost::property_tree::ptree;
 
-void VisualizerData::AddDay(const std::shared_ptr<const Population>& pop)
+void VisualizerData::RegisterTowns(const Atlas& atlas)
 {
-	if(!townsTree)
-		RegisterTowns(pop->get_atlas().getTownMap());
-
-	days.push_back({});
-	for (const auto& p : *pop) {
-		if (p.GetHealth().IsInfected()) {
-			days.back()[pop->get_hometown(p).id]++;
-		}
+	towns.clear();
+	for (const auto& p : atlas.getTownMap()) {
+		towns.push_back({p.second.name, p.second.size, p.first});
 	}
 }
 
-
-void VisualizerData::RegisterTowns(const Atlas::TownMap& townMap)
+void VisualizerData::AddDay(const std::vector<unsigned int>& town_infections)
 {
-	townsTree = make_shared<ptree>();
-
-	for (auto& p : townMap) {
-		// append a town node for each town in the map:
-		// id : {name, size, lat, long}
-		ptree townNode;
-		townNode.put("name", p.second.name);
-		townNode.put("size", p.second.size);
-		townNode.put("lat", p.first.latitude);
-		townNode.put("long", p.first.longitude);
-		townsTree->add_child(to_string(p.second.id), townNode);
+	if (town_infections.size() != towns.size()) {
+		throw invalid_argument("VisualizerData::AddDay: expected a count for each of the towns");
 	}
+	days.push_back(town_infections);
 }
 
-const vector<map<size_t, int>>& VisualizerData::GetDays() const { return days; }
-
-shared_ptr<ptree> VisualizerData::GetDaysTree()
+util::MemoryUsage VisualizerData::GetMemoryUsage() const
 {
-	// First update our stored ptree to include all added days.
-	for (size_t i = daysTree->size(); i < days.size(); i++) {
-		ptree data;
-		const auto& currentDay = days[i];
-
-		if (i == 0) {
-			// First day: Just put the number of infected.
-			for (const auto& p : currentDay)
-				data.put(to_string(p.first), p.second);
-		} else {
-			// Subsequent days: Put the difference in infected from the previous day
-			const auto& prevDay = days[i - 1];
-			for (const auto& p : currentDay) {
-				int diff = p.second;
-
-				// If the previous day has no record it means there were 0 infected that day.
-				const auto& prev = prevDay.find(p.first);
-				if (prev != prevDay.end())
-					diff -= prev->second;
-
-				// If the difference between days is zero, don't actually put it in the file.
-				if (diff != 0)
-					data.put(to_string(p.first), diff);
-			}
-		}
-
-		daysTree->push_back(make_pair("", data));
+	auto usage = util::GetMemoryUsage(towns);
+	for (const auto& town : towns) {
+		const auto name_bytes = util::GetHeapBytes(town.name);
+		usage.used += name_bytes;
+		usage.allocated += name_bytes;
 	}
-
-	return daysTree;
+	usage += util::GetMemoryUsage(days);
+	for (const auto& day : days) {
+		usage += util::GetMemoryUsage(day);
+	}
+	return usage;
 }
 
-} // end of namespace
\ No newline at end of file
+} // end of namespace
@@ -6,46 +6,56 @@
  * Data structure for the visualiser.
  */
 
-#include <memory>
 #include <string>
 #include <vector>
-#include <boost/property_tree/ptree.hpp>
-#include "pop/Population.h"
+#include "core/Atlas.h"
+#include "geo/GeoPosition.h"
+#include "util/MemoryAccount.h"
 
 namespace stride {
 
 /**
  * Data structure for the visualiser.
- * Stores the day-by-day infected count per Town.
+ * Stores the day-by-day infected count per Town, as one dense vector per day.
+ * Towns are indexed like Atlas::GetTowns().
  */
 class VisualizerData
 {
-private:
-	/// Vector of days: Each day is a map from Town names to the amount of infected.
-	std::vector<std::map<std::size_t, int>> days;
-	std::shared_ptr<boost::property_tree::ptree> daysTree;
-	std::shared_ptr<boost::property_tree::ptree> townsTree;
-
 public:
-	VisualizerData() : daysTree(new boost::property_tree::ptree()) {}
+	/// A town as it is shown by the visualiser.
+	struct Town
+	{
+		std::string name;
+		unsigned int size;
+		geo::GeoPosition position;
+	};
+
+	/// Register the towns of the given atlas.
+	void RegisterTowns(const Atlas& atlas);
 
-	/// Register a new day from the given population's current state.
-	void AddDay(const std::shared_ptr<const Population>& pop);
+	/// Whether the towns have been registered.
+	bool HasTowns() const { return !towns.empty(); }
+
+	/// Register a new day from the infected count of every town, e.g. Simulator::GetTownInfections().
+	void AddDay(const std::vector<unsigned int>& town_infections);
 
 	/// Get a reference to the vector of days.
-	const std::vector<std::map<std::size_t, int>>& GetDays() const;
+	const std::vector<std::vector<unsigned int>>& GetDays() const { return days; }
 
-	/// Get the day-by-day data as a boost property tree.
-	std::shared_ptr<boost::property_tree::ptree> GetDaysTree();
+	/// Get a reference to the vector of towns.
+	const std::vector<Town>& GetTowns() const { return towns; }
 
-	/// Get the town data as a boost property tree.
-	std::shared_ptr<boost::property_tree::ptree> GetTownsTree() { return townsTree; };
+	/// The memory of the towns and of the infected counts of every day.
+	util::MemoryUsage GetMemoryUsage() const;
 
 private:
-	/// Convert and store the town map as a ptree.
-	void RegisterTowns(const Atlas::TownMap& townMap);
+	/// The towns, in atlas order.
+	std::vector<Town> towns;
+
+	/// Vector of days: Each day holds the amount of infected of every town.
+	std::vector<std::vector<unsigned int>> days;
 };
 
 } // end of namespace
 
-#endif // end-of-include-guard
\ No newline at end of file
+#endif // end-of-include-guard
@@ -5,34 +5,96 @@
 
 #include "VisualizerFile.h"
 
-#include <iostream>
-#include <memory>
-#include <boost/property_tree/json_parser.hpp>
+#include <iomanip>
+#include <limits>
 
 namespace stride {
 namespace output {
 
 using namespace std;
 
-VisualizerFile::VisualizerFile(const std::string& file) { Initialize(file); }
+namespace {
+
+/// Writes a string as a JSON string literal.
+void WriteJsonString(ostream& out, const string& value)
+{
+	out << '"';
+	for (const char c : value) {
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			out << "\\u" << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec << setfill(' ');
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+} // namespace
+
+VisualizerFile::VisualizerFile(const std::string& file) : m_towns_printed(false), m_days_printed(0)
+{
+	Initialize(file);
+}
 
 VisualizerFile::~VisualizerFile() { m_fstream.close(); }
 
-void VisualizerFile::Initialize(const std::string& file) { m_fstream.open((file + "_vis.json").c_str()); }
+void VisualizerFile::Initialize(const std::string& file)
+{
+	m_fstream.open((file + "_vis.json").c_str());
+	m_fstream << setprecision(numeric_limits<double>::digits10 + 1);
+}
 
-void VisualizerFile::Print(VisualizerData& visualizer_data)
+void VisualizerFile::Print(const VisualizerData& visualizer_data)
 {
-	using boost::property_tree::ptree;
-	using boost::property_tree::write_json;
+	const auto& days = visualizer_data.GetDays();
+	if (!m_towns_printed) {
+		PrintTowns(visualizer_data);
+	}
 
-	std::shared_ptr<ptree> townsTree = visualizer_data.GetTownsTree();
-	std::shared_ptr<ptree> daysTree = visualizer_data.GetDaysTree();
+	for (; m_days_printed < days.size(); m_days_printed++) {
+		PrintDay(days[m_days_printed]);
+	}
 
-	ptree fileTree;
-	fileTree.add_child("towns", *townsTree);
-	fileTree.add_child("days", *daysTree);
+	// Close the document, and go back so the next day overwrites the closing brackets.
+	const auto end_of_days = m_fstream.tellp();
+	m_fstream << "]}";
+	m_fstream.flush();
+	m_fstream.seekp(end_of_days);
+}
 
-	write_json(m_fstream, fileTree, false);
+void VisualizerFile::PrintTowns(const VisualizerData& visualizer_data)
+{
+	// "towns": {id : {name, size, lat, long}}
+	const auto& towns = visualizer_data.GetTowns();
+	m_fstream << "{\"towns\":{";
+	for (size_t i = 0; i < towns.size(); i++) {
+		m_fstream << (i == 0 ? "" : ",") << '"' << i << "\":{\"name\":";
+		WriteJsonString(m_fstream, towns[i].name);
+		m_fstream << ",\"size\":" << towns[i].size << ",\"lat\":" << towns[i].position.latitude
+			  << ",\"long\":" << towns[i].position.longitude << '}';
+	}
+	m_fstream << "},\"days\":[";
+	m_last_day.assign(towns.size(), 0U);
+	m_towns_printed = true;
+}
+
+void VisualizerFile::PrintDay(const std::vector<unsigned int>& day)
+{
+	// The first day holds the number of infected, subsequent days the difference from the previous day.
+	// Towns without a difference are left out.
+	m_fstream << (m_days_printed == 0 ? "{" : ",{");
+	bool first = true;
+	for (size_t i = 0; i < day.size(); i++) {
+		const long diff = static_cast<long>(day[i]) - static_cast<long>(m_last_day[i]);
+		if (diff != 0) {
+			m_fstream << (first ? "" : ",") << '"' << i << "\":" << diff;
+			first = false;
+		}
+	}
+	m_fstream << '}';
+	m_last_day = day;
 }
 
 } // end_of_namespace
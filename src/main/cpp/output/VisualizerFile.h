@@ -9,13 +9,15 @@
 #include <string>
 #include <vector>
 #include "VisualizerData.h"
-#include "core/Atlas.h"
 
 namespace stride {
 namespace output {
 
 /**
  * Produces a file with the necessary data for visualization.
+ * The file is written as a stream: every Print only appends the days that weren't printed yet, and then
+ * closes the JSON document, so the file can be read at any time. The closing brackets are overwritten
+ * by the next Print.
  */
 class VisualizerFile
 {
@@ -26,15 +28,25 @@ public:
 	/// Destructor: close the file stream.
 	~VisualizerFile();
 
-	/// Print the given visualisation data.
-	void Print(VisualizerData& visualizer_data);
+	/// Print the days of the given visualisation data that haven't been printed yet. The first call
+	/// also prints the towns.
+	void Print(const VisualizerData& visualizer_data);
 
 private:
 	/// Generate file name and open the file stream.
 	void Initialize(const std::string& file);
 
+	/// Print the towns and open the array of days.
+	void PrintTowns(const VisualizerData& visualizer_data);
+
+	/// Print a day as the difference with the previous day.
+	void PrintDay(const std::vector<unsigned int>& day);
+
 private:
 	std::ofstream m_fstream;
+	bool m_towns_printed;		      ///< Whether the towns are in the file.
+	std::size_t m_days_printed;	      ///< The number of days in the file.
+	std::vector<unsigned int> m_last_day; ///< The last day in the file, or zeros.
 };
 
 } // end_of_namespace
@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <cstddef>
+#include <exception>
+#include <limits>
 #include <map>
 #include <memory>
 #include <numeric>
@@ -40,6 +42,9 @@ std::unique_ptr<Generator> Generator::FromConfig(
 	auto pop_file = util::InstallDirs::OpenDataFile(config.GetPopulationPath());
 	boost::property_tree::ptree pt;
 	boost::property_tree::read_xml(*pop_file, pt);
+	if (config.common_config->population_size > 0) {
+		pt.put("population_model.population_size", config.common_config->population_size);
+	}
 	const population::ModelRef model = population::Model::Parse(pt);
 
 	return std::make_unique<Generator>(model, geo_profile, reference_households, disease, rng);
@@ -109,15 +114,19 @@ Population Generator::Generate()
 	{
 		Debug("Generating towns...");
 		int towns_created = 0;
+
 		while (n > 0) {
 			int town_size = GetRandomTownSize();
 			auto pos = GetRandomGeoPosition();
-			std::string town_name = "town" + std::to_string(towns_created);
-			bool inserted = town_map.insert({pos, Atlas::Town(town_name, town_size)}).second;
-			if (inserted) {
+			// Reject positions that are already taken before building a Town for them, with the map's own
+			// lookup: a Town takes an id when it's built.
+			const auto hint = town_map.lower_bound(pos);
+			if (hint == town_map.end() || pos < hint->first) {
+				std::string town_name = "town" + std::to_string(towns_created);
+				town_map.emplace_hint(hint, pos, Atlas::Town(town_name, town_size));
 				n -= town_size;
+				towns_created++;
 			}
-			towns_created++;
 		}
 		Debug("Created {} towns.", towns_created);
 	}
@@ -262,47 +271,101 @@ Population Generator::Generate()
 	// Generate people.
 	{
 		Debug("Generating people...");
-		HouseholdClusterId household_id = 1;
-		ClusterId person_id = 1;
-
-		for (const auto& p : households) {
-			const auto& home = p.first;
-			for (const auto& rh : p.second) {
-				for (const int age : rh.ages) {
-					int school_id = 0;
-					int work_id = 0;
-					if (model->IsSchoolAge(age)) {
-						school_id = random.Sample(random.Sample(FindLocal(home, schools)));
-					} else if (model->IsCollegeAge(age)) {
-						bool commutes = random.Chance(model->college_commute_ratio);
-						school_id = random.Sample(
-						    commutes ? colleges[college_brng.Next()]
-							     : FindLocal(home, colleges));
-					} else if (
-					    model->IsEmployableAge(age) && random.Chance(model->employed_ratio)) {
-						// TODO: technically, commuters should commute to workplaces in big
-						// cities, not just random ones.
-						bool commutes = random.Chance(model->work_commute_ratio);
-						work_id = random.Sample(
-						    FindLocal(commutes ? work_geo_brng.Next() : home, workplaces));
-					}
-
-					int primary_community_id = random.Sample(FindLocal(home, primary_communities));
-					int secondary_community_id =
-					    random.Sample(FindLocal(home, secondary_communities));
-
-					population.emplace(
-					    person_id++, age, household_id, school_id, work_id, primary_community_id,
-					    secondary_community_id, disease.Sample(random));
-
-					if (person_id % 10000 == 0) {
-						Debug("Person {}...", person_id);
-					}
-				}
-				household_id++;
+
+		// Spatial indices for the FindLocal lookups below, built once per facility map.
+		const double cell_size = model->search_radius;
+		const geo::GeoGrid<std::vector<School>> school_grid(schools, cell_size);
+		const geo::GeoGrid<College> college_grid(colleges, cell_size);
+		const geo::GeoGrid<std::vector<WorkClusterId>> workplace_grid(workplaces, cell_size);
+		const geo::GeoGrid<std::vector<CommunityClusterId>> primary_community_grid(primary_communities, cell_size);
+		const geo::GeoGrid<std::vector<CommunityClusterId>> secondary_community_grid(
+		    secondary_communities, cell_size);
+
+		// Partition the households by town. Household and person ids are handed out in town order up
+		// front, so the result doesn't depend on how the towns are scheduled.
+		struct TownPartition
+		{
+			const GeoPosition* home;
+			const std::vector<ReferenceHousehold>* households;
+			HouseholdClusterId first_household_id;
+			PersonId first_person_id;
+			std::vector<Person> people;
+			std::exception_ptr error;
+		};
+		std::vector<TownPartition> partitions;
+		{
+			HouseholdClusterId household_id = 1;
+			PersonId person_id = 1;
+			for (const auto& p : households) {
+				partitions.push_back({&p.first, &p.second, household_id, person_id, {}, nullptr});
+				household_id += p.second.size();
+				for (const auto& rh : p.second)
+					person_id += rh.ages.size();
+			}
+		}
+
+		// Every town draws from its own stream, split off a generator seeded from the main one.
+		const unsigned long people_seed = random(std::numeric_limits<unsigned int>::max());
+		const unsigned int num_partitions = partitions.size();
+
+		util::parallel::parallel_for(
+		    partitions, util::parallel::get_number_of_threads(), [&](TownPartition& town, unsigned int) {
+			    try {
+				    util::Random rng(people_seed);
+				    rng.Split(num_partitions, &town - partitions.data());
+
+				    const auto& home = *town.home;
+				    HouseholdClusterId household_id = town.first_household_id;
+				    PersonId person_id = town.first_person_id;
+				    for (const auto& rh : *town.households) {
+					    for (const int age : rh.ages) {
+						    int school_id = 0;
+						    int work_id = 0;
+						    if (model->IsSchoolAge(age)) {
+							    school_id = rng.Sample(rng.Sample(FindLocal(home, school_grid, rng)));
+						    } else if (model->IsCollegeAge(age)) {
+							    bool commutes = rng.Chance(model->college_commute_ratio);
+							    school_id = rng.Sample(
+								commutes ? colleges.at(college_brng.Next(rng))
+									 : FindLocal(home, college_grid, rng));
+						    } else if (
+							model->IsEmployableAge(age) && rng.Chance(model->employed_ratio)) {
+							    // TODO: technically, commuters should commute to workplaces in
+							    // big cities, not just random ones.
+							    bool commutes = rng.Chance(model->work_commute_ratio);
+							    work_id = rng.Sample(FindLocal(
+								commutes ? work_geo_brng.Next(rng) : home, workplace_grid, rng));
+						    }
+
+						    int primary_community_id =
+							rng.Sample(FindLocal(home, primary_community_grid, rng));
+						    int secondary_community_id =
+							rng.Sample(FindLocal(home, secondary_community_grid, rng));
+
+						    town.people.emplace_back(
+							person_id++, age, household_id, school_id, work_id,
+							primary_community_id, secondary_community_id, disease.Sample(rng));
+					    }
+					    household_id++;
+				    }
+			    } catch (...) {
+				    town.error = std::current_exception();
+			    }
+		    });
+
+		// Merge the towns' people into the population, in id order.
+		std::size_t people_created = 0;
+		for (auto& town : partitions) {
+			if (town.error) {
+				std::rethrow_exception(town.error);
+			}
+			for (const auto& person : town.people) {
+				population.emplace(person);
 			}
+			people_created += town.people.size();
+			town.people.clear();
 		}
-		Debug("Generated {} people.", person_id - 1);
+		Debug("Generated {} people.", people_created);
 	}
 
 	// Store all the cluster's locations in the population's atlas.
@@ -15,6 +15,7 @@
 #include "Person.h"
 #include "alias/Alias.h"
 #include "core/Disease.h"
+#include "geo/GeoGrid.h"
 #include "geo/Profile.h"
 #include "pop/Population.h"
 #include "sim/SimulationConfig.h"
@@ -35,7 +36,7 @@ public:
 	    : model(m), geo_profile(g), reference_households(h), disease(d), random(r),
 	      town_brng(TownBRNG::CreateDistribution(m->town_distribution, r)), verbose(false)
 	{
-		std::cout << "Constructed generator" << std::endl;
+		Debug("Constructed generator");
 	}
 
 	// "Constructor" that reads the model, geoprofile and households from a configuration file.
@@ -57,7 +58,7 @@ public:
 			return;
 		auto console = spdlog::get("popgen");
 		if (!console) {
-			console = spdlog::stderr_logger_st("popgen");
+			console = spdlog::stderr_logger_mt("popgen");
 			console->set_level(spdlog::level::debug);
 			console->set_pattern("\x1b[36;1m[popgen] %v\x1b[0m");
 		}
@@ -87,33 +88,31 @@ private:
 	/// Generate a random GeoPosition in the simulation area.
 	geo::GeoPosition GetRandomGeoPosition() { return geo_profile->GetRandomGeoPosition(random); }
 
-	/// Find a random GeoPosition map value close to the given origin point.
+public:
+	/// Find a random GeoPosition map value close to the given origin point, using a spatial index of the map.
+	/// Draws from the given random number generator, so that it may be called concurrently.
 	template <typename T>
-	T& FindLocal(const geo::GeoPosition& origin, std::map<geo::GeoPosition, T>& map, int tries = 5)
+	T& FindLocal(const geo::GeoPosition& origin, const geo::GeoGrid<T>& grid, util::Random& rng, int tries = 5)
 	{
-		if (map.empty()) {
+		if (grid.Empty()) {
 			FATAL_ERROR("Generator::FindLocal called on empty map.");
 		}
 
 		double r = model->search_radius;
 		std::vector<std::reference_wrapper<T>> hits;
 		for (int i = 0; i < tries; i++, r *= 2.0) {
-			for (auto& p : map) {
-				if (p.first.Distance(origin) < r) {
-					hits.emplace_back(p.second);
-				}
-			}
+			grid.FindWithin(origin, r, hits);
 			if (!hits.empty()) {
-				return random.Sample(hits).get();
+				return rng.Sample(hits).get();
 			}
 		}
 
 		Debug("FindLocal: giving up after {} radius expansions", tries);
-		auto it = map.begin();
-		std::advance(it, random(map.size()));
-		const double distance = it->first.Distance(origin);
-		Debug("Settling on distance {} between {} and {}", distance, it->first.ToString(), origin.ToString());
-		return it->second;
+		const std::size_t index = rng(grid.Size());
+		const double distance = grid.PositionAt(index).Distance(origin);
+		Debug("Settling on distance {} between {} and {}", distance, grid.PositionAt(index).ToString(),
+		      origin.ToString());
+		return grid.ValueAt(index);
 	}
 };
 
@@ -108,6 +108,7 @@ GenericPerson<BehaviourPolicy, BeliefPolicy> GenericPerson<BehaviourPolicy, Beli
 {
 	auto result = Clone();
 	result.m_id = new_id;
+	result.m_data->SetOriginalId(new_id);
 	return result;
 }
 
@@ -33,7 +33,8 @@ public:
 	    double age, unsigned int household_id, unsigned int school_id, unsigned int work_id,
 	    unsigned int primary_community_id, unsigned int secondary_community_id, disease::Fate fate,
 	    double risk_averseness = 0)
-	    : m_age(age), m_gender('M'), m_household_id(household_id), m_school_id(school_id), m_work_id(work_id),
+	    : m_age(age), m_gender('M'), m_original_id(0U), m_household_id(household_id), m_school_id(school_id),
+	      m_work_id(work_id),
 	      m_primary_community_id(primary_community_id), m_secondary_community_id(secondary_community_id),
 	      m_at_household(true), m_at_school(true), m_at_work(true), m_at_primary_community(true),
 	      m_at_secondary_community(true), m_health(fate), m_is_participant(false)
@@ -53,6 +54,12 @@ public:
 	/// Return person's gender.
 	char GetGender() const { return m_gender; }
 
+	/// Get the id under which the person was read or generated, before any renumbering.
+	PersonId GetOriginalId() const { return m_original_id; }
+
+	/// Set the id under which the person was read or generated.
+	void SetOriginalId(PersonId id) { m_original_id = id; }
+
 	/// Return person's health status.
 	Health& GetHealth() { return m_health; }
 
@@ -81,6 +88,9 @@ private:
 	double m_age;
 	char m_gender;
 
+	/// The id in the input and in the output files.
+	PersonId m_original_id;
+
 	/// Which communities does this person belong to?
 	unsigned int m_household_id;
 	unsigned int m_school_id;
@@ -128,6 +138,7 @@ public:
 				age, household_id, school_id, work_id, primary_community_id, secondary_community_id,
 				fate, risk_averseness))
 	{
+		m_data->SetOriginalId(id);
 	}
 
 	/// Creates a person from the given id and data.
@@ -157,10 +168,17 @@ public:
 	/// Get the id.
 	PersonId GetId() const { return m_id; }
 
+	/// Get the id under which the person was read or generated. This is the id that is written to the output
+	/// files; it only differs from GetId() if the population was renumbered.
+	PersonId GetOriginalId() const { return m_data->GetOriginalId(); }
+
+	/// Set the id under which the person was read or generated, e.g. when the person is restored.
+	void SetOriginalId(PersonId id) const { m_data->SetOriginalId(id); }
+
 	/// Creates a deep copy of this person, including its data.
 	GenericPerson Clone() const { return GenericPerson(m_id, std::make_shared<PersonData>(*m_data)); }
 
-	/// Creates a deep copy of this person and gives it the given id.
+	/// Creates a deep copy of this person and gives it the given id, which is also its original id.
 	GenericPerson WithId(PersonId new_id) const;
 
 	/// Check if a person is present today in a given cluster
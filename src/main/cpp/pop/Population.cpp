@@ -1,7 +1,10 @@
 #include "Population.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <functional>
+#include <tuple>
 #include <map>
 #include <memory>
 #include <numeric>
@@ -17,6 +20,31 @@
 #include "util/Random.h"
 
 namespace stride {
+
+namespace {
+
+/// The index of the cell (x, y) on a Hilbert curve through a square grid with 2^16 cells per side.
+std::uint32_t HilbertIndex(std::uint32_t x, std::uint32_t y)
+{
+	std::uint32_t index = 0U;
+	for (std::uint32_t s = 1U << 15; s > 0; s >>= 1) {
+		const std::uint32_t rx = (x & s) > 0 ? 1U : 0U;
+		const std::uint32_t ry = (y & s) > 0 ? 1U : 0U;
+		index += s * s * ((3U * rx) ^ ry);
+		// Rotate the quadrant, so that the curve inside it starts and ends next to its neighbours.
+		if (ry == 0) {
+			if (rx == 1) {
+				x = s - 1 - (x & (s - 1));
+				y = s - 1 - (y & (s - 1));
+			}
+			std::swap(x, y);
+		}
+	}
+	return index;
+}
+
+} // namespace
+
 /// Gets a list of pointers to 'count' unique, randomly chosen participants in the population.
 std::vector<Person> Population::get_random_persons(util::Random& rng, std::size_t count)
 {
@@ -113,4 +141,71 @@ unsigned int Population::get_infected_count() const
 	    });
 	return total;
 }
-}
\ No newline at end of file
+
+void Population::AccountMemory(util::MemoryAccount& account) const
+{
+	account.Add("person data", {size() * sizeof(PersonData), size() * GetPersonDataSize()});
+	account.Add("person map nodes", util::GetMemoryUsage(people.get_inner_map()));
+	account.Add("atlas", atlas->GetMemoryUsage());
+}
+
+void Population::renumber_by_household()
+{
+	// Find the grid over the positions of the households.
+	std::vector<const geo::GeoPosition*> positions;
+	geo::GeoPosition min{0.0, 0.0};
+	geo::GeoPosition max{0.0, 0.0};
+	if (has_atlas_flag) {
+		for (const auto& pair : people) {
+			const auto position = atlas->FindPosition(
+			    {pair.second->GetClusterId(ClusterType::Household), ClusterType::Household});
+			if (position) {
+				if (positions.empty()) {
+					min = max = *position;
+				}
+				min.latitude = std::min(min.latitude, position->latitude);
+				min.longitude = std::min(min.longitude, position->longitude);
+				max.latitude = std::max(max.latitude, position->latitude);
+				max.longitude = std::max(max.longitude, position->longitude);
+			}
+			positions.push_back(position);
+		}
+	}
+	const auto cell = [](double value, double min, double max) -> std::uint32_t {
+		return max > min ? static_cast<std::uint32_t>((value - min) / (max - min) * 65535.0) : 0U;
+	};
+
+	// Order the persons by the position of their household on the curve, their household and their id.
+	using Entry = std::tuple<std::uint32_t, unsigned int, PersonId, std::shared_ptr<PersonData>>;
+	std::vector<Entry> entries;
+	entries.reserve(people.size());
+	std::size_t i = 0;
+	for (const auto& pair : people) {
+		const auto position = positions.empty() ? nullptr : positions[i];
+		const auto curve_index = position ? HilbertIndex(
+							cell(position->longitude, min.longitude, max.longitude),
+							cell(position->latitude, min.latitude, max.latitude))
+						  : 0U;
+		entries.emplace_back(
+		    curve_index, pair.second->GetClusterId(ClusterType::Household), pair.first, pair.second);
+		i++;
+	}
+	positions.clear();
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		return std::tie(std::get<0>(a), std::get<1>(a), std::get<2>(a)) <
+		       std::tie(std::get<0>(b), std::get<1>(b), std::get<2>(b));
+	});
+
+	// Copy the persons in the new order, with new ids.
+	people.clear();
+	max_person_id = 0U;
+	PersonId id = 0U;
+	for (auto& entry : entries) {
+		auto data = std::make_shared<PersonData>(*std::get<3>(entry));
+		std::get<3>(entry).reset();
+		emplace(id, data);
+		id++;
+	}
+}
+
+} // end_of_namespace
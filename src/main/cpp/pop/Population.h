@@ -10,6 +10,7 @@
 #include "core/Atlas.h"
 #include "core/Health.h"
 #include "geo/GeoPosition.h"
+#include "util/MemoryAccount.h"
 #include "util/Parallel.h"
 #include "util/ParallelMap.h"
 #include "util/Random.h"
@@ -24,16 +25,25 @@ class Population
 private:
 	util::parallel::ParallelMap<PersonId, std::shared_ptr<PersonData>> people;
 	PersonId max_person_id;
-	Atlas atlas;
+	std::shared_ptr<Atlas> atlas;
 	bool has_atlas_flag;
 
+	/// Gets the atlas to change it, after copying it if it is shared with other populations.
+	Atlas& edit_atlas()
+	{
+		if (atlas.use_count() > 1) {
+			atlas = std::make_shared<Atlas>(*atlas);
+		}
+		return *atlas;
+	}
+
 public:
 	/// Creates a population. No atlas is associated with the population.
-	Population() : has_atlas_flag(false) {}
+	Population() : atlas(std::make_shared<Atlas>()), has_atlas_flag(false) {}
 
 	/// Creates a population. The given Boolean specifies if the population
 	/// includes an atlas.
-	Population(bool has_atlas) : has_atlas_flag(has_atlas) {}
+	Population(bool has_atlas) : atlas(std::make_shared<Atlas>()), has_atlas_flag(has_atlas) {}
 
 	Population(const Population&) = delete;
 	Population& operator=(const Population&) = delete;
@@ -115,7 +125,15 @@ public:
 	bool has_atlas() const { return has_atlas_flag; }
 
 	/// Gets this population's atlas.
-	const Atlas& get_atlas() const { return atlas; }
+	const Atlas& get_atlas() const { return *atlas; }
+
+	/// Uses the atlas of another population, rather than a copy of it. The populations share the atlas until
+	/// one of them changes it.
+	void share_atlas(const Population& other)
+	{
+		atlas = other.atlas;
+		has_atlas_flag = other.has_atlas_flag;
+	}
 
 	/// Creates a constant iterator positioned at the first person in this population.
 	const_iterator begin() const { return const_iterator(people.begin()); }
@@ -134,6 +152,20 @@ public:
 	std::vector<Person> get_random_persons(
 	    util::Random& rng, std::size_t count, std::function<bool(const Person&)> matches);
 
+	/// Gives the persons new ids, so that the members of every household have consecutive ids, and
+	/// households that are near each other in the atlas have nearby ids: households are ordered along a
+	/// Hilbert curve over their positions, or by id if they have none. The person data is copied in
+	/// the new order, so that it is laid out like that in memory too. Persons keep their original ids
+	/// for the output files.
+	void renumber_by_household();
+
+	/// Adds the memory of the person data, the nodes of the person map and the atlas to the account.
+	void AccountMemory(util::MemoryAccount& account) const;
+
+	/// The memory of the data of a person, which make_shared allocates together with a control block of a
+	/// vtable pointer and two counts.
+	static constexpr std::size_t GetPersonDataSize() { return sizeof(PersonData) + 2 * sizeof(void*); }
+
 	/// Get the cumulative number of cases.
 	unsigned int get_infected_count() const;
 
@@ -155,19 +187,19 @@ public:
 	}
 
 	/// Register the map of GeoPositions to Towns to the atlas.
-	void atlas_register_towns(const Atlas::TownMap& towns) { atlas.RegisterTowns(towns); }
+	void atlas_register_towns(const Atlas::TownMap& towns) { edit_atlas().RegisterTowns(towns); }
 
 	/// Store a Cluster's GeoPosition in the population's atlas.
 	auto atlas_emplace_cluster(const Atlas::ClusterKey& key, const geo::GeoPosition& pos)
-	    -> decltype(atlas.EmplaceCluster(key, pos))
+	    -> decltype(atlas->EmplaceCluster(key, pos))
 	{
-		return atlas.EmplaceCluster(key, pos);
+		return edit_atlas().EmplaceCluster(key, pos);
 	}
 
 	/// Gets the given person's hometown.
 	const Atlas::Town& get_hometown(const Person& person) const
 	{
-		return atlas.LookupTown({person.GetClusterId(ClusterType::Household), ClusterType::Household});
+		return atlas->LookupTown({person.GetClusterId(ClusterType::Household), ClusterType::Household});
 	}
 
 	/// Runs the `action` on every element of this vector. Up to `number_of_threads` instances of
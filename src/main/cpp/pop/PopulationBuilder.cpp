@@ -93,6 +93,11 @@ shared_ptr<Population> PopulationBuilder::Build(
 		FATAL_ERROR("Population is too small.");
 	}
 
+	// Lay out the persons by household.
+	if (config.common_config->renumber_persons) {
+		population.renumber_by_household();
+	}
+
 	// Set participants in social contact survey.
 	const auto log_level = config.log_config->log_level;
 	if (log_level == LogMode::Contacts) {
@@ -102,7 +107,7 @@ shared_ptr<Population> PopulationBuilder::Build(
 		auto is_not_participating = [](const Person& p) -> bool { return !p.IsParticipatingInSurvey(); };
 		for (auto& pers : population.get_random_persons(rng, num_participants, is_not_participating)) {
 			pers.ParticipateInSurvey();
-			log->info("[PART] {} {} {}", pers.GetId(), pers.GetAge(), pers.GetGender());
+			log->info("[PART] {} {} {}", pers.GetOriginalId(), pers.GetAge(), pers.GetGender());
 		}
 	}
 
@@ -0,0 +1,45 @@
+/**
+ * @file
+ * Implementation of the TownInfectionCounter class.
+ */
+
+#include "TownInfectionCounter.h"
+
+#include <algorithm>
+#include "pop/Population.h"
+
+namespace stride {
+
+void TownInfectionCounter::Reset(const Population& population, unsigned int num_threads)
+{
+	m_atlas = population.has_atlas() ? &population.get_atlas() : nullptr;
+	const auto num_towns = m_atlas ? m_atlas->GetTowns().size() : 0;
+
+	m_deltas.assign(std::max(num_threads, 1U), Delta());
+	for (auto& delta : m_deltas) {
+		delta.m_atlas = m_atlas;
+		delta.m_changes.assign(num_towns, 0);
+	}
+
+	m_counts.assign(num_towns, 0U);
+	if (IsEnabled()) {
+		population.serial_for([this](const Person& p, unsigned int) {
+			if (p.GetHealth().IsInfected()) {
+				m_deltas[0].Add(p, 1);
+			}
+		});
+		Merge();
+	}
+}
+
+void TownInfectionCounter::Merge()
+{
+	for (auto& delta : m_deltas) {
+		for (std::size_t i = 0; i < delta.m_changes.size(); i++) {
+			m_counts[i] += delta.m_changes[i];
+			delta.m_changes[i] = 0;
+		}
+	}
+}
+
+} // end_of_namespace
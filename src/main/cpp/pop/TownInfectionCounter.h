@@ -0,0 +1,79 @@
+#ifndef TOWN_INFECTION_COUNTER_H_INCLUDED
+#define TOWN_INFECTION_COUNTER_H_INCLUDED
+
+/**
+ * @file
+ * Header for the TownInfectionCounter class.
+ */
+
+#include <vector>
+#include "core/Atlas.h"
+#include "core/ClusterType.h"
+#include "pop/Person.h"
+
+namespace stride {
+
+class Population;
+
+/**
+ * Counts the infected persons of a population per hometown, as indexed by Atlas::GetTowns().
+ * The counts are kept up to date as persons get infected, recover, arrive or leave, so reading
+ * them costs O(towns) rather than a scan of the population. Persons whose household isn't in a
+ * town are not counted. Without an atlas, the counter does nothing.
+ */
+class TownInfectionCounter
+{
+public:
+	/// The changes to the counts made by one thread since the last Merge.
+	class Delta
+	{
+	public:
+		Delta() : m_atlas(nullptr) {}
+
+		/// Adds `change` to the count of the person's hometown.
+		void Add(const Person& person, int change)
+		{
+			if (m_atlas != nullptr) {
+				const auto town =
+				    m_atlas->FindTownIndex({person.GetClusterId(ClusterType::Household), ClusterType::Household});
+				if (town != Atlas::no_town) {
+					m_changes[town] += change;
+				}
+			}
+		}
+
+	private:
+		friend class TownInfectionCounter;
+
+		const Atlas* m_atlas;
+		std::vector<int> m_changes;
+	};
+
+	/// Creates a counter that does nothing, until it is Reset.
+	TownInfectionCounter() : m_atlas(nullptr) {}
+
+	/// Counts the infected persons of the population, and sets up a Delta for each thread.
+	/// The population has to outlive the counter, or the next Reset.
+	void Reset(const Population& population, unsigned int num_threads);
+
+	/// Whether the population has an atlas, i.e. whether persons are counted.
+	bool IsEnabled() const { return m_atlas != nullptr; }
+
+	/// Gets the Delta of a thread. Each thread should only change its own Delta.
+	Delta& GetDelta(unsigned int thread) { return m_deltas[thread]; }
+
+	/// Adds the changes of every thread to the counts.
+	void Merge();
+
+	/// Gets the infected count of every town, as of the last Merge.
+	const std::vector<unsigned int>& GetCounts() const { return m_counts; }
+
+private:
+	const Atlas* m_atlas;
+	std::vector<unsigned int> m_counts;
+	std::vector<Delta> m_deltas;
+};
+
+} // end_of_namespace
+
+#endif // end-of-include-guard
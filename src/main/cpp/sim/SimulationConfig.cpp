@@ -14,6 +14,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include "calendar/Calendar.h"
 #include "core/LogMode.h"
+#include "multiregion/CommutingModel.h"
 #include "multiregion/TravelModel.h"
 #include "util/Errors.h"
 #include "util/InstallDirs.h"
@@ -25,7 +26,9 @@ namespace stride {
 
 CommonSimulationConfig::CommonSimulationConfig()
     : track_index_case(false), rng_seed(), r0(), seeding_rate(), immunity_rate(), number_of_days(),
-      disease_config_file_name(), number_of_survey_participants(), initial_calendar(), contact_matrix_file_name()
+      disease_config_file_name(), number_of_survey_participants(), initial_calendar(), contact_matrix_file_name(),
+      checkpoint_chunk_size(65536), checkpoint_compression(0), checkpoint_layout(checkpoint::CheckPointLayout::Compound),
+      renumber_persons(false), population_size(0), memory_budget(0)
 {
 }
 
@@ -45,18 +48,41 @@ void CommonSimulationConfig::Parse(const boost::property_tree::ptree& pt)
 	initial_calendar.Initialize(start_date, file_name);
 
 	contact_matrix_file_name = pt.get<std::string>("age_contact_matrix_file", "contact_matrix.xml");
+	checkpoint_chunk_size = pt.get<unsigned int>("checkpoint_chunk_size", 65536);
+	checkpoint_compression = pt.get<unsigned int>("checkpoint_compression", 0);
+	renumber_persons = pt.get<double>("renumber_persons", 0) == 1;
+	population_size = pt.get<unsigned int>("population_size", 0);
+	memory_budget = pt.get<unsigned int>("memory_budget", 0);
+	const auto layout_string = pt.get<std::string>("checkpoint_layout", "compound");
+	checkpoint_layout = checkpoint::IsCheckPointLayout(layout_string) &&
+				    checkpoint::ToCheckPointLayout(layout_string) != checkpoint::CheckPointLayout::Null
+				? checkpoint::ToCheckPointLayout(layout_string)
+				: throw std::runtime_error(std::string(__func__) + "> Invalid checkpoint layout.");
 }
 
-LogConfig::LogConfig() : output_prefix(), generate_person_file(), log_level() {}
+LogConfig::LogConfig()
+    : output_prefix(), generate_person_file(), binary_person_file(), generate_timeseries_file(), log_level(),
+      binary_contact_log(), aggregate_contacts(), contact_matrix_per_day(), contact_sample_rate(),
+      perf_counters(), memory_report_interval()
+{
+}
 
 void LogConfig::Parse(const boost::property_tree::ptree& pt)
 {
 	output_prefix = pt.get<std::string>("output_prefix", "");
 	generate_person_file = pt.get<double>("generate_person_file", 0) == 1;
+	binary_person_file = pt.get<double>("binary_person_file", 0) == 1;
+	generate_timeseries_file = pt.get<double>("generate_timeseries_file", 0) == 1;
 	auto log_level_string = pt.get<std::string>("log_level", "None");
 	log_level = IsLogMode(log_level_string)
 			? ToLogMode(log_level_string)
 			: throw std::runtime_error(std::string(__func__) + "> Invalid input for LogMode.");
+	binary_contact_log = pt.get<double>("binary_contact_log", 0) == 1;
+	aggregate_contacts = pt.get<double>("aggregate_contacts", 0) == 1;
+	contact_matrix_per_day = pt.get<double>("contact_matrix_per_day", 0) == 1;
+	contact_sample_rate = pt.get<double>("contact_sample_rate", 0);
+	perf_counters = pt.get<double>("perf_counters", 0) == 1;
+	memory_report_interval = pt.get<unsigned int>("memory_report_interval", 0);
 }
 
 void SingleSimulationConfig::Parse(const boost::property_tree::ptree& pt)
@@ -100,6 +126,11 @@ void MultiSimulationConfig::Parse(const boost::property_tree::ptree& pt)
 			    region_models.end(), parsed_region_models.begin(), parsed_region_models.end());
 		}
 	}
+	const auto commuting_file = pt.get<std::string>("commuting_file", "");
+	if (!commuting_file.empty()) {
+		common_config->commuting_model =
+		    stride::multiregion::CommutingModel::Parse(commuting_file, region_models);
+	}
 }
 
 std::vector<SingleSimulationConfig> MultiSimulationConfig::GetSingleConfigs() const
@@ -11,7 +11,9 @@
 #include <vector>
 #include <boost/property_tree/ptree.hpp>
 #include "calendar/Calendar.h"
+#include "checkpoint/CheckPointLayout.h"
 #include "core/LogMode.h"
+#include "multiregion/CommutingModel.h"
 #include "multiregion/TravelModel.h"
 
 namespace stride {
@@ -60,6 +62,32 @@ struct CommonSimulationConfig final
 	/// The amount of days between 2 checkpoints. The first and last will be saved regardless.
 	unsigned int checkpoint_interval;
 
+	/// The number of records per chunk in checkpoint datasets.
+	unsigned int checkpoint_chunk_size;
+
+	/// The deflate level (0-9) of checkpoint datasets; 0 disables compression.
+	unsigned int checkpoint_compression;
+
+	/// How checkpoints store the population: per person ("compound"), per attribute ("columnar") or per
+	/// attribute with only the changes since the previous checkpoint ("delta").
+	checkpoint::CheckPointLayout checkpoint_layout;
+
+	/// Tells if the persons are renumbered by household after the population is built, for locality.
+	bool renumber_persons;
+
+	/// The number of persons that a population model generates, instead of the size in the model; 0 keeps the
+	/// size of the model.
+	unsigned int population_size;
+
+	/// The memory budget of every region in MiB; a region that accounts for more memory fails, before the
+	/// cluster members are allocated if they wouldn't fit. Every subsystem is checked at startup, with every
+	/// memory report and on the last day; the days in between only account again for the subsystems that grow,
+	/// the journals, the commuters and the visualizer data. 0 means there is no budget.
+	unsigned int memory_budget;
+
+	/// The daily commuting between the regions; null if there is none.
+	stride::multiregion::CommutingModelRef commuting_model;
+
 	/// Fills this configuration with data from the given ptree.
 	void Parse(const boost::property_tree::ptree& pt);
 };
@@ -77,9 +105,35 @@ struct LogConfig final
 	/// Tells if a person file should be generated.
 	bool generate_person_file;
 
+	/// Tells if the person file is stored by column in binary form instead of as text.
+	bool binary_person_file;
+
+	/// Tells if a binary time series file should be generated.
+	bool generate_timeseries_file;
+
 	/// The log level for the simulation.
 	LogMode log_level;
 
+	/// Tells if contacts and transmissions are logged to a binary file instead of the text log.
+	bool binary_contact_log;
+
+	/// Tells if contacts are counted in age by age contact matrices instead of logged one by one.
+	bool aggregate_contacts;
+
+	/// Tells if the contact matrices are written every day, rather than once for the whole run.
+	bool contact_matrix_per_day;
+
+	/// The fraction of the population whose contacts are counted in the contact matrices; 0 counts the
+	/// contacts of the survey participants.
+	double contact_sample_rate;
+
+	/// Tells if the hardware performance counters of the phases of every day are written to a file.
+	bool perf_counters;
+
+	/// The number of days between the memory reports of every region, which are also printed at startup; 0
+	/// prints none.
+	unsigned int memory_report_interval;
+
 	/// Fills this configuration with data from the given ptree.
 	void Parse(const boost::property_tree::ptree& pt);
 };
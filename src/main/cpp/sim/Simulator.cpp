@@ -10,8 +10,15 @@
 #include "multiregion/Visitor.h"
 #include "pop/Population.h"
 #include "util/Parallel.h"
+#include "util/Trace.h"
 
+#include <algorithm>
+#include <limits>
+#include <map>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <boost/property_tree/ptree.hpp>
 #include <spdlog/spdlog.h>
 
@@ -22,13 +29,77 @@ using namespace boost::property_tree;
 using namespace stride::util;
 
 Simulator::Simulator()
-    : m_config(), m_num_threads(1U), m_log_level(LogMode::Null), m_population(nullptr), m_disease_profile(),
-      m_track_index_case(false)
+    : m_config(), m_num_threads(1U), m_log_level(LogMode::Null), m_population(nullptr),
+      m_commuters_selected(false), m_disease_profile(), m_track_index_case(false)
 {
 }
 
+void Simulator::SetPopulation(const std::shared_ptr<Population>& population)
+{
+	m_population = population;
+	if (m_population) {
+		m_town_infections.Reset(*m_population, m_num_threads);
+	}
+}
+
 void Simulator::SetTrackIndexCase(bool track_index_case) { m_track_index_case = track_index_case; }
 
+void Simulator::AccountMemory(util::MemoryAccount& account) const
+{
+	if (m_population) {
+		m_population->AccountMemory(account);
+	}
+	MemoryUsage clusters_usage;
+	MemoryUsage members_usage;
+	for (const auto clusters :
+	     {&m_clusters.m_households, &m_clusters.m_school_clusters, &m_clusters.m_work_clusters,
+	      &m_clusters.m_primary_community, &m_clusters.m_secondary_community}) {
+		clusters_usage += GetMemoryUsage(*clusters);
+		for (const auto& cluster : *clusters) {
+			members_usage += cluster.GetMemoryUsage();
+		}
+	}
+	account.Add("clusters", clusters_usage);
+	account.Add("cluster members", members_usage);
+	AccountGrowingMemory(account);
+}
+
+void Simulator::AccountGrowingMemory(util::MemoryAccount& account) const
+{
+	account.Add("visitor journal", m_visitors.GetMemoryUsage());
+	account.Add("expatriate journal", m_expatriates.GetMemoryUsage());
+
+	// The commuters who work here have their own person data.
+	MemoryUsage commuters_usage = GetMemoryUsage(m_commuter_ids);
+	for (const auto& entry : m_outgoing_commuters) {
+		commuters_usage += GetMemoryUsage(entry.second);
+	}
+	for (const auto& entry : m_incoming_commuters) {
+		commuters_usage += GetMemoryUsage(entry.second);
+		const auto data_size = entry.second.size() * sizeof(Person::PersonData);
+		commuters_usage += {data_size, data_size};
+	}
+	account.Add("commuters", commuters_usage);
+}
+
+std::size_t Simulator::GetOutgoingCommuterCount() const
+{
+	std::size_t result = 0;
+	for (const auto& entry : m_outgoing_commuters) {
+		result += entry.second.size();
+	}
+	return result;
+}
+
+std::size_t Simulator::GetIncomingCommuterCount() const
+{
+	std::size_t result = 0;
+	for (const auto& entry : m_incoming_commuters) {
+		result += entry.second.size();
+	}
+	return result;
+}
+
 template <LogMode log_level, bool track_index_case, typename local_information_policy>
 void Simulator::UpdateClusters()
 {
@@ -36,14 +107,43 @@ void Simulator::UpdateClusters()
 
 	auto action = [this, log](Cluster& cluster, unsigned int thread_id) {
 		Infector<log_level, track_index_case, local_information_policy>::Execute(
-		    cluster, m_disease_profile, m_rng_handler[thread_id], m_calendar, log);
+		    cluster, m_disease_profile, m_rng_handler[thread_id], m_calendar, log,
+		    m_contact_log ? &m_contact_log->GetBuffer(thread_id) : nullptr,
+		    m_contact_matrices ? &m_contact_matrices->GetCounts(thread_id) : nullptr,
+		    m_town_infections.GetDelta(thread_id));
 	};
 
-	stride::util::parallel::parallel_for(m_clusters.m_households, m_num_threads, action);
-	stride::util::parallel::parallel_for(m_clusters.m_school_clusters, m_num_threads, action);
-	stride::util::parallel::parallel_for(m_clusters.m_work_clusters, m_num_threads, action);
-	stride::util::parallel::parallel_for(m_clusters.m_primary_community, m_num_threads, action);
-	stride::util::parallel::parallel_for(m_clusters.m_secondary_community, m_num_threads, action);
+	// The households are run in batches.
+	using Households = HouseholdInfector<log_level, track_index_case, local_information_policy>;
+	std::vector<std::size_t> household_batches;
+	for (std::size_t first = 0; first < m_clusters.m_households.size(); first += Households::BatchSize) {
+		household_batches.push_back(first);
+	}
+	const int region = GetRegionId();
+	{
+		PerfCounters::Scope counters(m_perf_counters.get(), "Households");
+		Tracer::ParallelFor(
+		    "Households", region, household_batches, m_num_threads,
+		    [this, log](std::size_t first, unsigned int thread_id) {
+			    Households::Execute(
+				m_clusters.m_households, first,
+				std::min(first + Households::BatchSize, m_clusters.m_households.size()),
+				m_disease_profile, m_rng_handler[thread_id], m_calendar, log,
+				m_contact_log ? &m_contact_log->GetBuffer(thread_id) : nullptr,
+				m_contact_matrices ? &m_contact_matrices->GetCounts(thread_id) : nullptr,
+				m_town_infections.GetDelta(thread_id));
+		    });
+	}
+
+	// The other cluster types are run one cluster at a time.
+	const auto update = [this, region, &action](const char* name, std::vector<Cluster>& clusters) {
+		PerfCounters::Scope counters(m_perf_counters.get(), name);
+		Tracer::ParallelFor(name, region, clusters, m_num_threads, action);
+	};
+	update("Schools", m_clusters.m_school_clusters);
+	update("Work", m_clusters.m_work_clusters);
+	update("PrimaryCommunity", m_clusters.m_primary_community);
+	update("SecondaryCommunity", m_clusters.m_secondary_community);
 }
 
 void Simulator::AddPersonToClusters(const Person& person)
@@ -136,6 +236,9 @@ void Simulator::AcceptVisitors(const multiregion::SimulationStepInput& input)
 		if (returning_expat.IsParticipatingInSurvey()) {
 			home_expat.ParticipateInSurvey();
 		}
+		if (home_expat.GetHealth().IsInfected()) {
+			m_town_infections.GetDelta(0).Add(home_expat, 1);
+		}
 
 		// Add the returning expatriate to their clusters.
 		AddPersonToClusters(home_expat);
@@ -156,6 +259,9 @@ void Simulator::AcceptVisitors(const multiregion::SimulationStepInput& input)
 
 		// Set the visitor's health.
 		local_visitor.GetHealth() = visitor.person.GetHealth();
+		if (local_visitor.GetHealth().IsInfected()) {
+			m_town_infections.GetDelta(0).Add(local_visitor, 1);
+		}
 
 		// Add the visitor to their assigned clusters.
 		AddPersonToClusters(local_visitor);
@@ -176,6 +282,9 @@ multiregion::SimulationStepOutput Simulator::ReturnVisitors()
 	for (const auto& expatriate_pair : m_visitors.ExtractVisitors(today)) {
 		for (const auto& expatriate : expatriate_pair.second) {
 			auto person = m_population->extract(expatriate.visitor_id);
+			if (person.GetHealth().IsInfected()) {
+				m_town_infections.GetDelta(0).Add(person, -1);
+			}
 
 			// Recycle the person's id and their household.
 			RecyclePersonId(person.GetId());
@@ -221,7 +330,7 @@ multiregion::SimulationStepOutput Simulator::ReturnVisitors()
 
 	for (auto visitor :
 	     m_population->get_random_persons(*m_travel_rng, number_of_visitors, [this](const Person& p) -> bool {
-		     return !m_visitors.IsVisitor(p.GetId());
+		     return !m_visitors.IsVisitor(p.GetId()) && m_commuter_ids.count(p.GetId()) == 0;
 	     })) {
 		// Pick a region to which we'll send this person.
 		auto target_region_id = target_region_generator.Next();
@@ -236,15 +345,214 @@ multiregion::SimulationStepOutput Simulator::ReturnVisitors()
 		outgoing_visitors.emplace_back(visitor, target_region_id, return_date);
 
 		// Remove the person from the population and add them to the expatriate journal.
+		if (visitor.GetHealth().IsInfected()) {
+			m_town_infections.GetDelta(0).Add(visitor, -1);
+		}
 		m_expatriates.AddExpatriate(m_population->extract(visitor.GetId()));
 	}
 
 	return {std::move(outgoing_visitors), std::move(returning_expatriates)};
 }
 
+void Simulator::AcceptCommuters(const multiregion::SimulationStepInput& input)
+{
+	// Residents who were infected at work in another region may have been infected here since.
+	for (const auto& infections : input.commuter_infections) {
+		const auto& commuters = m_outgoing_commuters[infections.region_id];
+		for (const auto index : infections.commuters) {
+			const auto& commuter = commuters.at(index);
+			if (commuter.GetHealth().IsSusceptible()) {
+				commuter.GetHealth().StartInfection();
+				m_town_infections.GetDelta(0).Add(commuter, 1);
+			}
+		}
+	}
+
+	// The reports are handled in the order of the home regions, so the work clusters of new commuters don't
+	// depend on the order in which the reports arrive.
+	std::vector<const multiregion::CommuterReport*> reports;
+	for (const auto& report : input.commuters) {
+		reports.push_back(&report);
+	}
+	std::sort(
+	    reports.begin(), reports.end(),
+	    [](const multiregion::CommuterReport* a, const multiregion::CommuterReport* b) {
+		    return a->region_id < b->region_id;
+	    });
+	for (const auto report : reports) {
+		auto it = m_incoming_commuters.find(report->region_id);
+		if (it == m_incoming_commuters.end()) {
+			m_incoming_commuters.emplace(report->region_id, CreateIncomingCommuters(*report));
+			continue;
+		}
+		// A commuter who was infected here yesterday is still susceptible in the home region's report.
+		const auto& commuters = it->second;
+		for (std::size_t i = 0; i < commuters.size() && i < report->health.size(); i++) {
+			const auto& health = report->health[i];
+			if (!health.IsSusceptible() || commuters[i].GetHealth().IsSusceptible()) {
+				commuters[i].GetHealth() = health;
+			}
+		}
+	}
+}
+
+void Simulator::UpdateCommuters(bool is_work_off, bool is_school_off, double fraction_infected)
+{
+	for (const auto& entry : m_incoming_commuters) {
+		auto& susceptible = m_incoming_susceptible[entry.first];
+		susceptible.resize(entry.second.size());
+		for (std::size_t i = 0; i < entry.second.size(); i++) {
+			const auto& commuter = entry.second[i];
+			commuter.Update(is_work_off, is_school_off, fraction_infected);
+			susceptible[i] = commuter.GetHealth().IsSusceptible();
+		}
+	}
+}
+
+void Simulator::ReturnCommuters(multiregion::SimulationStepOutput& output)
+{
+	// The commuters are selected after the first day, and described in the first reports.
+	const bool is_first_report = !m_commuters_selected;
+	std::map<multiregion::RegionId, std::vector<geo::CityId>> cities;
+	if (is_first_report) {
+		cities = SelectCommuters();
+	}
+	for (const auto& entry : m_outgoing_commuters) {
+		multiregion::CommuterReport report;
+		report.region_id = entry.first;
+		report.health.reserve(entry.second.size());
+		for (const auto& commuter : entry.second) {
+			report.health.push_back(commuter.GetHealth());
+		}
+		if (is_first_report) {
+			report.ages.reserve(entry.second.size());
+			for (const auto& commuter : entry.second) {
+				report.ages.push_back(commuter.GetAge());
+			}
+			report.cities = std::move(cities[entry.first]);
+		}
+		output.commuters.push_back(std::move(report));
+	}
+
+	for (const auto& entry : m_incoming_commuters) {
+		const auto& susceptible = m_incoming_susceptible[entry.first];
+		multiregion::CommuterInfections infections{entry.first, {}};
+		for (std::size_t i = 0; i < entry.second.size() && i < susceptible.size(); i++) {
+			if (susceptible[i] && !entry.second[i].GetHealth().IsSusceptible()) {
+				infections.commuters.push_back(i);
+			}
+		}
+		if (!infections.commuters.empty()) {
+			output.commuter_infections.push_back(std::move(infections));
+		}
+	}
+}
+
+std::map<multiregion::RegionId, std::vector<geo::CityId>> Simulator::SelectCommuters()
+{
+	m_commuters_selected = true;
+	std::map<multiregion::RegionId, std::vector<geo::CityId>> cities;
+	const auto& model = m_config.common_config->commuting_model;
+	if (!model || !m_population->has_atlas()) {
+		return cities;
+	}
+
+	const auto& atlas = m_population->get_atlas();
+	const auto town_cities = FindTownCities();
+	std::unordered_set<std::size_t> work_clusters;
+	m_population->serial_for([&](const Person& p, unsigned int) {
+		const auto work_id = p.GetClusterId(ClusterType::Work);
+		if (work_id == 0 || IsVisitor(p.GetId())) {
+			return;
+		}
+		const auto town = atlas.FindTownIndex({p.GetClusterId(ClusterType::Household), ClusterType::Household});
+		if (town == Atlas::no_town || town_cities[town] == nullptr) {
+			return;
+		}
+		const auto& flows = model->GetFlows(town_cities[town]->id);
+		if (flows.empty()) {
+			return;
+		}
+		// The fractions of the flows add up to the fraction of the city's workers who work in another region.
+		double draw = m_travel_rng->NextDouble();
+		for (const auto& flow : flows) {
+			if (draw < flow.fraction) {
+				m_outgoing_commuters[flow.region_id].push_back(p);
+				cities[flow.region_id].push_back(flow.city_id);
+				m_commuter_ids.insert(p.GetId());
+				work_clusters.insert(work_id);
+				return;
+			}
+			draw -= flow.fraction;
+		}
+	});
+
+	// Every work cluster drops its commuters in a single pass.
+	for (const auto work_id : work_clusters) {
+		m_clusters.m_work_clusters[work_id].RemovePersons(m_commuter_ids);
+	}
+	return cities;
+}
+
+std::vector<Person> Simulator::CreateIncomingCommuters(const multiregion::CommuterReport& report)
+{
+	// The work clusters of every city.
+	std::unordered_map<geo::CityId, std::vector<unsigned int>> city_work_clusters;
+	if (m_config.common_config->commuting_model && m_population->has_atlas()) {
+		const auto& atlas = m_population->get_atlas();
+		const auto town_cities = FindTownCities();
+		for (unsigned int work_id = 1; work_id < m_clusters.m_work_clusters.size(); work_id++) {
+			const auto town = atlas.FindTownIndex({work_id, ClusterType::Work});
+			if (town != Atlas::no_town && town_cities[town] != nullptr) {
+				city_work_clusters[town_cities[town]->id].push_back(work_id);
+			}
+		}
+	}
+
+	// Commuters get ids from the top of the id range, which the population and the visitors don't use.
+	const auto num_work_clusters = static_cast<unsigned int>(m_clusters.m_work_clusters.size());
+	PersonId id = std::numeric_limits<PersonId>::max() - static_cast<PersonId>(GetIncomingCommuterCount());
+	std::vector<Person> commuters;
+	commuters.reserve(report.ages.size());
+	for (std::size_t i = 0; i < report.ages.size() && i < report.health.size(); i++) {
+		// Commuters work in the city of their flow, or anywhere if that city has no work clusters here.
+		unsigned int work_id = 0;
+		const auto it = i < report.cities.size() ? city_work_clusters.find(report.cities[i])
+							  : city_work_clusters.end();
+		if (it != city_work_clusters.end()) {
+			work_id = it->second[(*m_travel_rng)(static_cast<unsigned int>(it->second.size()))];
+		} else if (num_work_clusters > 1) {
+			work_id = 1 + (*m_travel_rng)(num_work_clusters - 1);
+		}
+		commuters.emplace_back(id--, report.ages[i], 0, 0, work_id, 0, 0, disease::Fate());
+		commuters.back().GetHealth() = report.health[i];
+		if (work_id > 0) {
+			m_clusters.m_work_clusters[work_id].AddPerson(commuters.back());
+		}
+	}
+	return commuters;
+}
+
+std::vector<const geo::City*> Simulator::FindTownCities() const
+{
+	std::vector<const geo::City*> result;
+	const auto& model = *m_config.common_config->commuting_model;
+	for (const auto& town : m_population->get_atlas().getTownMap()) {
+		result.push_back(model.FindNearestCity(GetRegionId(), town.first));
+	}
+	return result;
+}
+
 multiregion::SimulationStepOutput Simulator::TimeStep(const multiregion::SimulationStepInput& input)
 {
-	AcceptVisitors(input);
+	const int region = GetRegionId();
+	TraceSpan step_span("TimeStep", "sim", region);
+	{
+		TraceSpan span("AcceptVisitors", "multiregion", region);
+		PerfCounters::Scope counters(m_perf_counters.get(), "AcceptVisitors");
+		AcceptVisitors(input);
+		AcceptCommuters(input);
+	}
 	shared_ptr<DaysOffInterface> days_off{nullptr};
 
 	// Logic where you compute (on the basis of input/config for initial day
@@ -257,9 +565,18 @@ multiregion::SimulationStepOutput Simulator::TimeStep(const multiregion::Simulat
 
 	const double fraction_infected = m_population->get_fraction_infected();
 
-	m_population->parallel_for(m_num_threads, [=](const Person& p, unsigned int) {
-		p.Update(is_work_off, is_school_off, fraction_infected);
-	});
+	{
+		TraceSpan span("UpdatePopulation", "sim", region);
+		PerfCounters::Scope counters(m_perf_counters.get(), "UpdatePopulation");
+		m_population->parallel_for(m_num_threads, [=](const Person& p, unsigned int thread) {
+			const bool was_infected = p.GetHealth().IsInfected();
+			p.Update(is_work_off, is_school_off, fraction_infected);
+			if (was_infected && !p.GetHealth().IsInfected()) {
+				m_town_infections.GetDelta(thread).Add(p, -1);
+			}
+		});
+		UpdateCommuters(is_work_off, is_school_off, fraction_infected);
+	}
 
 	if (m_track_index_case) {
 		switch (m_log_level) {
@@ -291,7 +608,15 @@ multiregion::SimulationStepOutput Simulator::TimeStep(const multiregion::Simulat
 		}
 	}
 
+	if (m_contact_matrices) {
+		m_contact_matrices->EndDay(m_calendar->GetSimulationDay());
+	}
 	m_calendar->AdvanceDay();
-	return ReturnVisitors();
+	TraceSpan span("ReturnVisitors", "multiregion", region);
+	PerfCounters::Scope counters(m_perf_counters.get(), "ReturnVisitors");
+	auto output = ReturnVisitors();
+	ReturnCommuters(output);
+	m_town_infections.Merge();
+	return output;
 }
 } // end_of_namespace
@@ -6,13 +6,21 @@
 #include "core/DiseaseProfile.h"
 #include "core/LogMode.h"
 #include "core/RngHandler.h"
+#include "geo/City.h"
 #include "multiregion/Visitor.h"
 #include "multiregion/VisitorJournal.h"
+#include "output/ContactLog.h"
+#include "output/ContactMatrices.h"
 #include "pop/Population.h"
+#include "pop/TownInfectionCounter.h"
 #include "sim/SimulationConfig.h"
+#include "util/MemoryAccount.h"
+#include "util/PerfCounters.h"
 
+#include <map>
 #include <memory>
 #include <queue>
+#include <unordered_set>
 #include <vector>
 #include <boost/property_tree/ptree.hpp>
 #include <spdlog/spdlog.h>
@@ -54,6 +62,9 @@ public:
 	/// Gets the simulator's configuration.
 	SingleSimulationConfig GetConfiguration() const { return m_config; }
 
+	/// Gets the id of the simulator's region.
+	multiregion::RegionId GetRegionId() const { return m_config.GetId(); }
+
 	/// Gets the simulator's date.
 	boost::gregorian::date GetDate() const { return m_calendar->GetDate(); }
 
@@ -63,8 +74,29 @@ public:
 	/// Gets the clusters in this simulation. This is for loading.
 	ClusterStruct& GetClusters() { return m_clusters; }
 
+	/// Gets the number of infected persons per town, indexed like the population atlas' GetTowns().
+	/// It is kept up to date by every time step, without a scan of the population.
+	const std::vector<unsigned int>& GetTownInfections() const { return m_town_infections.GetCounts(); }
+
 	/// Sets the population.
-	void SetPopulation(const std::shared_ptr<Population>& population) { m_population = population; }
+	void SetPopulation(const std::shared_ptr<Population>& population);
+
+	/// Logs contacts and transmissions to a binary contact log rather than the logger. A null pointer
+	/// switches back to the logger.
+	void SetContactLog(const std::shared_ptr<output::ContactLog>& contact_log) { m_contact_log = contact_log; }
+
+	/// Counts contacts in contact matrices rather than logging them. A null pointer switches back to
+	/// logging them.
+	void SetContactMatrices(const std::shared_ptr<output::ContactMatrices>& contact_matrices)
+	{
+		m_contact_matrices = contact_matrices;
+	}
+
+	/// Counts hardware events per phase of the time steps. A null pointer stops counting.
+	void SetPerfCounters(const std::shared_ptr<util::PerfCounters>& perf_counters)
+	{
+		m_perf_counters = perf_counters;
+	}
 
 	/// Sets the visitor journal
 	void SetVisitors(const multiregion::VisitorJournal& visitors) { m_visitors = visitors; }
@@ -81,9 +113,25 @@ public:
 	/// Tests if this simulation has run to completion.
 	bool IsDone() const { return m_calendar->GetSimulationDay() >= m_config.common_config->number_of_days; }
 
+	/// Adds the memory of the population, the clusters and the journals to the account.
+	void AccountMemory(util::MemoryAccount& account) const;
+
+	/// Adds the memory of the subsystems that grow while the simulation runs, the journals and the commuters, to
+	/// the account.
+	void AccountGrowingMemory(util::MemoryAccount& account) const;
+
 	/// Tests if the person is a visitor to this simulation.
 	bool IsVisitor(PersonId id) const { return m_visitors.IsVisitor(id); }
 
+	/// Tests if the person is a resident who commutes to work in another region.
+	bool IsCommuter(PersonId id) const { return m_commuter_ids.count(id) != 0; }
+
+	/// Gets the number of residents who commute to work in another region.
+	std::size_t GetOutgoingCommuterCount() const;
+
+	/// Gets the number of commuters from other regions who work in this region.
+	std::size_t GetIncomingCommuterCount() const;
+
 	/// Gets the visitor journal
 	multiregion::VisitorJournal GetVistiorJournal() const { return m_visitors; }
 
@@ -170,6 +218,28 @@ private:
 	/// home regions.
 	multiregion::SimulationStepOutput ReturnVisitors();
 
+	/// Infects the residents who were infected at work in another region, and brings the commuters who work
+	/// here up to date with the reports of their home regions.
+	void AcceptCommuters(const multiregion::SimulationStepInput& input);
+
+	/// Updates the health and the presence of the commuters who work here, like those of the population.
+	void UpdateCommuters(bool is_work_off, bool is_school_off, double fraction_infected);
+
+	/// Selects the commuters at the end of the first day, and adds the reports on this region's commuters
+	/// and the infections of the commuters who work here to the output.
+	void ReturnCommuters(multiregion::SimulationStepOutput& output);
+
+	/// Selects the residents who commute to another region by the commuting flows of their town's nearest
+	/// city, and removes them from their work clusters. Returns the city where every commuter works.
+	std::map<multiregion::RegionId, std::vector<geo::CityId>> SelectCommuters();
+
+	/// Creates the commuters of the first report of a home region, and adds them to work clusters in the
+	/// cities where they work.
+	std::vector<Person> CreateIncomingCommuters(const multiregion::CommuterReport& report);
+
+	/// Finds the nearest city of this region's commuting model for every town of the population's atlas.
+	std::vector<const geo::City*> FindTownCities() const;
+
 	/// Adds the given person to the clusters they've been assigned to.
 	void AddPersonToClusters(const Person& person);
 
@@ -200,6 +270,15 @@ private:
 	/// Log for this simulator.
 	std::shared_ptr<spdlog::logger> m_log;
 
+	/// Binary log for contacts and transmissions; if null, they go to m_log.
+	std::shared_ptr<output::ContactLog> m_contact_log;
+
+	/// Contact matrices for the contacts; if not null, contacts are counted rather than logged.
+	std::shared_ptr<output::ContactMatrices> m_contact_matrices;
+
+	/// Hardware performance counters for the phases of a time step; may be null.
+	std::shared_ptr<util::PerfCounters> m_perf_counters;
+
 private:
 	/// The number of (OpenMP) threads.
 	unsigned int m_num_threads;
@@ -226,9 +305,28 @@ private:
 	/// Expatriate journal.
 	stride::multiregion::ExpatriateJournal m_expatriates;
 
+	/// Residents who commute to another region, per work region, in the order of the reports on them.
+	std::map<multiregion::RegionId, std::vector<Person>> m_outgoing_commuters;
+
+	/// The ids of the residents who commute to another region.
+	std::unordered_set<PersonId> m_commuter_ids;
+
+	/// Tells if the residents who commute to another region have been selected.
+	bool m_commuters_selected;
+
+	/// Commuters from other regions who work here, per home region, in the order of the reports on them.
+	/// They aren't part of the population; only their work clusters hold them.
+	std::map<multiregion::RegionId, std::vector<Person>> m_incoming_commuters;
+
+	/// Tells for every commuter who works here if they were susceptible before today's contacts.
+	std::map<multiregion::RegionId, std::vector<bool>> m_incoming_susceptible;
+
 	/// Struct containing all Clusters.
 	ClusterStruct m_clusters;
 
+	/// Infected persons per town.
+	TownInfectionCounter m_town_infections;
+
 	/// A list of unused households which can are eligible for recycling.
 	std::queue<std::size_t> m_unused_households;
 
@@ -6,15 +6,24 @@
 #include "core/ContactProfile.h"
 #include "core/Infector.h"
 #include "core/LogMode.h"
+#include "output/ContactLog.h"
+#include "output/ContactMatrices.h"
 #include "pop/Population.h"
 #include "pop/PopulationBuilder.h"
 #include "sim/SimulationConfig.h"
 #include "util/Errors.h"
 #include "util/InstallDirs.h"
+#include "util/MemoryAccount.h"
+#include "util/Parallel.h"
+#include "util/PerfCounters.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
@@ -74,6 +83,30 @@ shared_ptr<Simulator> SimulatorBuilder::Build(
 shared_ptr<Simulator> SimulatorBuilder::Build(
     const SingleSimulationConfig& config, const ptree& pt_disease, const ptree& pt_contact,
     const std::shared_ptr<spdlog::logger>& log, unsigned int number_of_threads)
+{
+	return Build(config, pt_disease, pt_contact, log, number_of_threads, nullptr, true);
+}
+
+shared_ptr<Simulator> SimulatorBuilder::Build(
+    const SingleSimulationConfig& config, const std::shared_ptr<Population>& population,
+    const std::shared_ptr<spdlog::logger>& log, unsigned int num_threads, bool initialize_clusters)
+{
+	// Disease file.
+	ptree pt_disease;
+	InstallDirs::ReadXmlFile(config.common_config->disease_config_file_name, InstallDirs::GetDataDir(), pt_disease);
+
+	// Contact file.
+	ptree pt_contact;
+	InstallDirs::ReadXmlFile(config.common_config->contact_matrix_file_name, InstallDirs::GetDataDir(), pt_contact);
+
+	// Done.
+	return Build(config, pt_disease, pt_contact, log, num_threads, population, initialize_clusters);
+}
+
+shared_ptr<Simulator> SimulatorBuilder::Build(
+    const SingleSimulationConfig& config, const ptree& pt_disease, const ptree& pt_contact,
+    const std::shared_ptr<spdlog::logger>& log, unsigned int number_of_threads, shared_ptr<Population> population,
+    bool initialize_clusters)
 {
 	auto sim = make_shared<Simulator>();
 
@@ -94,16 +127,33 @@ shared_ptr<Simulator> SimulatorBuilder::Build(
 
 	// Get log level.
 	sim->m_log_level = config.log_config->log_level;
+	if (config.log_config->aggregate_contacts && sim->m_log_level == LogMode::Contacts) {
+		sim->m_contact_matrices = make_shared<output::ContactMatrices>(
+		    config.log_config->output_prefix + "_sim" + to_string(config.GetId()) + "_contact_matrix.csv",
+		    sim->m_num_threads, config.log_config->contact_matrix_per_day, config.log_config->contact_sample_rate);
+	}
+	if (config.log_config->perf_counters) {
+		sim->m_perf_counters = make_shared<util::PerfCounters>(
+		    config.log_config->output_prefix + "_sim" + to_string(config.GetId()) + "_counters.csv",
+		    sim->m_num_threads);
+	}
+	if (config.log_config->binary_contact_log && sim->m_log_level != LogMode::None) {
+		sim->m_contact_log = make_shared<output::ContactLog>(
+		    config.log_config->output_prefix + "_sim" + to_string(config.GetId()) + "_contacts.bin",
+		    sim->m_num_threads);
+	}
 
 	// Create a random number generator for the simulator.
 	auto rng = std::make_shared<Random>(config.common_config->rng_seed);
 
 	// Build population.
 	sim->m_travel_rng = rng;
-	sim->m_population = PopulationBuilder::Build(config, pt_disease, *rng, log);
+	sim->SetPopulation(population ? population : PopulationBuilder::Build(config, pt_disease, *rng, log));
 
 	// Initialize clusters.
-	InitializeClusters(sim);
+	if (initialize_clusters) {
+		InitializeClusters(sim);
+	}
 
 	// Initialize disease profile.
 	sim->m_disease_profile.Initialize(config, pt_disease);
@@ -127,52 +177,136 @@ shared_ptr<Simulator> SimulatorBuilder::Build(
 	return sim;
 }
 
+namespace {
+
+/// A member of a cluster, as it is scattered in the membership array of a cluster type: the index of the
+/// person in the list of persons, and what the members of a cluster are sorted on.
+struct ClusterMember
+{
+	PersonId id;
+	unsigned int index;
+	bool immune;
+};
+
+/// Fills the clusters of one type with the given persons, given the number of members of every cluster.
+/// The members of all clusters are scattered into one array, in which every cluster has the range
+/// [offsets[i], offsets[i + 1]) (a compressed sparse row layout). The members of a cluster are then put in the
+/// order in which Cluster::AddPerson puts them when they are added by id: the non-immune ones first. The array
+/// is only used while building: the clusters copy their members from it.
+void FillClusters(
+    vector<Cluster>& clusters, ClusterType type, vector<Person>& persons, unsigned int num_threads,
+    const unique_ptr<atomic<unsigned int>[]>& counts)
+{
+	vector<size_t> offsets(clusters.size() + 1, 0U);
+	for (size_t i = 0; i < clusters.size(); i++) {
+		offsets[i + 1] = offsets[i] + counts[i];
+	}
+
+	vector<ClusterMember> members(offsets.back());
+	unique_ptr<atomic<size_t>[]> next(new atomic<size_t>[clusters.size()]);
+	for (size_t i = 0; i < clusters.size(); i++) {
+		next[i] = offsets[i];
+	}
+	util::parallel::parallel_for(persons, num_threads, [&](const Person& p, unsigned int) {
+		const auto id = p.GetClusterId(type);
+		if (id > 0) {
+			const auto index = static_cast<unsigned int>(&p - persons.data());
+			members[next[id]++] = {p.GetId(), index, p.GetHealth().IsImmune()};
+		}
+	});
+
+	const auto order = [](const ClusterMember& a, const ClusterMember& b) {
+		return a.immune != b.immune ? b.immune : a.id < b.id;
+	};
+	util::parallel::parallel_for(clusters, num_threads, [&](Cluster& cluster, unsigned int) {
+		const auto i = &cluster - clusters.data();
+		const auto first = members.begin() + offsets[i];
+		const auto last = members.begin() + offsets[i + 1];
+		sort(first, last, order);
+		cluster.Reserve(last - first);
+		for (auto it = first; it != last; ++it) {
+			cluster.AddPerson(persons[it->index]);
+		}
+	});
+}
+
+} // namespace
+
 void SimulatorBuilder::InitializeClusters(shared_ptr<Simulator> sim)
 {
-	// Determine number of clusters.
-	unsigned int max_id_households = 0U;
-	unsigned int max_id_school_clusters = 0U;
-	unsigned int max_id_work_clusters = 0U;
-	unsigned int max_id_primary_community = 0U;
-	unsigned int max_id_secondary_community = 0U;
-	Population& population = *sim->m_population;
-
-	population.serial_for([&](const Person& p, unsigned int) -> void {
-		max_id_households = std::max(max_id_households, p.GetClusterId(ClusterType::Household));
-		max_id_school_clusters = std::max(max_id_school_clusters, p.GetClusterId(ClusterType::School));
-		max_id_work_clusters = std::max(max_id_work_clusters, p.GetClusterId(ClusterType::Work));
-		max_id_primary_community =
-		    std::max(max_id_primary_community, p.GetClusterId(ClusterType::PrimaryCommunity));
-		max_id_secondary_community =
-		    std::max(max_id_secondary_community, p.GetClusterId(ClusterType::SecondaryCommunity));
+	const Population& population = *sim->m_population;
+	const auto num_threads = max(sim->m_num_threads, 1U);
+	const array<vector<Cluster>*, NumOfClusterTypes()> cluster_vectors{
+	    {&sim->m_clusters.m_households, &sim->m_clusters.m_school_clusters, &sim->m_clusters.m_work_clusters,
+	     &sim->m_clusters.m_primary_community, &sim->m_clusters.m_secondary_community}};
+
+	// Determine number of clusters: every thread looks for the largest ids in its part of the population.
+	vector<array<unsigned int, NumOfClusterTypes()>> max_ids(num_threads);
+	for (auto& ids : max_ids) {
+		ids.fill(0U);
+	}
+	population.parallel_for(num_threads, [&max_ids](const Person& p, unsigned int thread) {
+		for (size_t t = 0; t < NumOfClusterTypes(); t++) {
+			max_ids[thread][t] = max(max_ids[thread][t], p.GetClusterId(static_cast<ClusterType>(t)));
+		}
 	});
 
 	// Keep separate id counter to provide a unique id for every cluster.
 	unsigned int cluster_id = 1;
-
-	for (size_t i = 0; i <= max_id_households; i++) {
-		sim->m_clusters.m_households.emplace_back(Cluster(cluster_id, ClusterType::Household));
-		cluster_id++;
-	}
-	for (size_t i = 0; i <= max_id_school_clusters; i++) {
-		sim->m_clusters.m_school_clusters.emplace_back(Cluster(cluster_id, ClusterType::School));
-		cluster_id++;
+	for (size_t t = 0; t < NumOfClusterTypes(); t++) {
+		unsigned int max_id = 0U;
+		for (const auto& ids : max_ids) {
+			max_id = max(max_id, ids[t]);
+		}
+		auto& clusters = *cluster_vectors[t];
+		clusters.reserve(max_id + 1);
+		for (size_t i = 0; i <= max_id; i++) {
+			clusters.emplace_back(cluster_id, static_cast<ClusterType>(t));
+			cluster_id++;
+		}
 	}
-	for (size_t i = 0; i <= max_id_work_clusters; i++) {
-		sim->m_clusters.m_work_clusters.emplace_back(Cluster(cluster_id, ClusterType::Work));
-		cluster_id++;
-	}
-	for (size_t i = 0; i <= max_id_primary_community; i++) {
-		sim->m_clusters.m_primary_community.emplace_back(Cluster(cluster_id, ClusterType::PrimaryCommunity));
-		cluster_id++;
+
+	// Count the members of every cluster.
+	array<unique_ptr<atomic<unsigned int>[]>, NumOfClusterTypes()> counts;
+	for (size_t t = 0; t < NumOfClusterTypes(); t++) {
+		counts[t].reset(new atomic<unsigned int>[cluster_vectors[t]->size()]());
 	}
-	for (size_t i = 0; i <= max_id_secondary_community; i++) {
-		sim->m_clusters.m_secondary_community.emplace_back(
-		    Cluster(cluster_id, ClusterType::SecondaryCommunity));
-		cluster_id++;
+	population.parallel_for(num_threads, [&counts](const Person& p, unsigned int) {
+		// Cluster id '0' means "not present in any cluster of that type".
+		for (size_t t = 0; t < NumOfClusterTypes(); t++) {
+			const auto id = p.GetClusterId(static_cast<ClusterType>(t));
+			if (id > 0) {
+				counts[t][id].fetch_add(1U, memory_order_relaxed);
+			}
+		}
+	});
+
+	// Fail before the members are allocated if they wouldn't fit in the memory budget.
+	const auto budget = sim->m_config.common_config->memory_budget;
+	if (budget > 0U) {
+		size_t num_members = 0U;
+		for (size_t t = 0; t < NumOfClusterTypes(); t++) {
+			for (size_t i = 0; i < cluster_vectors[t]->size(); i++) {
+				num_members += counts[t][i];
+			}
+		}
+		util::MemoryAccount account;
+		sim->AccountMemory(account);
+		const auto member_bytes = num_members * Cluster::GetMemberSize();
+		account.Add("cluster members", {member_bytes, member_bytes});
+		account.CheckBudget(
+		    budget,
+		    "of simulation " + to_string(sim->m_config.GetId()) + " before the cluster members are allocated");
 	}
 
-	population.serial_for([&](const Person& p, unsigned int) -> void { sim->AddPersonToClusters(p); });
+	// Add the members, one cluster type at a time to limit the memory that is needed.
+	vector<Person> persons;
+	persons.reserve(population.size());
+	population.serial_for([&persons](const Person& p, unsigned int) { persons.push_back(p); });
+	for (size_t t = 0; t < NumOfClusterTypes(); t++) {
+		FillClusters(*cluster_vectors[t], static_cast<ClusterType>(t), persons, num_threads, counts[t]);
+		counts[t].reset();
+	}
 }
 
 } // end_of_namespace
@@ -47,7 +47,19 @@ public:
 	    const boost::property_tree::ptree& pt_contact, const std::shared_ptr<spdlog::logger>& log,
 	    unsigned int number_of_threads = 1U);
 
+	/// Build simulator around an existing population, e.g. one restored from a checkpoint. The clusters are
+	/// left empty unless initialize_clusters is set, for callers that restore them themselves.
+	static std::shared_ptr<Simulator> Build(
+	    const SingleSimulationConfig& config, const std::shared_ptr<Population>& population,
+	    const std::shared_ptr<spdlog::logger>& log, unsigned int num_threads = 1U, bool initialize_clusters = true);
+
 private:
+	/// Build simulator. The population is built from the configuration, unless one is given.
+	static std::shared_ptr<Simulator> Build(
+	    const SingleSimulationConfig& config, const boost::property_tree::ptree& pt_disease,
+	    const boost::property_tree::ptree& pt_contact, const std::shared_ptr<spdlog::logger>& log,
+	    unsigned int number_of_threads, std::shared_ptr<Population> population, bool initialize_clusters);
+
 	/// Initialize the clusters.
 	static void InitializeClusters(std::shared_ptr<Simulator> sim);
 };
@@ -0,0 +1,38 @@
+#include "output/ContactLog.h"
+
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <tclap/CmdLine.h>
+
+using namespace std;
+using namespace stride;
+using namespace TCLAP;
+
+/// Writes a binary contact log in the text format of the logfile.
+int main(int argc, char** argv)
+{
+	int exit_status = EXIT_SUCCESS;
+	try {
+		CmdLine cmd("stride_logdecode", ' ', "1.0", false);
+		UnlabeledValueArg<string> input_Arg("input", "Binary contact log", true, "", "CONTACT LOG", cmd);
+		ValueArg<string> output_Arg(
+		    "o", "output", "Text file to append to, instead of the standard output", false, "", "LOG FILE", cmd);
+		cmd.parse(argc, argv);
+
+		ifstream in(input_Arg.getValue().c_str(), ios::binary);
+		if (!in) {
+			throw runtime_error("Cannot open " + input_Arg.getValue());
+		}
+		if (output_Arg.getValue().empty()) {
+			output::ContactLog::Decode(in, cout);
+		} else {
+			ofstream out(output_Arg.getValue().c_str(), ios::app);
+			output::ContactLog::Decode(in, out);
+		}
+	} catch (exception& e) {
+		exit_status = EXIT_FAILURE;
+		cerr << "\nEXCEPION THROWN: " << e.what() << endl;
+	}
+	return exit_status;
+}
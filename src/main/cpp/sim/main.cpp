@@ -1,9 +1,12 @@
+#include "run_bench.h"
 #include "run_stride.h"
 
 #include <exception>
 #include <iostream>
 #include <tclap/CmdLine.h>
+#include "util/Parallel.h"
 #include "util/Signals.h"
+#include "util/Trace.h"
 
 using namespace std;
 using namespace stride;
@@ -35,6 +38,31 @@ int main(int argc, char** argv)
 		    "i", "interval", "the amount of days between each checkpoint. The first and last are not counted.",
 		    false, -1, "", cmd);
 
+		ValueArg<string> trace_file(
+		    "t", "trace", "Write a trace of the phases of the run to the given file, in Chrome's JSON trace format",
+		    false, "", "TRACE FILE", cmd);
+
+		SwitchArg bench_Arg(
+		    "b", "bench", "Measure the scaling of the simulator on generated populations instead of running it",
+		    cmd, false);
+		ValueArg<string> bench_model_Arg(
+		    "", "bench-model", "Population model of the benchmark", false, "population_model_default.xml",
+		    "POPULATION MODEL", cmd);
+		ValueArg<unsigned int> bench_persons_Arg(
+		    "", "bench-persons",
+		    "Persons of the benchmark: in total for strong scaling, per thread for weak scaling (default: the "
+		    "size of the model)",
+		    false, 0U, "COUNT", cmd);
+		ValueArg<unsigned int> bench_days_Arg(
+		    "", "bench-days", "Days simulated by the benchmark", false, 10U, "COUNT", cmd);
+		ValueArg<unsigned int> bench_threads_Arg(
+		    "", "bench-threads", "Largest number of threads per region of the benchmark", false,
+		    util::parallel::get_number_of_threads(), "COUNT", cmd);
+		ValueArg<unsigned int> bench_regions_Arg(
+		    "", "bench-regions", "Largest number of regions of the benchmark", false, 1U, "COUNT", cmd);
+		SwitchArg bench_weak_Arg(
+		    "", "bench-weak", "Grow the population with the number of threads (weak scaling)", cmd, false);
+
 		cmd.parse(argc, argv);
 
 		// -----------------------------------------------------------------------------------------
@@ -50,9 +78,24 @@ int main(int argc, char** argv)
 		// -----------------------------------------------------------------------------------------
 		// Run the Stride simulator.
 		// -----------------------------------------------------------------------------------------
-		run_stride(
-		    index_case_Arg.getValue(), config_file_Arg.getValue(), h5File.getValue(), date.getValue(),
-		    generate_vis_Arg.getValue(), !hdf5.getValue(), interval.getValue());
+		util::TraceSession trace(trace_file.getValue());
+		if (bench_Arg.getValue()) {
+			ScalingBenchConfig bench_config;
+			if (!config_file_Arg.getValue().empty()) {
+				bench_config.config_file_name = config_file_Arg.getValue();
+			}
+			bench_config.population_model = bench_model_Arg.getValue();
+			bench_config.num_persons = bench_persons_Arg.getValue();
+			bench_config.num_days = bench_days_Arg.getValue();
+			bench_config.max_threads = bench_threads_Arg.getValue();
+			bench_config.max_regions = bench_regions_Arg.getValue();
+			bench_config.weak_scaling = bench_weak_Arg.getValue();
+			run_scaling_bench(bench_config, cout);
+		} else {
+			run_stride(
+			    index_case_Arg.getValue(), config_file_Arg.getValue(), h5File.getValue(), date.getValue(),
+			    generate_vis_Arg.getValue(), !hdf5.getValue(), interval.getValue());
+		}
 	} catch (exception& e) {
 
 		exit_status = EXIT_FAILURE;
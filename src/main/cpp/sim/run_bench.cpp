@@ -0,0 +1,142 @@
+#include "run_bench.h"
+
+#include "multiregion/ParallelSimulationManager.h"
+#include "sim/SimulationConfig.h"
+#include "sim/Simulator.h"
+#include "util/InstallDirs.h"
+#include "util/ResourceUsage.h"
+
+#include <boost/property_tree/ptree.hpp>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+
+namespace stride {
+
+using namespace std;
+using namespace util;
+using boost::property_tree::ptree;
+
+namespace {
+
+/// The result of a simulation task of the benchmark, which writes no output.
+class ScalingBenchTaskResult
+{
+public:
+	ScalingBenchTaskResult(multiregion::RegionId, bool) {}
+
+	void BeforeSimulatorStep(Simulator&) {}
+
+	void AfterSimulatorStep(const Simulator&) {}
+};
+
+/// Builds and runs the regions at a number of regions and threads.
+ScalingBenchResult Measure(
+    const ScalingBenchConfig& bench_config, const ptree& pt_base, unsigned int num_persons, unsigned int regions,
+    unsigned int threads, const shared_ptr<spdlog::logger>& log)
+{
+	// Every region generates a population with the model.
+	ptree pt_run = pt_base;
+	pt_run.erase("population_file");
+	pt_run.erase("travel_model");
+	pt_run.erase("travel_file");
+	for (unsigned int region = 0; region < regions; region++) {
+		pt_run.add("population_file", bench_config.population_model);
+	}
+	const auto persons = bench_config.weak_scaling ? num_persons * threads : max(num_persons / regions, 1U);
+	pt_run.put("population_size", persons);
+	pt_run.put("num_days", bench_config.num_days);
+	pt_run.put("log_level", "None");
+	pt_run.put("generate_person_file", 0);
+	MultiSimulationConfig config;
+	config.Parse(pt_run);
+	config.common_config->generate_vis_file = false;
+	config.common_config->use_checkpoint = false;
+
+	ResetPeakResidentSetSize();
+	const auto build_start = chrono::steady_clock::now();
+	using Manager = multiregion::ParallelSimulationManager<ScalingBenchTaskResult, multiregion::RegionId>;
+	Manager manager{regions, threads};
+	vector<shared_ptr<multiregion::SimulationTask<ScalingBenchTaskResult>>> tasks;
+	for (const auto& single_config : config.GetSingleConfigs()) {
+		tasks.push_back(manager.CreateSimulation(single_config, log, single_config.GetId()));
+	}
+	const auto run_start = chrono::steady_clock::now();
+	manager.WaitAll();
+	const auto run_end = chrono::steady_clock::now();
+
+	ScalingBenchResult result{};
+	result.regions = regions;
+	result.threads = threads;
+	for (const auto& task : tasks) {
+		result.persons += task->GetPopulationSize();
+	}
+	result.build_seconds = chrono::duration<double>(run_start - build_start).count();
+	result.run_seconds = chrono::duration<double>(run_end - run_start).count();
+	result.days_per_second = bench_config.num_days / result.run_seconds;
+	result.person_days_per_second = result.persons * result.days_per_second;
+	result.peak_rss = GetPeakResidentSetSize();
+	return result;
+}
+
+} // end_of_namespace
+
+std::vector<unsigned int> get_scaling_steps(unsigned int maximum)
+{
+	vector<unsigned int> steps;
+	for (unsigned int step = 1U; step < maximum; step *= 2U) {
+		steps.push_back(step);
+	}
+	steps.push_back(max(maximum, 1U));
+	return steps;
+}
+
+std::vector<ScalingBenchResult> run_scaling_bench(const ScalingBenchConfig& bench_config, std::ostream& out)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile(bench_config.config_file_name, InstallDirs::GetCurrentDir(), pt_config);
+	const ptree pt_base = pt_config.get_child("run");
+
+	// Without a number of persons, the size of the population model is used.
+	auto num_persons = bench_config.num_persons;
+	if (num_persons == 0U) {
+		ptree pt_model;
+		InstallDirs::ReadXmlFile(bench_config.population_model, InstallDirs::GetDataDir(), pt_model);
+		num_persons = pt_model.get<unsigned int>("population_model.population_size");
+	}
+	auto log = make_shared<spdlog::logger>("scaling_bench", make_shared<spdlog::sinks::null_sink_st>());
+
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+	out << (bench_config.weak_scaling ? "Weak" : "Strong") << " scaling of " << bench_config.population_model
+	    << " over " << bench_config.num_days << " days" << endl;
+	out << setw(8) << "regions" << setw(8) << "threads" << setw(12) << "persons" << setw(10) << "build ms"
+	    << setw(10) << "run ms" << setw(10) << "days/s" << setw(16) << "person-days/s" << setw(11) << "efficiency"
+	    << setw(14) << "peak RSS MiB" << endl;
+
+	vector<ScalingBenchResult> results;
+	for (unsigned int regions : get_scaling_steps(bench_config.max_regions)) {
+		for (unsigned int threads : get_scaling_steps(bench_config.max_threads)) {
+			auto result = Measure(bench_config, pt_base, num_persons, regions, threads, log);
+			const auto& base = results.empty() ? result : results.front();
+			result.efficiency =
+			    result.person_days_per_second / (regions * threads * base.person_days_per_second);
+			out << fixed << setw(8) << result.regions << setw(8) << result.threads << setw(12)
+			    << result.persons << setprecision(1) << setw(10) << 1000.0 * result.build_seconds
+			    << setw(10) << 1000.0 * result.run_seconds << setprecision(2) << setw(10)
+			    << result.days_per_second << setprecision(0) << setw(16) << result.person_days_per_second
+			    << setprecision(2) << setw(11) << result.efficiency << setprecision(1) << setw(14)
+			    << result.peak_rss / (1024.0 * 1024.0) << endl;
+			results.push_back(result);
+		}
+	}
+	out.flags(flags);
+	out.precision(precision);
+	return results;
+}
+
+} // end_of_namespace
@@ -0,0 +1,74 @@
+#ifndef RUN_BENCH_H_INCLUDED
+#define RUN_BENCH_H_INCLUDED
+
+/**
+ * @file
+ * The scaling benchmark of `stride --bench`.
+ */
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace stride {
+
+/**
+ * The settings of the scaling benchmark. It generates a population per region with a population model, and runs
+ * the regions for a number of days at every combination of the numbers of regions and threads per region.
+ */
+struct ScalingBenchConfig
+{
+	/// The configuration file that provides the disease, the contacts, the calendar and the files that the
+	/// population generator reads (geodistribution profile and reference households).
+	std::string config_file_name = "config/run_popgen_small.xml";
+
+	/// The population model, in the data directory.
+	std::string population_model = "population_model_default.xml";
+
+	/// For strong scaling, the number of persons of all regions together; for weak scaling, the number of
+	/// persons per thread. 0 uses the size of the population model.
+	unsigned int num_persons = 0U;
+
+	/// The number of days that are simulated.
+	unsigned int num_days = 10U;
+
+	/// The largest number of threads per region.
+	unsigned int max_threads = 1U;
+
+	/// The largest number of regions.
+	unsigned int max_regions = 1U;
+
+	/// Whether the work grows with the number of threads (weak scaling) or stays the same (strong scaling).
+	bool weak_scaling = false;
+};
+
+/**
+ * The measurements of the scaling benchmark at a number of regions and threads.
+ */
+struct ScalingBenchResult
+{
+	unsigned int regions;
+	unsigned int threads;
+	std::size_t persons;
+	double build_seconds;
+	double run_seconds;
+	double days_per_second;
+	double person_days_per_second;
+
+	/// The person-days per second per thread, as a fraction of those with one region and one thread.
+	double efficiency;
+
+	/// The peak resident set size during the build and the run, in bytes.
+	std::size_t peak_rss;
+};
+
+/// The numbers of threads or regions that are measured up to a maximum: the powers of two, and the maximum.
+std::vector<unsigned int> get_scaling_steps(unsigned int maximum);
+
+/// Runs the scaling benchmark and prints a row of the table per measurement.
+std::vector<ScalingBenchResult> run_scaling_bench(const ScalingBenchConfig& bench_config, std::ostream& out);
+
+} // end_of_namespace
+
+#endif // end-of-include-guard
@@ -1,27 +1,32 @@
 #include "run_stride.h"
 
 #include "checkpoint/CheckPoint.h"
+#include "checkpoint/CheckPointWriter.h"
 #include "multiregion/ParallelSimulationManager.h"
 #include "multiregion/SimulationManager.h"
 #include "multiregion/TravelModel.h"
 #include "output/CasesFile.h"
 #include "output/PersonFile.h"
 #include "output/SummaryFile.h"
+#include "output/TimeSeriesFile.h"
 #include "output/VisualizerFile.h"
 #include "sim/Simulator.h"
 #include "sim/SimulatorBuilder.h"
 #include "util/Errors.h"
 #include "util/ExternalVars.h"
 #include "util/InstallDirs.h"
+#include "util/MemoryAccount.h"
 #include "util/Parallel.h"
 #include "util/Stopwatch.h"
 #include "util/TimeStamp.h"
+#include "util/Trace.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 #include <spdlog/spdlog.h>
 
+#include <atomic>
 #include <cmath>
 #include <iomanip>
 #include <ios>
@@ -47,9 +52,28 @@ bool load = false;
 boost::gregorian::date date;
 
 #if USE_HDF5
-std::unique_ptr<CheckPoint> cp;
+std::shared_ptr<CheckPoint> cp;
+std::unique_ptr<CheckPointWriter> cp_writer;
+std::shared_ptr<const CheckPoint::Snapshot> loaded_snapshot;
+std::mutex loaded_snapshot_mutex;
 #endif
 
+namespace {
+
+/// The number of messages that the log of a region can queue.
+const std::size_t log_queue_size = 1048576;
+
+/// The memory of the queue of an asynchronous log, which is allocated when the log is created. Every slot holds
+/// a sequence number and a message: the logger name, the level, the time, the thread id and the text.
+MemoryUsage GetLogQueueMemory()
+{
+	const auto slot_size = sizeof(std::atomic<size_t>) + 2 * sizeof(std::string) + sizeof(size_t) +
+			       sizeof(spdlog::log_clock::time_point) + sizeof(size_t);
+	return {log_queue_size * slot_size, log_queue_size * slot_size};
+}
+
+} // end_of_namespace
+
 /// Performs an action just before a simulator step is performed.
 void StrideSimulatorResult::BeforeSimulatorStep(Simulator& sim)
 {
@@ -58,22 +82,43 @@ void StrideSimulatorResult::BeforeSimulatorStep(Simulator& sim)
 #if USE_HDF5
 	if (sim.GetConfiguration().common_config->use_checkpoint) {
 		if (load && day == 0) {
+			TraceSpan span("LoadSnapshot", "checkpoint", sim.GetRegionId());
 			std::cout << "Loading old Simulation" << std::endl;
-			cp->OpenFile();
-			cp->LoadCheckPoint(date, sim);
-			cp->CloseFile();
+			std::shared_ptr<const CheckPoint::Snapshot> snapshot;
+			{
+				// The file is read once, by the first simulator that needs it.
+				lock_guard<mutex> lock(loaded_snapshot_mutex);
+				if (!loaded_snapshot) {
+					cp_writer->Flush();
+					cp->OpenFile();
+					loaded_snapshot = cp->LoadSnapshot(date);
+					cp->CloseFile();
+				}
+				snapshot = loaded_snapshot;
+			}
+			CheckPoint::RestoreSnapshot(*snapshot, sim);
 			std::cout << "Loaded old Simulation" << std::endl;
 		}
 		if (day == 0 && !load) {
 			// saves the start configuration
-			cp->OpenFile();
-			cp->SaveCheckPoint(sim, day);
-			cp->CloseFile();
+			TraceSpan span("TakeSnapshot", "checkpoint", sim.GetRegionId());
+			cp_writer->Enqueue(CheckPoint::TakeSnapshot(sim, day));
 		}
 	}
 #endif
 
+	// The memory is reported at startup, when the population and the clusters have been built.
+	const bool report = sim.GetConfiguration().log_config->memory_report_interval > 0;
+	if (day == 0 && (report || sim.GetConfiguration().common_config->memory_budget > 0)) {
+		AccountMemory(sim, report);
+	}
+
 	if (util::INTERRUPT) {
+#if USE_HDF5
+		if (cp_writer) {
+			cp_writer->Flush();
+		}
+#endif
 		exit(-1);
 	}
 }
@@ -86,37 +131,109 @@ void StrideSimulatorResult::AfterSimulatorStep(const Simulator& sim)
 		// saves the last configuration or configuration after an interval.
 		if (sim.IsDone() || util::INTERRUPT ||
 		    (day + 1) % sim.GetConfiguration().common_config->checkpoint_interval == 0) {
-			cp->OpenFile();
-			cp->SaveCheckPoint(sim, day);
-			cp->CloseFile();
+			// The snapshot is written in the background, while the next step runs.
+			TraceSpan span("TakeSnapshot", "checkpoint", sim.GetRegionId());
+			cp_writer->Enqueue(CheckPoint::TakeSnapshot(sim, day));
 		}
 	}
 #endif
 	auto pop = sim.GetPopulation();
 	run_clock.Stop();
-	auto infected_count = sim.GetPopulation()->get_infected_count();
+	unsigned int infected_count;
+	if (sim.GetConfiguration().log_config->generate_timeseries_file) {
+		// The record counts the cases too, so the population is only scanned once.
+		if (!timeseries_file) {
+			timeseries_file = make_shared<TimeSeriesFile>(
+			    sim.GetConfiguration().log_config->output_prefix + "_sim" + to_string(id),
+			    pop->has_atlas() ? &pop->get_atlas() : nullptr);
+		}
+		TraceSpan span("TimeSeriesFile", "output", sim.GetRegionId());
+		const auto record = TimeSeriesRecord::Count(sim, id, day);
+		timeseries_file->Print(record);
+		infected_count = record.GetCases();
+	} else {
+		infected_count = sim.GetPopulation()->get_infected_count();
+	}
 	cases.push_back(infected_count);
 
 	if (generate_vis_data && pop->has_atlas()) {
-		visualizer_data.AddDay(pop);
-		// Every 10 days, or if the simulation is done: Update the visualization file.
-		if (sim.IsDone() || util::INTERRUPT || (day + 1) % 10 == 0) {
-			VisualizerFile vis_file(sim.GetConfiguration().log_config->output_prefix);
-			vis_file.Print(visualizer_data);
+		TraceSpan span("VisualizerFile", "output", sim.GetRegionId());
+		if (!visualizer_file) {
+			visualizer_data.RegisterTowns(pop->get_atlas());
+			visualizer_file = make_shared<VisualizerFile>(sim.GetConfiguration().log_config->output_prefix);
 		}
+		// The simulator keeps the per town counts, so adding a day doesn't scan the population.
+		visualizer_data.AddDay(sim.GetTownInfections());
+		visualizer_file->Print(visualizer_data);
 	}
 
 	day++;
 
+	// Every subsystem is accounted with the reports, and on the last day; that sums every cluster, which is too
+	// slow to do every day. The other days only sum the subsystems that grow.
+	const auto report_interval = sim.GetConfiguration().log_config->memory_report_interval;
+	const bool report = report_interval > 0 && day % report_interval == 0;
+	const bool budget = sim.GetConfiguration().common_config->memory_budget > 0;
+	if (report || (budget && sim.IsDone())) {
+		AccountMemory(sim, report);
+	} else if (budget) {
+		CheckMemoryBudget(sim);
+	}
+
 	lock_guard<mutex> lock(io_mutex);
 	cout << "Simulation " << setw(3) << id << ": simulated day: " << setw(5) << (day - 1)
 	     << "     Done, infected count: " << setw(10) << infected_count << endl;
 
 	if (util::INTERRUPT) {
+#if USE_HDF5
+		if (cp_writer) {
+			cp_writer->Flush();
+		}
+#endif
 		exit(-1);
 	}
 }
 
+/// Accounts for the memory of the simulator, the visualizer data and the log queue.
+void StrideSimulatorResult::AccountMemory(const Simulator& sim, bool report)
+{
+	MemoryAccount account;
+	sim.AccountMemory(account);
+	account.Add("visualizer data", visualizer_data.GetMemoryUsage());
+	account.Add("log queue", GetLogQueueMemory());
+	MemoryAccount growing;
+	AccountGrowingMemory(sim, growing);
+	fixed_memory = account.GetTotal();
+	fixed_memory.used -= growing.GetTotal().used;
+	fixed_memory.allocated -= growing.GetTotal().allocated;
+	if (report) {
+		lock_guard<mutex> lock(io_mutex);
+		account.Print(cout, "Memory of simulation " + to_string(id) + " on day " + to_string(day) + ":");
+	}
+	// The simulation manager passes the failure on to the thread that waits for the simulations.
+	account.CheckBudget(
+	    sim.GetConfiguration().common_config->memory_budget,
+	    "of simulation " + to_string(id) + " on day " + to_string(day));
+}
+
+/// Fails if the memory exceeds the memory budget, counting the subsystems that don't grow as they were accounted last.
+void StrideSimulatorResult::CheckMemoryBudget(const Simulator& sim) const
+{
+	MemoryAccount account;
+	account.Add("other subsystems", fixed_memory);
+	AccountGrowingMemory(sim, account);
+	account.CheckBudget(
+	    sim.GetConfiguration().common_config->memory_budget,
+	    "of simulation " + to_string(id) + " on day " + to_string(day));
+}
+
+/// Adds the memory of the journals, the commuters and the visualizer data to the account.
+void StrideSimulatorResult::AccountGrowingMemory(const Simulator& sim, MemoryAccount& account) const
+{
+	sim.AccountGrowingMemory(account);
+	account.Add("visualizer data", visualizer_data.GetMemoryUsage());
+}
+
 /// Prints and returns the number of threads.
 unsigned int print_number_of_threads()
 {
@@ -177,7 +294,7 @@ void run_stride(const MultiSimulationConfig& config)
 	cout << "Setting for track_index_case:  " << boolalpha << config.common_config->track_index_case << endl;
 
 	// Set the log queue size.
-	spdlog::set_async_mode(1048576);
+	spdlog::set_async_mode(log_queue_size);
 
 	// -----------------------------------------------------------------------------------------
 	// Create simulator.
@@ -197,6 +314,7 @@ void run_stride(const MultiSimulationConfig& config)
 		std::shared_ptr<multiregion::SimulationTask<StrideSimulatorResult>> sim_task;
 	};
 	std::vector<SimulationTuple> tasks;
+	TraceSpan build_span("BuildSimulators", "run");
 	for (const auto& single_config : config.GetSingleConfigs()) {
 		multiregion::RegionId region_id = single_config.GetId();
 		cout << "Building simulator #" << region_id << endl;
@@ -208,6 +326,13 @@ void run_stride(const MultiSimulationConfig& config)
 		// General contacts:  [CNT] <person1ID> <person1AGE> <person2AGE>  <at_home> <at_work> <at_school>
 		// <at_other>
 		// -----------------------------------------------------------------------------------------
+		// The log allocates its queue when it's created, so it fails before that if it doesn't fit.
+		MemoryAccount log_account;
+		log_account.Add("log queue", GetLogQueueMemory());
+		log_account.CheckBudget(
+		    single_config.common_config->memory_budget,
+		    "of the log queue of simulation " + to_string(region_id));
+
 		auto log_name = std::string("contact_logger_") + sim_output_prefix;
 		auto file_logger = spdlog::rotating_logger_mt(
 		    log_name, sim_output_prefix + "_logfile", std::numeric_limits<size_t>::max(),
@@ -217,16 +342,27 @@ void run_stride(const MultiSimulationConfig& config)
 		tasks.push_back({log_name, sim_output_prefix, single_config,
 				 sim_manager.CreateSimulation(single_config, file_logger, region_id)});
 	}
+	build_span.End();
 	cout << "Done building simulators. " << endl << endl;
 
 	// -----------------------------------------------------------------------------------------
 	// Run the simulation.
 	// -----------------------------------------------------------------------------------------
 	Stopwatch<> sim_clock("sim_clock", true);
+	TraceSpan run_span("RunSimulators", "run");
 	sim_manager.WaitAll();
+	run_span.End();
 	sim_clock.Stop();
 
+#if USE_HDF5
+	// Make sure every checkpoint is on disk.
+	if (cp_writer) {
+		cp_writer->Flush();
+	}
+#endif
+
 	// Generate output files for the simulations.
+	TraceSpan output_span("WriteOutput", "output");
 	for (const auto& sim_tuple : tasks) {
 		// -----------------------------------------------------------------------------------------
 		// Generate output files
@@ -247,8 +383,9 @@ void run_stride(const MultiSimulationConfig& config)
 
 		// Persons
 		if (sim_tuple.sim_config.log_config->generate_person_file) {
-			PersonFile person_file(sim_tuple.sim_output_prefix);
-			person_file.Print(pop);
+			PersonFile person_file(
+			    sim_tuple.sim_output_prefix, sim_tuple.sim_config.log_config->binary_person_file);
+			person_file.Print(pop, num_threads);
 		}
 
 		cout << endl << endl;
@@ -307,7 +444,12 @@ void run_stride(
 	}
 #if USE_HDF5
 	if (config.common_config->use_checkpoint) {
-		cp = std::make_unique<CheckPoint>(realFile);
+		if (config.common_config->commuting_model) {
+			FATAL_ERROR("Checkpoints of simulations with a commuting model are not supported");
+		}
+		cp = std::make_shared<CheckPoint>(
+		    realFile, config.common_config->checkpoint_chunk_size, config.common_config->checkpoint_compression,
+		    config.common_config->checkpoint_layout);
 
 		cp->CreateFile();
 		cp->OpenFile();
@@ -315,6 +457,7 @@ void run_stride(
 		cp->WriteHolidays(
 		    pt_config.get_child("run").get<std::string>("holidays_file", "holidays_flanders_2016.json"));
 		cp->CloseFile();
+		cp_writer = std::make_unique<CheckPointWriter>(cp);
 	}
 #endif
 
@@ -347,7 +490,7 @@ void run_stride_noConfig(
 		}
 		actualFile = besTime.filename().string();
 	}
-	cp = std::make_unique<CheckPoint>(actualFile);
+	cp = std::make_shared<CheckPoint>(actualFile);
 
 	if (datestr.empty()) {
 		cp->OpenFile();
@@ -374,6 +517,7 @@ void run_stride_noConfig(
 	config.common_config->generate_vis_file = gen_vis;
 	config.common_config->checkpoint_interval = interval;
 
+	cp_writer = std::make_unique<CheckPointWriter>(cp);
 	run_stride(config);
 
 #else
@@ -2,15 +2,19 @@
 #define RUN_STRIDE_H_INCLUDED
 
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
 #include "core/Cluster.h"
 #include "multiregion/TravelModel.h"
 #include "output/VisualizerData.h"
+#include "output/TimeSeriesFile.h"
+#include "output/VisualizerFile.h"
 #include "pop/Population.h"
 #include "sim/SimulationConfig.h"
 #include "sim/Simulator.h"
+#include "util/MemoryAccount.h"
 #include "util/Stopwatch.h"
 
 namespace stride {
@@ -29,6 +33,8 @@ public:
 	const multiregion::RegionId id;
 	std::vector<unsigned int> cases;
 	VisualizerData visualizer_data;
+	std::shared_ptr<output::VisualizerFile> visualizer_file;
+	std::shared_ptr<output::TimeSeriesFile> timeseries_file;
 	bool generate_vis_data;
 
 	/// Gets the total run-time for this simulator result.
@@ -44,8 +50,21 @@ public:
 	void AfterSimulatorStep(const Simulator& simulator);
 
 private:
+	/// Accounts for the memory of the simulator, the visualizer data and the log queue: prints it if
+	/// `report` is set, and fails if it exceeds the memory budget.
+	void AccountMemory(const Simulator& sim, bool report);
+
+	/// Fails if the memory exceeds the memory budget, counting the subsystems that don't grow as they were
+	/// accounted last.
+	void CheckMemoryBudget(const Simulator& sim) const;
+
+	/// Adds the memory of the subsystems that grow while the simulation runs to the account.
+	void AccountGrowingMemory(const Simulator& sim, util::MemoryAccount& account) const;
+
 	util::Stopwatch<> run_clock;
 	int day;
+	/// The memory of the subsystems that don't grow while the simulation runs, as they were accounted last.
+	util::MemoryUsage fixed_memory;
 	static std::mutex io_mutex;
 };
 
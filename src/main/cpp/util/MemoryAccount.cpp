@@ -0,0 +1,85 @@
+#include "MemoryAccount.h"
+
+#include "util/Errors.h"
+#include "util/ResourceUsage.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace stride {
+namespace util {
+
+using namespace std;
+
+namespace {
+
+/// Converts bytes to MiB.
+double ToMebibytes(std::size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+} // end_of_namespace
+
+void MemoryAccount::Add(const std::string& subsystem, const MemoryUsage& usage)
+{
+	for (auto& entry : m_subsystems) {
+		if (entry.first == subsystem) {
+			entry.second += usage;
+			return;
+		}
+	}
+	m_subsystems.emplace_back(subsystem, usage);
+}
+
+void MemoryAccount::Add(const MemoryAccount& other)
+{
+	for (const auto& entry : other.m_subsystems) {
+		Add(entry.first, entry.second);
+	}
+}
+
+MemoryUsage MemoryAccount::GetTotal() const
+{
+	MemoryUsage total;
+	for (const auto& entry : m_subsystems) {
+		total += entry.second;
+	}
+	return total;
+}
+
+void MemoryAccount::Print(std::ostream& out, const std::string& title) const
+{
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+	out << title << endl;
+	out << left << setw(32) << "subsystem" << right << setw(14) << "used MiB" << setw(16) << "allocated MiB"
+	    << endl;
+	out << fixed << setprecision(1);
+	for (const auto& entry : m_subsystems) {
+		out << left << setw(32) << entry.first << right << setw(14) << ToMebibytes(entry.second.used)
+		    << setw(16) << ToMebibytes(entry.second.allocated) << endl;
+	}
+	const auto total = GetTotal();
+	out << left << setw(32) << "total" << right << setw(14) << ToMebibytes(total.used) << setw(16)
+	    << ToMebibytes(total.allocated) << endl;
+	const auto rss = GetResidentSetSize();
+	if (rss > 0U) {
+		out << left << setw(32) << "process resident set" << right << setw(30) << ToMebibytes(rss) << endl;
+	}
+	out.flags(flags);
+	out.precision(precision);
+}
+
+void MemoryAccount::CheckBudget(unsigned int budget, const std::string& when) const
+{
+	const auto allocated = GetTotal().allocated;
+	if (budget == 0U || ToMebibytes(allocated) <= budget) {
+		return;
+	}
+	ostringstream message;
+	message << fixed << setprecision(1) << ToMebibytes(allocated) << " MiB " << when
+		<< " exceeds the memory budget of " << budget << " MiB." << endl;
+	Print(message, "Memory per subsystem:");
+	FATAL_ERROR(message.str());
+}
+
+} // end_of_namespace
+} // end_of_namespace
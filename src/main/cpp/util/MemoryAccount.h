@@ -0,0 +1,112 @@
+#ifndef UTIL_MEMORY_ACCOUNT_H_INCLUDED
+#define UTIL_MEMORY_ACCOUNT_H_INCLUDED
+
+/**
+ * @file
+ * Accounting of the memory that the subsystems of a simulator hold.
+ */
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace stride {
+namespace util {
+
+/**
+ * The bytes that a container holds: those of its elements, and those that are allocated for it, which include
+ * unused capacity and the bookkeeping of its nodes. Sizes of node-based containers are estimates, because the
+ * layout of their nodes and the overhead of the allocator aren't known.
+ */
+struct MemoryUsage
+{
+	std::size_t used = 0;
+	std::size_t allocated = 0;
+
+	MemoryUsage& operator+=(const MemoryUsage& other)
+	{
+		used += other.used;
+		allocated += other.allocated;
+		return *this;
+	}
+};
+
+/// The memory that a string allocates for its characters; short strings are stored in the string itself.
+inline std::size_t GetHeapBytes(const std::string& value)
+{
+	return value.capacity() > std::string().capacity() ? value.capacity() + 1 : 0U;
+}
+
+/// The memory of the elements of a vector, not of what they point to.
+template <typename T>
+MemoryUsage GetMemoryUsage(const std::vector<T>& values)
+{
+	return {values.size() * sizeof(T), values.capacity() * sizeof(T)};
+}
+
+/// The memory of the nodes of an ordered map: every node holds a key/value pair and three links and a color.
+template <typename K, typename V, typename... TArgs>
+MemoryUsage GetMemoryUsage(const std::map<K, V, TArgs...>& values)
+{
+	using Value = typename std::map<K, V, TArgs...>::value_type;
+	return {values.size() * sizeof(Value), values.size() * (sizeof(Value) + 4 * sizeof(void*))};
+}
+
+/// The memory of the nodes and buckets of a hash map: every node holds a key/value pair and a link.
+template <typename K, typename V, typename... TArgs>
+MemoryUsage GetMemoryUsage(const std::unordered_map<K, V, TArgs...>& values)
+{
+	using Value = typename std::unordered_map<K, V, TArgs...>::value_type;
+	return {values.size() * sizeof(Value),
+		values.size() * (sizeof(Value) + sizeof(void*)) + values.bucket_count() * sizeof(void*)};
+}
+
+/// The memory of the nodes and buckets of a hash set: every node holds a key and a link.
+template <typename K, typename... TArgs>
+MemoryUsage GetMemoryUsage(const std::unordered_set<K, TArgs...>& values)
+{
+	return {values.size() * sizeof(K),
+		values.size() * (sizeof(K) + sizeof(void*)) + values.bucket_count() * sizeof(void*)};
+}
+
+/**
+ * The memory of the subsystems of a simulator, in bytes. It's accounted by the data structures themselves, so
+ * it doesn't include the memory of the libraries and the allocator, which the resident set size of the process
+ * does.
+ */
+class MemoryAccount
+{
+public:
+	/// Adds memory to a subsystem. Subsystems are reported in the order in which they were first added.
+	void Add(const std::string& subsystem, const MemoryUsage& usage);
+
+	/// Adds the memory of every subsystem of another account.
+	void Add(const MemoryAccount& other);
+
+	/// The subsystems and their memory.
+	const std::vector<std::pair<std::string, MemoryUsage>>& GetSubsystems() const { return m_subsystems; }
+
+	/// The memory of all subsystems together.
+	MemoryUsage GetTotal() const;
+
+	/// Prints a table of the subsystems in MiB, with the total and the resident set size of the process.
+	void Print(std::ostream& out, const std::string& title) const;
+
+	/// Fails if the allocated memory of all subsystems together exceeds the given budget in MiB. The message
+	/// tells when the budget was checked and holds the table of the subsystems. A budget of 0 is never
+	/// exceeded.
+	void CheckBudget(unsigned int budget, const std::string& when) const;
+
+private:
+	std::vector<std::pair<std::string, MemoryUsage>> m_subsystems;
+};
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end-of-include-guard
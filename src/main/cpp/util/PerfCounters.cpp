@@ -0,0 +1,273 @@
+#include "PerfCounters.h"
+
+#include "util/Errors.h"
+#include "util/Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace stride {
+namespace util {
+
+using namespace std;
+
+constexpr std::size_t PerfCounters::NumOfEvents;
+
+namespace {
+
+#ifdef __linux__
+
+/// The type and config of the events, in the order of their names.
+const pair<uint32_t, uint64_t> g_events[PerfCounters::NumOfEvents] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}};
+
+/// Opens a counter of an event for a thread of this process, which the threads that it starts inherit if
+/// `inherit` is set. Returns -1 if the event can't be counted.
+int OpenCounter(std::size_t event, int thread, bool inherit)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = g_events[event].first;
+	attr.config = g_events[event].second;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	// Unprivileged users may only count their own user space events.
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.inherit = inherit ? 1 : 0;
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, thread, -1, -1, 0));
+}
+
+/// Reads a counter, scaled up for the time it didn't run when there are more events than counters.
+double ReadCounter(int fd)
+{
+	uint64_t values[3];
+	if (read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+		return 0.0;
+	}
+	return static_cast<double>(values[0]) * values[1] / values[2];
+}
+
+/// The ids of the threads of this process.
+vector<int> GetThreadIds()
+{
+	vector<int> ids;
+	if (DIR* dir = opendir("/proc/self/task")) {
+		while (dirent* entry = readdir(dir)) {
+			if (entry->d_name[0] != '.') {
+				ids.push_back(atoi(entry->d_name));
+			}
+		}
+		closedir(dir);
+	}
+	return ids;
+}
+
+#endif
+
+} // end_of_namespace
+
+PerfCounters::PerfCounters(const std::string& file, unsigned int num_threads)
+    : m_num_threads(std::max(num_threads, 1U)), m_available{}, m_start_events{}
+{
+	if (!file.empty()) {
+		m_fstream.open(file);
+		if (!m_fstream) {
+			FATAL_ERROR("Can't open " + file + ".");
+		}
+	}
+#ifdef __linux__
+	// The events that can be counted for this thread can be counted for the others. The counters of the
+	// threads are opened when the first phase starts.
+	m_available.fill(true);
+	const auto probe = Open(static_cast<int>(syscall(SYS_gettid)), false);
+	for (size_t event = 0; event < NumOfEvents; event++) {
+		m_available[event] = probe.fds[event] >= 0;
+	}
+	Close(probe);
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+	if (m_fstream.is_open()) {
+		Print(m_fstream);
+	}
+	for (const auto& counters : m_threads) {
+		Close(counters);
+	}
+}
+
+const std::array<std::string, PerfCounters::NumOfEvents>& PerfCounters::GetEventNames()
+{
+	static const array<string, NumOfEvents> names{
+	    {"cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"}};
+	return names;
+}
+
+void PerfCounters::StartPhase()
+{
+	if (IsAnyAvailable()) {
+		OpenThreads();
+		m_start_events = Read();
+	}
+	m_start_time = chrono::steady_clock::now();
+}
+
+void PerfCounters::StopPhase(const std::string& phase)
+{
+	const auto end_time = chrono::steady_clock::now();
+	auto events = m_start_events;
+	if (IsAnyAvailable()) {
+		events = Read();
+	}
+
+	auto totals =
+	    find_if(m_totals.begin(), m_totals.end(), [&phase](const Totals& t) { return t.phase == phase; });
+	if (totals == m_totals.end()) {
+		m_totals.emplace_back();
+		m_totals.back().phase = phase;
+		totals = m_totals.end() - 1;
+	}
+	totals->runs++;
+	totals->seconds += chrono::duration<double>(end_time - m_start_time).count();
+	for (size_t event = 0; event < NumOfEvents; event++) {
+		// Scaled counts of multiplexed counters aren't exactly monotonic.
+		totals->events[event] += max(0.0, events[event] - m_start_events[event]);
+	}
+}
+
+void PerfCounters::Print(std::ostream& out) const
+{
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+	out << "phase,runs,seconds";
+	for (const auto& name : GetEventNames()) {
+		out << ',' << name;
+	}
+	out << '\n' << fixed;
+	for (const auto& totals : m_totals) {
+		out << totals.phase << ',' << totals.runs << ',' << setprecision(6) << totals.seconds
+		    << setprecision(0);
+		for (size_t event = 0; event < NumOfEvents; event++) {
+			if (m_available[event]) {
+				out << ',' << round(totals.events[event]);
+			} else {
+				out << ",NA";
+			}
+		}
+		out << '\n';
+	}
+	out.flags(flags);
+	out.precision(precision);
+}
+
+PerfCounters::ThreadCounters PerfCounters::Open(int thread, bool inherit) const
+{
+	ThreadCounters result{thread, inherit, {}};
+	result.fds.fill(-1);
+#ifdef __linux__
+	for (size_t event = 0; event < NumOfEvents; event++) {
+		if (m_available[event]) {
+			result.fds[event] = OpenCounter(event, thread, inherit);
+		}
+	}
+#endif
+	return result;
+}
+
+void PerfCounters::Close(const ThreadCounters& counters)
+{
+#ifdef __linux__
+	for (int fd : counters.fds) {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+#endif
+}
+
+void PerfCounters::OpenThreads()
+{
+#ifdef __linux__
+	// Threads that exited are no longer counted.
+	const auto running = GetThreadIds();
+	const auto exited = partition(m_threads.begin(), m_threads.end(), [&running](const ThreadCounters& counters) {
+		return find(running.begin(), running.end(), counters.thread) != running.end();
+	});
+	for_each(exited, m_threads.end(), Close);
+	m_threads.erase(exited, m_threads.end());
+
+	const int caller = static_cast<int>(syscall(SYS_gettid));
+	const auto known = find_if(m_threads.begin(), m_threads.end(), [caller](const ThreadCounters& counters) {
+		return counters.thread == caller && counters.inherit;
+	});
+	if (known != m_threads.end()) {
+		return;
+	}
+
+	// The phase runs on another thread than the previous one, whose counters, and those of its workers, would
+	// count the phases of others. Replacing the counters between phases loses nothing, since a phase only counts
+	// the difference.
+	for_each(m_threads.begin(), m_threads.end(), Close);
+	m_threads.clear();
+
+	// Start the workers of the pool first: a worker that inherits the counters of this thread would be counted
+	// again by its own counters when it exits. Every worker holds on to its item for a while, so that the others
+	// take theirs and all of them are found.
+	vector<int> workers(m_num_threads, caller);
+	atomic<unsigned int> arrived{0U};
+	const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(10);
+	parallel::parallel_for(workers, m_num_threads, [this, &arrived, &deadline](int& worker, unsigned int) {
+		worker = static_cast<int>(syscall(SYS_gettid));
+		arrived++;
+		while (arrived < m_num_threads && chrono::steady_clock::now() < deadline) {
+			this_thread::yield();
+		}
+	});
+	sort(workers.begin(), workers.end());
+	workers.erase(unique(workers.begin(), workers.end()), workers.end());
+
+	m_threads.push_back(Open(caller, true));
+	for (int worker : workers) {
+		if (worker != caller) {
+			m_threads.push_back(Open(worker, false));
+		}
+	}
+#endif
+}
+
+std::array<double, PerfCounters::NumOfEvents> PerfCounters::Read() const
+{
+	array<double, NumOfEvents> events{};
+#ifdef __linux__
+	for (const auto& counters : m_threads) {
+		for (size_t event = 0; event < NumOfEvents; event++) {
+			if (counters.fds[event] >= 0) {
+				events[event] += ReadCounter(counters.fds[event]);
+			}
+		}
+	}
+#endif
+	return events;
+}
+
+} // end_of_namespace
+} // end_of_namespace
@@ -0,0 +1,152 @@
+#ifndef UTIL_PERF_COUNTERS_H_INCLUDED
+#define UTIL_PERF_COUNTERS_H_INCLUDED
+
+/**
+ * @file
+ * Hardware performance counters per phase of the simulation.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace stride {
+namespace util {
+
+/**
+ * Counts hardware events per phase of the simulation with Linux' perf_event_open: cycles, instructions, last
+ * level cache misses, branch misses and data TLB misses. A phase counts the events of the thread that runs it,
+ * of the threads that this thread starts during the phase, and of the workers of its pool. The threads that are
+ * started during a phase inherit the counters of the thread that starts them. Their counts are added when they
+ * exit, which the threads of parallel_for do before the phase ends. The workers of the parallelization library's
+ * pool are started before the counters of a thread are opened, and get counters of their own. The other threads
+ * of the process, such as those of regions that run at the same time, aren't counted. Events that the CPU, the
+ * kernel or the container doesn't offer aren't counted, and without any counters only the time of the phases is
+ * measured.
+ *
+ * The totals are written to a CSV file on destruction, with a line per phase: the phase, the number of times
+ * it ran, its time in seconds and the count of every event, or "NA" for the events that weren't counted.
+ */
+class PerfCounters
+{
+public:
+	/// The number of events.
+	static constexpr std::size_t NumOfEvents = 5;
+
+	/// The totals of a phase.
+	struct Totals
+	{
+		std::string phase;
+		std::size_t runs = 0;
+		double seconds = 0.0;
+		std::array<double, NumOfEvents> events{};
+	};
+
+	/// Measures a phase from its construction to its destruction; does nothing without counters.
+	class Scope
+	{
+	public:
+		/// Starts the phase. The name is a string literal.
+		Scope(PerfCounters* counters, const char* phase) : m_counters(counters), m_phase(phase)
+		{
+			if (m_counters) {
+				m_counters->StartPhase();
+			}
+		}
+
+		/// Stops the phase.
+		~Scope()
+		{
+			if (m_counters) {
+				m_counters->StopPhase(m_phase);
+			}
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		PerfCounters* m_counters;
+		const char* m_phase;
+	};
+
+	/// Opens the file to which the totals are written, unless its name is empty. The phases run parallel loops
+	/// on up to `num_threads` threads.
+	explicit PerfCounters(const std::string& file = "", unsigned int num_threads = 1U);
+
+	/// Writes the totals and closes the counters.
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	/// The names of the events, as in the header of the file.
+	static const std::array<std::string, NumOfEvents>& GetEventNames();
+
+	/// Whether an event is counted.
+	bool IsAvailable(std::size_t event) const { return m_available[event]; }
+
+	/// Whether any event is counted.
+	bool IsAnyAvailable() const
+	{
+		for (bool available : m_available) {
+			if (available) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// Starts a phase. Phases don't nest.
+	void StartPhase();
+
+	/// Stops the phase that was started last, and adds it to the totals of the given phase.
+	void StopPhase(const std::string& phase);
+
+	/// The totals of the phases, in the order in which they first ran.
+	const std::vector<Totals>& GetTotals() const { return m_totals; }
+
+	/// Writes the totals in CSV format.
+	void Print(std::ostream& out) const;
+
+private:
+	/// Closes the counters of the threads that exited. Unless the calling thread has counters that its new
+	/// threads inherit, replaces all counters by those and by the counters of the workers of its pool.
+	void OpenThreads();
+
+	/// The counts of the threads since their counters were opened.
+	std::array<double, NumOfEvents> Read() const;
+
+private:
+	/// The counters of a thread; -1 for the events that aren't counted.
+	struct ThreadCounters
+	{
+		int thread;
+		bool inherit;
+		std::array<int, NumOfEvents> fds;
+	};
+
+	/// Opens the counters of a thread.
+	ThreadCounters Open(int thread, bool inherit) const;
+
+	/// Closes the counters of a thread.
+	static void Close(const ThreadCounters& counters);
+
+	std::ofstream m_fstream;
+	unsigned int m_num_threads;
+	std::array<bool, NumOfEvents> m_available;
+	std::vector<ThreadCounters> m_threads;
+	std::vector<Totals> m_totals;
+	std::array<double, NumOfEvents> m_start_events;
+	std::chrono::steady_clock::time_point m_start_time;
+};
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end-of-include-guard
@@ -0,0 +1,75 @@
+#include "ResourceUsage.h"
+
+#include <fstream>
+#include <limits>
+#include <string>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace stride {
+namespace util {
+
+using namespace std;
+
+#ifdef __linux__
+namespace {
+
+/// Reads a size in kB from /proc/self/status, in bytes, or 0 if it isn't there.
+size_t ReadStatusSize(const string& name)
+{
+	ifstream status("/proc/self/status");
+	string key;
+	while (status >> key) {
+		if (key == name) {
+			size_t kilobytes = 0;
+			status >> kilobytes;
+			return kilobytes * 1024U;
+		}
+		status.ignore(numeric_limits<streamsize>::max(), '\n');
+	}
+	return 0U;
+}
+
+} // end_of_namespace
+#endif
+
+std::size_t GetResidentSetSize()
+{
+#ifdef __linux__
+	return ReadStatusSize("VmRSS:");
+#else
+	return 0U;
+#endif
+}
+
+std::size_t GetPeakResidentSetSize()
+{
+#ifdef __linux__
+	// The high water mark can be reset, unlike the maximum of getrusage.
+	const auto peak = ReadStatusSize("VmHWM:");
+	if (peak > 0U) {
+		return peak;
+	}
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		return static_cast<size_t>(usage.ru_maxrss) * 1024U;
+	}
+#endif
+	return 0U;
+}
+
+bool ResetPeakResidentSetSize()
+{
+#ifdef __linux__
+	ofstream clear_refs("/proc/self/clear_refs");
+	clear_refs << "5" << flush;
+	return static_cast<bool>(clear_refs);
+#else
+	return false;
+#endif
+}
+
+} // end_of_namespace
+} // end_of_namespace
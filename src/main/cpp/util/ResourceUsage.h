@@ -0,0 +1,27 @@
+#ifndef UTIL_RESOURCE_USAGE_H_INCLUDED
+#define UTIL_RESOURCE_USAGE_H_INCLUDED
+
+/**
+ * @file
+ * The memory use of the process, as the operating system sees it.
+ */
+
+#include <cstddef>
+
+namespace stride {
+namespace util {
+
+/// The resident set size of the process in bytes, or 0 if it's unknown.
+std::size_t GetResidentSetSize();
+
+/// The peak resident set size of the process in bytes, or 0 if it's unknown.
+std::size_t GetPeakResidentSetSize();
+
+/// Resets the peak resident set size to the current one, so that GetPeakResidentSetSize measures from now on.
+/// Returns false if the system doesn't allow it; the peak is then the peak since the start of the process.
+bool ResetPeakResidentSetSize();
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end-of-include-guard
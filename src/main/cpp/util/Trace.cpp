@@ -0,0 +1,175 @@
+#include "Trace.h"
+
+#include "util/Errors.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <utility>
+
+namespace stride {
+namespace util {
+
+using namespace std;
+
+namespace {
+
+/// A span that was recorded.
+struct TraceEvent
+{
+	const char* name;
+	const char* category;
+	int region;
+	unsigned int thread;
+	Tracer::Clock::time_point start;
+	Tracer::Clock::duration duration;
+};
+
+struct ThreadEvents;
+
+/// The state of the tracer.
+struct TraceState
+{
+	mutex lock;
+	ofstream file;
+	Tracer::Clock::time_point origin;
+	unsigned int num_threads = 0;	 ///< The number of threads that recorded spans so far.
+	set<ThreadEvents*> threads;	 ///< The spans of the threads that are running.
+	vector<TraceEvent> finished;	 ///< The spans of the threads that have exited.
+};
+
+TraceState& GetState()
+{
+	static TraceState state;
+	return state;
+}
+
+/// The spans recorded by one thread. They are registered with the tracer while the thread runs, and are moved
+/// to its finished spans when the thread exits.
+struct ThreadEvents
+{
+	ThreadEvents()
+	{
+		auto& state = GetState();
+		lock_guard<mutex> lock(state.lock);
+		thread = state.num_threads++;
+		state.threads.insert(this);
+	}
+
+	~ThreadEvents()
+	{
+		auto& state = GetState();
+		lock_guard<mutex> lock(state.lock);
+		state.finished.insert(state.finished.end(), events.begin(), events.end());
+		state.threads.erase(this);
+	}
+
+	unsigned int thread;
+	vector<TraceEvent> events;
+};
+
+/// The spans of the calling thread.
+ThreadEvents& GetThreadEvents()
+{
+	thread_local ThreadEvents events;
+	return events;
+}
+
+/// Microseconds, the unit of the trace.
+double ToMicroseconds(Tracer::Clock::duration duration)
+{
+	return chrono::duration_cast<chrono::nanoseconds>(duration).count() / 1000.0;
+}
+
+} // end_of_namespace
+
+std::atomic<bool> Tracer::g_enabled(false);
+
+constexpr int Tracer::NoRegion;
+
+void Tracer::Start(const std::string& file_name)
+{
+	auto& state = GetState();
+	lock_guard<mutex> lock(state.lock);
+	state.file.open(file_name);
+	if (!state.file) {
+		FATAL_ERROR("Can't open trace file " + file_name + ".");
+	}
+	for (auto& thread : state.threads) {
+		thread->events.clear();
+	}
+	state.finished.clear();
+	state.origin = Clock::now();
+	g_enabled.store(true);
+}
+
+void Tracer::Stop()
+{
+	if (!g_enabled.exchange(false)) {
+		return;
+	}
+	auto& state = GetState();
+	lock_guard<mutex> lock(state.lock);
+
+	// Gather the spans of the threads that are still running with those of the threads that have exited.
+	auto& events = state.finished;
+	for (const auto& thread : state.threads) {
+		events.insert(events.end(), thread->events.begin(), thread->events.end());
+		thread->events.clear();
+	}
+
+	// Every region is a process, offset by one so that the spans without a region are process 0.
+	set<int> regions{NoRegion};
+	set<pair<int, unsigned int>> threads;
+	for (const auto& event : events) {
+		regions.insert(event.region);
+		threads.emplace(event.region, event.thread);
+	}
+
+	auto& out = state.file;
+	out << fixed << setprecision(3) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	const auto separate = [&out, &first]() {
+		out << (first ? "" : ",\n");
+		first = false;
+	};
+	for (int region : regions) {
+		separate();
+		out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << region + 1 << ",\"args\":{\"name\":\"";
+		if (region == NoRegion) {
+			out << "stride";
+		} else {
+			out << "region " << region;
+		}
+		out << "\"}}";
+	}
+	for (const auto& thread : threads) {
+		separate();
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << thread.first + 1 << ",\"tid\":" << thread.second
+		    << ",\"args\":{\"name\":\"thread " << thread.second << "\"}}";
+	}
+	for (const auto& event : events) {
+		separate();
+		out << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+		    << "\",\"ph\":\"X\",\"ts\":" << ToMicroseconds(event.start - state.origin)
+		    << ",\"dur\":" << ToMicroseconds(event.duration) << ",\"pid\":" << event.region + 1
+		    << ",\"tid\":" << event.thread << "}";
+	}
+	events.clear();
+	out << "\n]}\n";
+	out.close();
+}
+
+unsigned int Tracer::GetThreadIndex() { return GetThreadEvents().thread; }
+
+void Tracer::AddSpan(
+    const char* name, const char* category, int region, Clock::time_point start, Clock::time_point end,
+    unsigned int thread)
+{
+	GetThreadEvents().events.push_back({name, category, region, thread, start, end - start});
+}
+
+} // end_of_namespace
+} // end_of_namespace
@@ -0,0 +1,164 @@
+#ifndef UTIL_TRACE_H_INCLUDED
+#define UTIL_TRACE_H_INCLUDED
+
+/**
+ * @file
+ * Spans of the phases of a run, written in Chrome's JSON trace format.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "util/Parallel.h"
+
+namespace stride {
+namespace util {
+
+/**
+ * Records spans of the phases of a run, per thread and per region, and writes them to a file in Chrome's JSON
+ * trace format, which chrome://tracing and Perfetto open. Every region is a process of the trace, and spans
+ * that don't belong to a region are in the "stride" process. Tracing is off until Start is called; while it's
+ * off, a span costs a relaxed load and a branch.
+ */
+class Tracer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/// The region of the spans that don't belong to a region.
+	static constexpr int NoRegion = -1;
+
+	/// Starts tracing. The trace is written to the given file on Stop.
+	static void Start(const std::string& file_name);
+
+	/// Stops tracing and writes the spans to the file. Spans should no longer be recorded.
+	static void Stop();
+
+	/// Whether spans are being recorded.
+	static bool IsEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+	/// The number of the calling thread in the trace.
+	static unsigned int GetThreadIndex();
+
+	/// Records a span of the calling thread. The name and category are string literals.
+	static void AddSpan(
+	    const char* name, const char* category, int region, Clock::time_point start, Clock::time_point end)
+	{
+		AddSpan(name, category, region, start, end, GetThreadIndex());
+	}
+
+	/// Records a span of the given thread. The name and category are string literals.
+	static void AddSpan(
+	    const char* name, const char* category, int region, Clock::time_point start, Clock::time_point end,
+	    unsigned int thread);
+
+	/// Runs parallel::parallel_for, and records a span of the whole loop on the calling thread, and a span per
+	/// thread from the start of its first element to the end of its last element.
+	template <typename T, typename TAction>
+	static void ParallelFor(
+	    const char* name, int region, std::vector<T>& values, unsigned int num_threads, const TAction& action);
+
+private:
+	static std::atomic<bool> g_enabled;
+};
+
+/**
+ * Traces from its construction to its destruction, so that the trace is written even if the run fails. An empty
+ * file name leaves tracing off.
+ */
+class TraceSession
+{
+public:
+	/// Starts tracing to the given file, unless its name is empty.
+	explicit TraceSession(const std::string& file_name)
+	{
+		if (!file_name.empty()) {
+			Tracer::Start(file_name);
+		}
+	}
+
+	/// Stops tracing and writes the trace, if tracing was started.
+	~TraceSession() { Tracer::Stop(); }
+
+	TraceSession(const TraceSession&) = delete;
+	TraceSession& operator=(const TraceSession&) = delete;
+};
+
+/**
+ * Records a span from its construction to its destruction, if tracing is enabled.
+ */
+class TraceSpan
+{
+public:
+	/// Starts the span. The name and category are string literals.
+	TraceSpan(const char* name, const char* category, int region = Tracer::NoRegion)
+	    : m_name(name), m_category(category), m_region(region), m_enabled(Tracer::IsEnabled())
+	{
+		if (m_enabled) {
+			m_start = Tracer::Clock::now();
+		}
+	}
+
+	/// Ends the span, if it hasn't ended yet.
+	~TraceSpan() { End(); }
+
+	/// Ends the span before the end of its scope.
+	void End()
+	{
+		if (m_enabled) {
+			Tracer::AddSpan(m_name, m_category, m_region, m_start, Tracer::Clock::now());
+			m_enabled = false;
+		}
+	}
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+	const char* m_name;
+	const char* m_category;
+	int m_region;
+	bool m_enabled;
+	Tracer::Clock::time_point m_start;
+};
+
+template <typename T, typename TAction>
+void Tracer::ParallelFor(
+    const char* name, int region, std::vector<T>& values, unsigned int num_threads, const TAction& action)
+{
+	if (!IsEnabled()) {
+		parallel::parallel_for(values, num_threads, action);
+		return;
+	}
+
+	struct alignas(64) ThreadSpan
+	{
+		bool started = false;
+		unsigned int thread = 0;
+		Clock::time_point start;
+		Clock::time_point end;
+	};
+	TraceSpan span(name, "parallel_for", region);
+	std::vector<ThreadSpan> thread_spans(num_threads);
+	parallel::parallel_for(values, num_threads, [&thread_spans, &action](T& value, unsigned int thread_id) {
+		auto& thread_span = thread_spans[thread_id];
+		if (!thread_span.started) {
+			thread_span.started = true;
+			thread_span.thread = GetThreadIndex();
+			thread_span.start = Clock::now();
+		}
+		action(value, thread_id);
+		thread_span.end = Clock::now();
+	});
+	for (const auto& thread_span : thread_spans) {
+		if (thread_span.started) {
+			AddSpan(name, "thread", region, thread_span.start, thread_span.end, thread_span.thread);
+		}
+	}
+}
+
+} // end_of_namespace
+} // end_of_namespace
+
+#endif // end-of-include-guard
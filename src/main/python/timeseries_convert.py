@@ -0,0 +1,90 @@
+#!/usr/bin/python
+
+"""
+Convert a binary time series file produced by the simulator to the cases
+and visualization files.
+
+"""
+
+import json
+import struct
+import sys
+
+
+def read_timeseries(timeseries_file_path):
+    """
+    Read the header and the records of a <prefix>_timeseries.bin file, as
+    written by TimeSeriesFile. Returns the list of towns and the list of
+    records, each record being a dictionary.
+    """
+    with open(timeseries_file_path, 'rb') as f:
+        if f.read(8) != b'STRIDETS':
+            raise ValueError(timeseries_file_path + " is not a time series file")
+        version, num_statuses, num_age_groups, age_group_width, num_towns = struct.unpack('=5I', f.read(20))
+        if version != 1:
+            raise ValueError("Unsupported time series version " + str(version))
+
+        towns = []
+        for _ in range(num_towns):
+            name_length, = struct.unpack('=I', f.read(4))
+            name = f.read(name_length).decode('utf-8')
+            size, lat, lon = struct.unpack('=Idd', f.read(20))
+            towns.append({'name': name, 'size': size, 'lat': lat, 'long': lon})
+
+        record_length = 2 + num_statuses + num_age_groups + num_towns
+        record_format = '=' + str(record_length) + 'I'
+        record_size = struct.calcsize(record_format)
+        records = []
+        while True:
+            data = f.read(record_size)
+            if len(data) < record_size:
+                # A record that is being written is ignored.
+                break
+            values = struct.unpack(record_format, data)
+            statuses = values[2:2 + num_statuses]
+            records.append({
+                'region': values[0],
+                'day': values[1],
+                'status': statuses,
+                'infected_by_age': values[2 + num_statuses:2 + num_statuses + num_age_groups],
+                'infected_by_town': values[2 + num_statuses + num_age_groups:],
+                # Cases are the persons that are infected (exposed up to symptomatic) or recovered.
+                'cases': sum(statuses[1:6])})
+    return towns, records
+
+
+def write_cases(records, cases_file_path):
+    """
+    Write the cases of every day as one comma separated line, like CasesFile.
+    """
+    with open(cases_file_path, 'w') as f:
+        f.write(','.join(str(r['cases']) for r in records) + '\n')
+
+
+def write_vis(towns, records, vis_file_path):
+    """
+    Write the towns and the per day differences of infected per town, like
+    VisualizerFile.
+    """
+    days = []
+    previous = [0] * len(towns)
+    for r in records:
+        days.append({str(i): c - p for i, (c, p) in enumerate(zip(r['infected_by_town'], previous)) if c != p})
+        previous = r['infected_by_town']
+    with open(vis_file_path, 'w') as f:
+        json.dump({'towns': {str(i): t for i, t in enumerate(towns)}, 'days': days}, f, separators=(',', ':'))
+
+
+def main(argv):
+    if len(argv) == 1:
+        prefix = argv[0]
+        towns, records = read_timeseries(prefix + '_timeseries.bin')
+        write_cases(records, prefix + '_cases.csv')
+        if towns:
+            write_vis(towns, records, prefix + '_vis.json')
+    else:
+        print ("Usage: python timeseries_convert.py <output_prefix>")
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
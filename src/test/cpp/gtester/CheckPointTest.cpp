@@ -1,8 +1,13 @@
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
+#include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/filesystem.hpp>
 #include <checkpoint/CheckPoint.h>
+#include <checkpoint/CheckPointWriter.h>
 #include <core/ClusterType.h>
+#include <core/Health.h>
 #include <gtest/gtest.h>
 #include <pop/Population.h>
 #include <sim/SimulatorBuilder.h>
@@ -102,6 +107,25 @@ TEST(CheckPoint, Write_LoadHolidays)
 	EXPECT_EQ(c.GetDay(), 1U);
 }
 
+TEST(CheckPoint, InfectedStatusMatchesReplay)
+{
+	// Every fate with days in [0, 6], including coinciding days, for every day of the infection.
+	for (unsigned int code = 0; code < 7 * 7 * 7 * 7; code++) {
+		disease::Fate fate;
+		fate.start_infectiousness = code % 7;
+		fate.end_infectiousness = code / 7 % 7;
+		fate.start_symptomatic = code / 49 % 7;
+		fate.end_symptomatic = code / 343;
+
+		Health replayed(fate);
+		replayed.StartInfection();
+		for (unsigned int day = 0; day < 9; day++) {
+			EXPECT_EQ(replayed.GetHealthStatus(), Health::GetInfectedStatus(fate, replayed.GetDaysInfected()));
+			replayed.Update();
+		}
+	}
+}
+
 TEST(CheckPoint, SaveLoadCheckPoint)
 {
 	boost::property_tree::ptree pt_config;
@@ -244,13 +268,358 @@ TEST(CheckPoint, SaveLoadCheckPoint)
 	Atlas origAtlas = origPop.get_atlas();
 	Atlas readAtlas = popRead.get_atlas();
 
-	for(auto &key: origAtlas.cluster_map){
-		auto it = readAtlas.cluster_map.find(key.first);
-		EXPECT_NE(it,readAtlas.cluster_map.end());
-		EXPECT_EQ(key.second.latitude, it->second.latitude);
-		EXPECT_EQ(key.second.longitude, it->second.longitude);
+	origAtlas.ForEachCluster([&readAtlas](const Atlas::ClusterKey& key, const geo::GeoPosition& pos) {
+		ASSERT_NO_THROW(readAtlas.LookupPosition(key));
+		EXPECT_EQ(pos.latitude, readAtlas.LookupPosition(key).latitude);
+		EXPECT_EQ(pos.longitude, readAtlas.LookupPosition(key).longitude);
+	});
+
+
+}
+/// Compares the persons of two populations, including their health.
+void ExpectSamePersons(const Population& origPop, const Population& popRead)
+{
+	ASSERT_EQ(origPop.size(), popRead.size());
+	EXPECT_EQ(origPop.get_infected_count(), popRead.get_infected_count());
+	for (auto a = origPop.begin(), b = popRead.begin(); a != origPop.end(); ++a, ++b) {
+		const Person origP = *a, readP = *b;
+		ASSERT_EQ(origP.GetId(), readP.GetId());
+		EXPECT_EQ(origP.GetOriginalId(), readP.GetOriginalId());
+		EXPECT_EQ(origP.GetAge(), readP.GetAge());
+		EXPECT_EQ(origP.IsParticipatingInSurvey(), readP.IsParticipatingInSurvey());
+		EXPECT_EQ(origP.GetClusterId(ClusterType::Household), readP.GetClusterId(ClusterType::Household));
+		EXPECT_EQ(
+		    origP.GetClusterId(ClusterType::SecondaryCommunity),
+		    readP.GetClusterId(ClusterType::SecondaryCommunity));
+		EXPECT_EQ(origP.GetHealth().GetHealthStatus(), readP.GetHealth().GetHealthStatus());
+		EXPECT_EQ(origP.GetHealth().GetDaysInfected(), readP.GetHealth().GetDaysInfected());
+		EXPECT_EQ(origP.GetHealth().GetEndSymptomatic(), readP.GetHealth().GetEndSymptomatic());
+	}
+}
+
+void ExpectSameClusters(const Simulator& orig, const Simulator& read)
+{
+	const auto& origClusters = orig.GetClusters().m_households;
+	const auto& readClusters = read.GetClusters().m_households;
+	ASSERT_EQ(origClusters.size(), readClusters.size());
+	for (std::size_t i = 0; i < origClusters.size(); i++) {
+		EXPECT_EQ(origClusters[i].GetId(), readClusters[i].GetId());
+		std::vector<unsigned int> origIds, readIds;
+		for (const auto& p : origClusters[i].GetPeople())
+			origIds.push_back(p.GetId());
+		for (const auto& p : readClusters[i].GetPeople())
+			readIds.push_back(p.GetId());
+		std::sort(origIds.begin(), origIds.end());
+		std::sort(readIds.begin(), readIds.end());
+		EXPECT_EQ(origIds, readIds);
+	}
+}
+
+TEST(CheckPoint, SaveLoadChunkedCompressed)
+{
+	boost::property_tree::ptree pt_config;
+	util::InstallDirs::ReadXmlFile("config/run_test_save.xml", util::InstallDirs::GetRootDir(), pt_config);
+
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->track_index_case = 0;
+	// The persons keep their original ids through the checkpoint.
+	config.common_config->renumber_persons = true;
+
+	auto file_logger = spdlog::stderr_logger_st("test_chunked_checkpoint");
+	file_logger->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config.AsSingleConfig(), file_logger);
+	for (int i = 0; i < 3; i++)
+		(void)sim->TimeStep({{}, {}});
+
+	// A chunk size that doesn't divide the population size exercises the partial last chunk.
+	stride::checkpoint::CheckPoint cp("SaveChunkedCheckPoint.h5", 7, 6);
+	cp.CreateFile();
+	cp.OpenFile();
+	cp.SaveCheckPoint(*sim, 0);
+	cp.CloseFile();
+
+	Simulator simRead;
+	cp.OpenFile();
+	cp.LoadCheckPoint(sim->GetDate(), simRead);
+	cp.CloseFile();
+
+	ExpectSamePersons(*sim->GetPopulation(), *simRead.GetPopulation());
+	ExpectSameClusters(*sim, simRead);
+
+	boost::filesystem::remove("SaveChunkedCheckPoint.h5");
+	spdlog::drop("test_chunked_checkpoint");
+}
+
+TEST(CheckPoint, SaveLoadColumnar)
+{
+	boost::property_tree::ptree pt_config;
+	util::InstallDirs::ReadXmlFile("config/run_test_save.xml", util::InstallDirs::GetRootDir(), pt_config);
+
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->track_index_case = 0;
+	// The persons keep their original ids through the checkpoint.
+	config.common_config->renumber_persons = true;
+
+	auto file_logger = spdlog::stderr_logger_st("test_columnar_checkpoint");
+	file_logger->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config.AsSingleConfig(), file_logger);
+
+	// The second checkpoint reuses the static columns of the first.
+	stride::checkpoint::CheckPoint cp(
+	    "SaveColumnarCheckPoint.h5", 65536, 0, stride::checkpoint::CheckPointLayout::Columnar);
+	cp.CreateFile();
+	cp.OpenFile();
+	cp.SaveCheckPoint(*sim, 0);
+	for (int i = 0; i < 4; i++)
+		(void)sim->TimeStep({{}, {}});
+	cp.SaveCheckPoint(*sim, 4);
+	cp.CloseFile();
+
+	Simulator simRead;
+	cp.OpenFile();
+	cp.LoadCheckPoint(sim->GetDate(), simRead);
+	cp.CloseFile();
+
+	ExpectSamePersons(*sim->GetPopulation(), *simRead.GetPopulation());
+
+	boost::filesystem::remove("SaveColumnarCheckPoint.h5");
+	spdlog::drop("test_columnar_checkpoint");
+}
+
+TEST(CheckPoint, SaveLoadDelta)
+{
+	boost::property_tree::ptree pt_config;
+	util::InstallDirs::ReadXmlFile("config/run_test_save.xml", util::InstallDirs::GetRootDir(), pt_config);
+
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->track_index_case = 0;
+
+	auto file_logger = spdlog::stderr_logger_st("test_delta_checkpoint");
+	file_logger->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config.AsSingleConfig(), file_logger);
+
+	// Every date is written in the delta layout and, for reference, in the columnar layout.
+	stride::checkpoint::CheckPoint cp("SaveDeltaCheckPoint.h5", 65536, 0, stride::checkpoint::CheckPointLayout::Delta);
+	stride::checkpoint::CheckPoint reference(
+	    "SaveDeltaReference.h5", 65536, 0, stride::checkpoint::CheckPointLayout::Columnar);
+	cp.CreateFile();
+	reference.CreateFile();
+	std::vector<boost::gregorian::date> dates;
+	for (int day = 0; day <= 6; day += 2) {
+		cp.OpenFile();
+		cp.SaveCheckPoint(*sim, day);
+		cp.CloseFile();
+		reference.OpenFile();
+		reference.SaveCheckPoint(*sim, day);
+		reference.CloseFile();
+		dates.push_back(sim->GetDate());
+		for (int i = 0; i < 2; i++)
+			(void)sim->TimeStep({{}, {}});
+	}
+
+	// A later date continues the deltas of the dates written before, even from a fresh CheckPoint.
+	stride::checkpoint::CheckPoint resumed(
+	    "SaveDeltaCheckPoint.h5", 65536, 0, stride::checkpoint::CheckPointLayout::Delta);
+	resumed.OpenFile();
+	resumed.SaveCheckPoint(*sim, 8);
+	resumed.CloseFile();
+
+	for (const auto& date : dates) {
+		Simulator fromDelta, fromReference;
+		cp.OpenFile();
+		cp.LoadCheckPoint(date, fromDelta);
+		cp.CloseFile();
+		reference.OpenFile();
+		reference.LoadCheckPoint(date, fromReference);
+		reference.CloseFile();
+		ExpectSamePersons(*fromReference.GetPopulation(), *fromDelta.GetPopulation());
+	}
+
+	Simulator simRead;
+	cp.OpenFile();
+	cp.LoadCheckPoint(sim->GetDate(), simRead);
+	cp.CloseFile();
+	ExpectSamePersons(*sim->GetPopulation(), *simRead.GetPopulation());
+	ExpectSameClusters(*sim, simRead);
+
+	// A recreated file starts over, rather than continuing the deltas of the file it replaces.
+	for (int i = 0; i < 2; i++)
+		(void)sim->TimeStep({{}, {}});
+	cp.CreateFile();
+	cp.OpenFile();
+	cp.SaveCheckPoint(*sim, 10);
+	cp.CloseFile();
+	Simulator simRecreated;
+	cp.OpenFile();
+	cp.LoadCheckPoint(sim->GetDate(), simRecreated);
+	cp.CloseFile();
+	ExpectSamePersons(*sim->GetPopulation(), *simRecreated.GetPopulation());
+
+	boost::filesystem::remove("SaveDeltaCheckPoint.h5");
+	boost::filesystem::remove("SaveDeltaReference.h5");
+	spdlog::drop("test_delta_checkpoint");
+}
+
+TEST(CheckPoint, ForkFromSnapshot)
+{
+	boost::property_tree::ptree pt_config;
+	util::InstallDirs::ReadXmlFile("config/run_test_save.xml", util::InstallDirs::GetRootDir(), pt_config);
+
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->track_index_case = 0;
+
+	auto file_logger = spdlog::stderr_logger_st("test_fork_checkpoint");
+	file_logger->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config.AsSingleConfig(), file_logger);
+	for (int i = 0; i < 3; i++)
+		(void)sim->TimeStep({{}, {}});
+
+	stride::checkpoint::CheckPoint cp("ForkCheckPoint.h5");
+	cp.CreateFile();
+	cp.OpenFile();
+	cp.SaveCheckPoint(*sim, 3);
+	cp.CloseFile();
+
+	// The file is read once; every fork continues from the same state with its own seed.
+	cp.OpenFile();
+	const auto snapshot = cp.LoadSnapshot(sim->GetDate());
+	cp.CloseFile();
+
+	std::vector<std::shared_ptr<Simulator>> forks;
+	for (unsigned int seed = 1; seed <= 2; seed++) {
+		auto forkConfig = config.AsSingleConfig();
+		forkConfig.common_config = std::make_shared<CommonSimulationConfig>(*config.common_config);
+		forkConfig.common_config->rng_seed = seed;
+		forkConfig.common_config->initial_calendar.Initialize(sim->GetDate(), "holidays_flanders_2016.json");
+		forks.push_back(stride::checkpoint::CheckPoint::Fork(*snapshot, forkConfig, seed, file_logger));
+		EXPECT_EQ(sim->GetDate(), forks.back()->GetDate());
+		ExpectSamePersons(*sim->GetPopulation(), *forks.back()->GetPopulation());
+		ExpectSameClusters(*sim, *forks.back());
+	}
+
+	// Forks share the snapshot's atlas, but not its persons: running one leaves the other at the snapshot.
+	EXPECT_EQ(&forks[0]->GetPopulation()->get_atlas(), &forks[1]->GetPopulation()->get_atlas());
+	EXPECT_EQ(
+	    config.log_config->output_prefix + "_fork2", forks[1]->GetConfiguration().log_config->output_prefix);
+	for (int i = 0; i < 5; i++)
+		(void)forks[0]->TimeStep({{}, {}});
+	Simulator restored;
+	stride::checkpoint::CheckPoint::RestoreSnapshot(*snapshot, restored);
+	ExpectSamePersons(*restored.GetPopulation(), *forks[1]->GetPopulation());
+
+	boost::filesystem::remove("ForkCheckPoint.h5");
+	spdlog::drop("test_fork_checkpoint");
+}
+
+TEST(CheckPoint, BackgroundWriter)
+{
+	boost::property_tree::ptree pt_config;
+	util::InstallDirs::ReadXmlFile("config/run_test_save.xml", util::InstallDirs::GetRootDir(), pt_config);
+
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->track_index_case = 0;
+
+	auto file_logger = spdlog::stderr_logger_st("test_checkpoint_writer");
+	file_logger->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config.AsSingleConfig(), file_logger);
+
+	auto cp = std::make_shared<stride::checkpoint::CheckPoint>("BackgroundCheckPoint.h5");
+	cp->CreateFile();
+	{
+		// The simulation keeps running while earlier snapshots are written.
+		stride::checkpoint::CheckPointWriter writer(cp, 1);
+		for (int i = 0; i < 3; i++) {
+			writer.Enqueue(stride::checkpoint::CheckPoint::TakeSnapshot(*sim, i));
+			(void)sim->TimeStep({{}, {}});
+		}
+		writer.Enqueue(stride::checkpoint::CheckPoint::TakeSnapshot(*sim, 3));
+		writer.Flush();
 	}
 
+	Simulator simRead;
+	cp->OpenFile();
+	EXPECT_EQ(sim->GetDate(), cp->GetLastDate());
+	cp->LoadCheckPoint(sim->GetDate(), simRead);
+	cp->CloseFile();
 
+	ExpectSamePersons(*sim->GetPopulation(), *simRead.GetPopulation());
+
+	boost::filesystem::remove("BackgroundCheckPoint.h5");
+	spdlog::drop("test_checkpoint_writer");
 }
-} // Tests
\ No newline at end of file
+
+TEST(CheckPoint, BackgroundWriterDelta)
+{
+	boost::property_tree::ptree pt_config;
+	util::InstallDirs::ReadXmlFile("config/run_test_save.xml", util::InstallDirs::GetRootDir(), pt_config);
+
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->track_index_case = 0;
+
+	auto file_logger = spdlog::stderr_logger_st("test_checkpoint_writer_delta");
+	file_logger->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config.AsSingleConfig(), file_logger);
+
+	// The writer opens and closes the file for every snapshot.
+	auto cp = std::make_shared<stride::checkpoint::CheckPoint>(
+	    "BackgroundDeltaCheckPoint.h5", 65536, 0, stride::checkpoint::CheckPointLayout::Delta);
+	cp->CreateFile();
+	std::vector<boost::gregorian::date> dates;
+	{
+		stride::checkpoint::CheckPointWriter writer(cp, 1);
+		for (int i = 0; i < 2; i++) {
+			dates.push_back(sim->GetDate());
+			writer.Enqueue(stride::checkpoint::CheckPoint::TakeSnapshot(*sim, i));
+			(void)sim->TimeStep({{}, {}});
+		}
+		writer.Flush();
+	}
+
+	// The second date holds the day's health changes only, and no journals, as they didn't change.
+	const auto second = boost::gregorian::to_iso_string(dates[1]);
+	hid_t file = H5Fopen("BackgroundDeltaCheckPoint.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+	EXPECT_LE(H5Lexists(file, (second + "/Expatriates").c_str(), H5P_DEFAULT), 0);
+	EXPECT_LE(H5Lexists(file, (second + "/Visitors").c_str(), H5P_DEFAULT), 0);
+	hid_t dataset = H5Dopen2(file, (second + "/Delta/ID").c_str(), H5P_DEFAULT);
+	hid_t dataspace = H5Dget_space(dataset);
+	EXPECT_LT(H5Sget_simple_extent_npoints(dataspace), static_cast<hssize_t>(sim->GetPopulation()->size() / 10));
+	H5Sclose(dataspace);
+	H5Dclose(dataset);
+	H5Fclose(file);
+
+	Simulator simRead;
+	cp->OpenFile();
+	cp->LoadCheckPoint(dates[1], simRead);
+	cp->CloseFile();
+	EXPECT_EQ(sim->GetPopulation()->size(), simRead.GetPopulation()->size());
+
+	boost::filesystem::remove("BackgroundDeltaCheckPoint.h5");
+	spdlog::drop("test_checkpoint_writer_delta");
+}
+
+TEST(CheckPoint, RefusesCommuting)
+{
+	boost::property_tree::ptree pt_config;
+	util::InstallDirs::ReadXmlFile("config/run_commuting_test.xml", util::InstallDirs::GetRootDir(), pt_config);
+
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->generate_vis_file = false;
+
+	auto file_logger = spdlog::stderr_logger_st("test_checkpoint_commuting");
+	file_logger->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config.GetSingleConfigs().front(), file_logger);
+
+	// A snapshot would lose the commuters.
+	EXPECT_THROW(stride::checkpoint::CheckPoint::TakeSnapshot(*sim, 0), std::runtime_error);
+
+	spdlog::drop("test_checkpoint_commuting");
+}
+
+} // Tests
@@ -0,0 +1,182 @@
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+#include <gtest/gtest.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+#include "core/ClusterType.h"
+#include "core/Health.h"
+#include "multiregion/CommutingModel.h"
+#include "multiregion/SequentialSimulationManager.h"
+#include "sim/SimulationConfig.h"
+#include "sim/Simulator.h"
+#include "util/InstallDirs.h"
+
+namespace Tests {
+
+using namespace stride;
+using namespace stride::multiregion;
+using namespace stride::util;
+
+namespace {
+
+/// Counts the commuters and the population of a region after every step.
+class CommuterCounts
+{
+public:
+	CommuterCounts(RegionId, bool) {}
+
+	void BeforeSimulatorStep(Simulator&) {}
+
+	void AfterSimulatorStep(const Simulator& sim)
+	{
+		outgoing = sim.GetOutgoingCommuterCount();
+		incoming = sim.GetIncomingCommuterCount();
+		population = sim.GetPopulation()->size();
+	}
+
+	std::size_t outgoing = 0;
+	std::size_t incoming = 0;
+	std::size_t population = 0;
+};
+
+/// Makes the susceptible workers of the second region infectious on the second day, when the commuters work in
+/// their new work clusters for the first time. Counts the infected residents of the first region after every
+/// step, for its commuters and for the others.
+class InfectionCrossing
+{
+public:
+	InfectionCrossing(RegionId id, bool) : id(id) {}
+
+	void BeforeSimulatorStep(Simulator& sim)
+	{
+		if (id != 1 || day != 1) {
+			return;
+		}
+		sim.GetPopulation()->serial_for([](const Person& p, unsigned int) {
+			auto& health = p.GetHealth();
+			if (p.GetClusterId(ClusterType::Work) == 0 || !health.IsSusceptible()) {
+				return;
+			}
+			health.StartInfection();
+			while (!health.IsInfectious() && health.GetDaysInfected() < health.GetStartInfectiousness()) {
+				health.Update();
+			}
+		});
+	}
+
+	void AfterSimulatorStep(const Simulator& sim)
+	{
+		day++;
+		if (id != 0) {
+			return;
+		}
+		std::size_t commuters = 0;
+		std::size_t others = 0;
+		sim.GetPopulation()->serial_for([&](const Person& p, unsigned int) {
+			if (p.GetHealth().IsInfected()) {
+				++(sim.IsCommuter(p.GetId()) ? commuters : others);
+			}
+		});
+		infected_commuters.push_back(commuters);
+		infected_others.push_back(others);
+	}
+
+	RegionId id;
+	std::size_t day = 0;
+	std::vector<std::size_t> infected_commuters;
+	std::vector<std::size_t> infected_others;
+};
+
+} // namespace
+
+TEST(Commuting, KeepsFlowsBetweenRegions)
+{
+	std::vector<std::vector<geo::City>> region_cities{
+	    {{1, "ONE", 1, 1.0, 0.0, 0.0, {51.0, 4.0}}}, {{2, "TWO", 2, 1.0, 0.0, 0.0, {50.0, 4.0}}}};
+	std::istringstream flows{"\"city_depart\",\"city_arrival\",\"proportion\"\n"
+				 "1,1,0.9\n"
+				 "1,2,0.06\n"
+				 "1,3,0.04\n"
+				 "2,1,0.1\n"
+				 "3,1,0.5\n"};
+	const CommutingModel model(region_cities, flows);
+
+	// Flows within a region and flows of cities outside the regions are dropped.
+	ASSERT_EQ(1U, model.GetFlows(1).size());
+	EXPECT_EQ(2, model.GetFlows(1)[0].city_id);
+	EXPECT_EQ(1U, model.GetFlows(1)[0].region_id);
+	EXPECT_DOUBLE_EQ(0.06, model.GetFlows(1)[0].fraction);
+	ASSERT_EQ(1U, model.GetFlows(2).size());
+	EXPECT_TRUE(model.GetFlows(3).empty());
+
+	EXPECT_EQ(1U, model.GetConnectedRegions(0).count(1));
+	EXPECT_EQ(1U, model.GetConnectedRegions(1).count(0));
+	EXPECT_EQ(2, model.FindNearestCity(1, {50.1, 4.1})->id);
+	EXPECT_EQ(nullptr, model.FindNearestCity(2, {50.1, 4.1}));
+}
+
+TEST(Commuting, ExchangesCommuters)
+{
+	boost::property_tree::ptree pt_config;
+	InstallDirs::ReadXmlFile("config/run_commuting_test.xml", InstallDirs::GetRootDir(), pt_config);
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	ASSERT_NE(nullptr, config.common_config->commuting_model);
+	config.common_config->generate_vis_file = false;
+
+	auto log = std::make_shared<spdlog::logger>("commuting_test", std::make_shared<spdlog::sinks::null_sink_st>());
+	SequentialSimulationManager<CommuterCounts, RegionId> manager{1};
+	std::vector<std::shared_ptr<SimulationTask<CommuterCounts>>> tasks;
+	std::vector<std::size_t> population_sizes;
+	for (const auto& single_config : config.GetSingleConfigs()) {
+		tasks.push_back(manager.CreateSimulation(single_config, log, single_config.GetId()));
+		population_sizes.push_back(tasks.back()->GetPopulationSize());
+	}
+	manager.WaitAll();
+
+	// Every commuter is a shadow in the region where they work, and nobody leaves the population.
+	ASSERT_EQ(2U, tasks.size());
+	const auto antwerp = tasks[0]->GetResult();
+	const auto brussels = tasks[1]->GetResult();
+	EXPECT_GT(antwerp.outgoing, 0U);
+	EXPECT_GT(brussels.outgoing, 0U);
+	EXPECT_EQ(antwerp.outgoing, brussels.incoming);
+	EXPECT_EQ(brussels.outgoing, antwerp.incoming);
+	EXPECT_EQ(population_sizes[0], antwerp.population);
+	EXPECT_EQ(population_sizes[1], brussels.population);
+}
+
+TEST(Commuting, CarriesInfectionsAcrossRegions)
+{
+	boost::property_tree::ptree pt_config;
+	InstallDirs::ReadXmlFile("config/run_commuting_test.xml", InstallDirs::GetRootDir(), pt_config);
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->generate_vis_file = false;
+	config.common_config->seeding_rate = 0.0;
+	config.common_config->number_of_days = 3U;
+
+	auto log = std::make_shared<spdlog::logger>("crossing_test", std::make_shared<spdlog::sinks::null_sink_st>());
+	SequentialSimulationManager<InfectionCrossing, RegionId> manager{1};
+	std::vector<std::shared_ptr<SimulationTask<InfectionCrossing>>> tasks;
+	for (const auto& single_config : config.GetSingleConfigs()) {
+		tasks.push_back(manager.CreateSimulation(single_config, log, single_config.GetId()));
+	}
+	manager.WaitAll();
+
+	// The first region has no infections of its own. The commuters who were infected at work in the second
+	// region on the second day, and the coworkers of the infectious commuters of the second region, are
+	// infected a day later: the work region reports the infections, and the home region the health, at the end
+	// of a step.
+	const auto first = tasks[0]->GetResult();
+	ASSERT_EQ(3U, first.infected_commuters.size());
+	EXPECT_EQ(0U, first.infected_commuters[0] + first.infected_others[0]);
+	EXPECT_EQ(0U, first.infected_commuters[1] + first.infected_others[1]);
+	EXPECT_GT(first.infected_commuters[2], 0U);
+	EXPECT_GT(first.infected_others[2], 0U);
+}
+
+} // Tests
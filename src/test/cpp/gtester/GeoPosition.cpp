@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <iostream>
+#include <map>
 #include <vector>
+#include <geo/GeoGrid.h>
 #include <geo/GeoPosition.h>
 #include <gtest/gtest.h>
 
@@ -13,4 +16,75 @@ TEST(GeoPosition, SampleCalculation)
 	ASSERT_NEAR(amsterdam.Distance(paris), 429.7, 1.0);
 }
 
+TEST(GeoPosition, HullSamplesLieInHull)
+{
+	using namespace stride::geo;
+	const std::vector<GeoPosition> points{{50.0, 3.0}, {51.5, 3.2}, {51.2, 5.9}, {50.3, 6.1}, {50.8, 4.5}};
+	const HullSampler sampler(points);
+
+	GeoPolygon hull;
+	boost::geometry::convex_hull(points, hull);
+	stride::util::Random rng(0);
+	for (int i = 0; i < 1000; i++) {
+		EXPECT_TRUE(boost::geometry::covered_by(sampler.Sample(rng), hull));
+	}
+}
+
+TEST(GeoPosition, HullSamplesAreUniform)
+{
+	using namespace stride::geo;
+	// A square hull, which is split in two triangles, and a 4 by 4 grid of cells of equal area.
+	const std::vector<GeoPosition> points{{50.0, 3.0}, {51.0, 3.0}, {51.0, 4.0}, {50.0, 4.0}, {50.4, 3.7}};
+	const HullSampler sampler(points);
+
+	const int num_cells = 16;
+	const int num_samples = 16000;
+	std::vector<int> counts(num_cells, 0);
+	stride::util::Random rng(0);
+	for (int i = 0; i < num_samples; i++) {
+		const auto sample = sampler.Sample(rng);
+		const int row = std::min(3, static_cast<int>((sample.latitude - 50.0) * 4.0));
+		const int column = std::min(3, static_cast<int>((sample.longitude - 3.0) * 4.0));
+		counts[row * 4 + column]++;
+	}
+
+	// The chi-square statistic with 15 degrees of freedom exceeds 37.7 with a probability of 0.001.
+	const double expected = static_cast<double>(num_samples) / num_cells;
+	double chi_square = 0.0;
+	for (const int count : counts) {
+		chi_square += (count - expected) * (count - expected) / expected;
+	}
+	EXPECT_LT(chi_square, 37.7);
+}
+
+TEST(GeoPosition, GridMatchesLinearScan)
+{
+	using namespace stride::geo;
+	stride::util::Random rng(42);
+	std::map<GeoPosition, int> map;
+	for (int i = 0; i < 2000; i++) {
+		map[{rng(49.5, 51.5), rng(2.5, 6.4)}] = i;
+	}
+
+	const GeoGrid<int> grid(map, 10.0);
+	for (int i = 0; i < 200; i++) {
+		const GeoPosition origin{rng(49.0, 52.0), rng(2.0, 7.0)};
+		const double radius = rng(1.0, 80.0);
+
+		std::vector<std::reference_wrapper<int>> hits;
+		grid.FindWithin(origin, radius, hits);
+
+		std::vector<int> expected;
+		for (auto& p : map) {
+			if (p.first.Distance(origin) < radius) {
+				expected.push_back(p.second);
+			}
+		}
+		ASSERT_EQ(expected.size(), hits.size());
+		for (std::size_t j = 0; j < hits.size(); j++) {
+			EXPECT_EQ(expected[j], hits[j].get());
+		}
+	}
+}
+
 } // Tests
\ No newline at end of file
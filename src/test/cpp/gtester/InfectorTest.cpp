@@ -0,0 +1,234 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+#include <gtest/gtest.h>
+#include <spdlog/sinks/ostream_sink.h>
+#include <spdlog/spdlog.h>
+#include "calendar/Calendar.h"
+#include "core/Cluster.h"
+#include "core/DiseaseProfile.h"
+#include "core/Infector.h"
+#include "core/RngHandler.h"
+#include "core/TransmissionKernel.h"
+#include "sim/SimulationConfig.h"
+#include "sim/Simulator.h"
+#include "sim/SimulatorBuilder.h"
+#include "util/InstallDirs.h"
+#include "util/Random.h"
+
+namespace Tests {
+
+using namespace stride;
+using namespace stride::util;
+using boost::property_tree::ptree;
+
+TEST(Infector, HouseholdKernelsMatchInfector)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile("../config/run_test_popgen.xml", InstallDirs::GetCurrentDir(), pt_config);
+	// Lots of transmissions.
+	pt_config.put("run.r0", 40);
+	pt_config.put("run.seeding_rate", 0.05);
+	pt_config.put("run.immunity_rate", 0.0);
+	SingleSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	ptree pt_disease;
+	InstallDirs::ReadXmlFile(config.common_config->disease_config_file_name, InstallDirs::GetDataDir(), pt_disease);
+	DiseaseProfile disease_profile;
+	disease_profile.Initialize(config, pt_disease);
+	const CalendarRef calendar = std::make_shared<Calendar>(config.common_config->initial_calendar);
+
+	auto log = spdlog::stderr_logger_st("test_infector");
+	log->set_level(spdlog::level::off);
+	auto kernel_sim = SimulatorBuilder::Build(pt_config, log, 1, false);
+	auto infector_sim = SimulatorBuilder::Build(pt_config, log, 1, false);
+	auto& kernel_households = kernel_sim->GetClusters().m_households;
+	auto& infector_households = infector_sim->GetClusters().m_households;
+	ASSERT_EQ(infector_households.size(), kernel_households.size());
+
+	std::ostringstream kernel_text, infector_text;
+	auto kernel_log = std::make_shared<spdlog::logger>(
+	    "test_infector_kernel", std::make_shared<spdlog::sinks::ostream_sink_st>(kernel_text));
+	auto infector_log = std::make_shared<spdlog::logger>(
+	    "test_infector_generic", std::make_shared<spdlog::sinks::ostream_sink_st>(infector_text));
+	kernel_log->set_pattern("%v");
+	infector_log->set_pattern("%v");
+
+	TownInfectionCounter::Delta town_infections;
+	for (unsigned int day = 0; day < 12; day++) {
+		// Run the households of one simulator through the kernels and those of the other through the Infector.
+		RngHandler kernel_rng(day, 1, 0);
+		RngHandler infector_rng(day, 1, 0);
+		HouseholdInfector<LogMode::Transmissions, false, NoLocalInformation>::Execute(
+		    kernel_households, 0, kernel_households.size(), disease_profile, kernel_rng, calendar, kernel_log,
+		    nullptr, nullptr, town_infections);
+		for (auto& household : infector_households) {
+			Infector<LogMode::Transmissions, false, NoLocalInformation>::Execute(
+			    household, disease_profile, infector_rng, calendar, infector_log, nullptr, nullptr,
+			    town_infections);
+		}
+
+		// The members are in the same order, with the same health.
+		for (std::size_t i = 0; i < kernel_households.size(); i++) {
+			const auto kernel_members = kernel_households[i].GetPeople();
+			const auto infector_members = infector_households[i].GetPeople();
+			ASSERT_EQ(infector_members.size(), kernel_members.size());
+			for (std::size_t j = 0; j < kernel_members.size(); j++) {
+				ASSERT_EQ(infector_members[j].GetId(), kernel_members[j].GetId()) << "household " << i;
+				ASSERT_EQ(
+				    infector_members[j].GetHealth().GetHealthStatus(),
+				    kernel_members[j].GetHealth().GetHealthStatus())
+				    << "household " << i;
+			}
+		}
+		ASSERT_EQ(infector_text.str(), kernel_text.str()) << "on day " << day;
+
+		(void)kernel_sim->TimeStep({{}, {}});
+		(void)infector_sim->TimeStep({{}, {}});
+	}
+	EXPECT_FALSE(kernel_text.str().empty());
+
+	spdlog::drop("test_infector");
+}
+
+TEST(Infector, TransmissionKernelMatchesScalar)
+{
+	// Every implementation that the CPU supports, not only the one that Select picks.
+	using SelectFunction =
+	    std::size_t (*)(const double*, const std::uint8_t*, std::size_t, double, std::uint32_t*);
+	std::vector<std::pair<std::string, SelectFunction>> kernels{{"select", TransmissionKernel::Select}};
+	if (TransmissionKernel::SupportsAvx2()) {
+		kernels.emplace_back("avx2", TransmissionKernel::SelectAvx2);
+	}
+	if (TransmissionKernel::SupportsAvx512()) {
+		kernels.emplace_back("avx512", TransmissionKernel::SelectAvx512);
+	}
+
+	util::Random rng(1);
+	for (std::size_t count = 0; count < 100; count++) {
+		std::vector<double> uniforms(count);
+		std::vector<std::uint8_t> susceptible(count);
+		for (std::size_t i = 0; i < count; i++) {
+			uniforms[i] = rng.NextDouble();
+			susceptible[i] = rng.Chance(0.8);
+		}
+		const double probability = rng.NextDouble();
+		std::vector<std::uint32_t> scalar_hits(count);
+		const auto num_scalar_hits = TransmissionKernel::SelectScalar(
+		    uniforms.data(), susceptible.data(), count, probability, scalar_hits.data());
+		for (const auto& kernel : kernels) {
+			std::vector<std::uint32_t> hits(count);
+			const auto num_hits =
+			    kernel.second(uniforms.data(), susceptible.data(), count, probability, hits.data());
+			ASSERT_EQ(num_scalar_hits, num_hits) << kernel.first << " with " << count << " contacts";
+			for (std::size_t i = 0; i < num_hits; i++) {
+				ASSERT_EQ(scalar_hits[i], hits[i]) << kernel.first;
+			}
+		}
+	}
+}
+
+TEST(Infector, BatchedMatchesPairs)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile("../config/run_test_popgen.xml", InstallDirs::GetCurrentDir(), pt_config);
+	// Lots of transmissions.
+	pt_config.put("run.r0", 40);
+	pt_config.put("run.seeding_rate", 0.05);
+	pt_config.put("run.immunity_rate", 0.0);
+	SingleSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	ptree pt_disease;
+	InstallDirs::ReadXmlFile(config.common_config->disease_config_file_name, InstallDirs::GetDataDir(), pt_disease);
+	DiseaseProfile disease_profile;
+	disease_profile.Initialize(config, pt_disease);
+	const CalendarRef calendar = std::make_shared<Calendar>(config.common_config->initial_calendar);
+
+	auto log = spdlog::stderr_logger_st("test_batched_infector");
+	log->set_level(spdlog::level::off);
+	auto batched_sim = SimulatorBuilder::Build(pt_config, log, 1, false);
+	auto pairs_sim = SimulatorBuilder::Build(pt_config, log, 1, false);
+
+	std::ostringstream batched_text, pairs_text;
+	auto batched_log = std::make_shared<spdlog::logger>(
+	    "test_infector_batched", std::make_shared<spdlog::sinks::ostream_sink_st>(batched_text));
+	auto pairs_log = std::make_shared<spdlog::logger>(
+	    "test_infector_pairs", std::make_shared<spdlog::sinks::ostream_sink_st>(pairs_text));
+	batched_log->set_pattern("%v");
+	pairs_log->set_pattern("%v");
+
+	using Infect = Infector<LogMode::Transmissions, false, NoLocalInformation>;
+	TownInfectionCounter::Delta town_infections;
+	std::size_t num_large_clusters = 0;
+	for (unsigned int day = 0; day < 6; day++) {
+		// The clusters of one simulator select their infected contacts in batches, those of the other for
+		// every pair.
+		RngHandler batched_rng(day, 1, 0);
+		RngHandler pairs_rng(day, 1, 0);
+		auto& batched_clusters = batched_sim->GetClusters();
+		auto& pairs_clusters = pairs_sim->GetClusters();
+		for (const auto member : {&ClusterStruct::m_school_clusters, &ClusterStruct::m_work_clusters,
+					  &ClusterStruct::m_primary_community, &ClusterStruct::m_secondary_community}) {
+			auto& batched = batched_clusters.*member;
+			auto& pairs = pairs_clusters.*member;
+			ASSERT_EQ(pairs.size(), batched.size());
+			for (std::size_t i = 0; i < batched.size(); i++) {
+				num_large_clusters += batched[i].GetSize() >= 2 * TransmissionKernel::MinContacts;
+				Infect::Execute(
+				    batched[i], disease_profile, batched_rng, calendar, batched_log, nullptr, nullptr,
+				    town_infections);
+				Infect::Execute(
+				    pairs[i], disease_profile, pairs_rng, calendar, pairs_log, nullptr, nullptr,
+				    town_infections, std::numeric_limits<std::size_t>::max());
+			}
+		}
+
+		// The same contacts are infected, and the same numbers are drawn.
+		ASSERT_EQ(pairs_text.str(), batched_text.str()) << "on day " << day;
+		double batched_next, pairs_next;
+		batched_rng.DrawUniforms(&batched_next, 1);
+		pairs_rng.DrawUniforms(&pairs_next, 1);
+		ASSERT_EQ(pairs_next, batched_next) << "on day " << day;
+
+		(void)batched_sim->TimeStep({{}, {}});
+		(void)pairs_sim->TimeStep({{}, {}});
+	}
+	EXPECT_GT(num_large_clusters, 0U);
+	EXPECT_FALSE(batched_text.str().empty());
+
+	spdlog::drop("test_batched_infector");
+}
+
+TEST(Infector, TransmissionKernelInfectsWithProbability)
+{
+	// Every other contact is susceptible; those are infected with the given probability.
+	const std::size_t count = 100000;
+	const double probability = 0.3;
+	RngHandler handler(3, 1, 0);
+	std::vector<double> uniforms(count);
+	std::vector<std::uint8_t> susceptible(count);
+	std::vector<std::uint32_t> hits(count);
+	handler.DrawUniforms(uniforms.data(), count);
+	for (std::size_t i = 0; i < count; i++) {
+		susceptible[i] = i % 2;
+	}
+	const auto num_hits =
+	    TransmissionKernel::Select(uniforms.data(), susceptible.data(), count, probability, hits.data());
+	for (std::size_t i = 0; i < num_hits; i++) {
+		EXPECT_EQ(1U, hits[i] % 2);
+		if (i > 0) {
+			EXPECT_LT(hits[i - 1], hits[i]);
+		}
+	}
+	// Within five standard deviations of the binomial mean.
+	const double n = count / 2;
+	EXPECT_NEAR(n * probability, num_hits, 5 * std::sqrt(n * probability * (1 - probability)));
+}
+
+} // Tests
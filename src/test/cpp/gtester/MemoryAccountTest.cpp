@@ -0,0 +1,149 @@
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <boost/property_tree/ptree.hpp>
+#include <gtest/gtest.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+#include "multiregion/ParallelSimulationManager.h"
+#include "sim/SimulationConfig.h"
+#include "sim/Simulator.h"
+#include "sim/SimulatorBuilder.h"
+#include "util/InstallDirs.h"
+#include "util/MemoryAccount.h"
+
+namespace Tests {
+
+using namespace stride;
+using namespace stride::util;
+
+namespace {
+
+/// Builds the simulator of the visualizer test configuration, which has an atlas.
+std::shared_ptr<Simulator> BuildSimulator(unsigned int memory_budget)
+{
+	boost::property_tree::ptree pt_config;
+	InstallDirs::ReadXmlFile("config/run_test_visualizer.xml", InstallDirs::GetRootDir(), pt_config);
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->memory_budget = memory_budget;
+	auto log = std::make_shared<spdlog::logger>("memory_test", std::make_shared<spdlog::sinks::null_sink_st>());
+	return SimulatorBuilder::Build(config.AsSingleConfig(), log);
+}
+
+/// Checks a budget of 1 MiB after every step of the first region, which always exceeds it.
+class OverBudget
+{
+public:
+	OverBudget(multiregion::RegionId id, bool) : id(id) {}
+
+	void BeforeSimulatorStep(Simulator&) {}
+
+	void AfterSimulatorStep(const Simulator& sim)
+	{
+		if (id == 0) {
+			MemoryAccount account;
+			sim.AccountMemory(account);
+			account.CheckBudget(1U, "of region 0");
+		}
+	}
+
+	multiregion::RegionId id;
+};
+
+} // namespace
+
+TEST(MemoryAccount, AddsSubsystems)
+{
+	MemoryAccount account;
+	account.Add("a", {1U, 2U});
+	account.Add("b", {3U, 4U});
+	account.Add("a", {5U, 6U});
+
+	// Subsystems keep the order in which they were first added.
+	ASSERT_EQ(2U, account.GetSubsystems().size());
+	EXPECT_EQ("a", account.GetSubsystems()[0].first);
+	EXPECT_EQ(6U, account.GetSubsystems()[0].second.used);
+	EXPECT_EQ(8U, account.GetSubsystems()[0].second.allocated);
+	EXPECT_EQ(9U, account.GetTotal().used);
+	EXPECT_EQ(12U, account.GetTotal().allocated);
+
+	account.Add("c", {0U, 2U * 1024U * 1024U});
+	EXPECT_THROW(account.CheckBudget(1U, "now"), std::runtime_error);
+	EXPECT_NO_THROW(account.CheckBudget(3U, "now"));
+	EXPECT_NO_THROW(account.CheckBudget(0U, "now"));
+}
+
+TEST(MemoryAccount, AccountsSimulator)
+{
+	const auto sim = BuildSimulator(0U);
+	MemoryAccount account;
+	sim->AccountMemory(account);
+	std::map<std::string, MemoryUsage> subsystems;
+	for (const auto& entry : account.GetSubsystems()) {
+		subsystems[entry.first] = entry.second;
+		EXPECT_LE(entry.second.used, entry.second.allocated);
+	}
+
+	const auto& population = *sim->GetPopulation();
+	EXPECT_EQ(population.size() * sizeof(PersonData), subsystems["person data"].used);
+	EXPECT_GT(subsystems["person map nodes"].allocated, population.size() * sizeof(PersonId));
+	EXPECT_GT(subsystems["atlas"].used, 0U);
+
+	// Every person is a member of a household.
+	std::size_t members = 0U;
+	const auto& clusters = sim->GetClusters();
+	for (const auto cluster_vector :
+	     {&clusters.m_households, &clusters.m_school_clusters, &clusters.m_work_clusters,
+	      &clusters.m_primary_community, &clusters.m_secondary_community}) {
+		for (const auto& cluster : *cluster_vector) {
+			members += cluster.GetSize();
+		}
+	}
+	EXPECT_GE(members, population.size());
+	EXPECT_EQ(members * Cluster::GetMemberSize(), subsystems["cluster members"].used);
+	EXPECT_EQ(0U, subsystems["visitor journal"].used);
+
+	// The subsystems that grow are part of the full account.
+	MemoryAccount growing;
+	sim->AccountGrowingMemory(growing);
+	EXPECT_FALSE(growing.GetSubsystems().empty());
+	for (const auto& entry : growing.GetSubsystems()) {
+		ASSERT_EQ(1U, subsystems.count(entry.first)) << entry.first;
+		EXPECT_EQ(subsystems[entry.first].allocated, entry.second.allocated) << entry.first;
+	}
+	EXPECT_LT(growing.GetTotal().allocated, account.GetTotal().allocated);
+}
+
+TEST(MemoryAccount, FailsOverBudget)
+{
+	// The population takes more than 1 MiB, so the builder fails before it allocates the cluster members.
+	try {
+		BuildSimulator(1U);
+		FAIL() << "the budget wasn't checked";
+	} catch (const std::runtime_error& error) {
+		EXPECT_NE(std::string::npos, std::string(error.what()).find("before the cluster members"));
+	}
+	EXPECT_NO_THROW(BuildSimulator(4096U));
+}
+
+TEST(MemoryAccount, FailsOverBudgetInManager)
+{
+	boost::property_tree::ptree pt_config;
+	InstallDirs::ReadXmlFile("config/run_commuting_test.xml", InstallDirs::GetRootDir(), pt_config);
+	MultiSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.common_config->generate_vis_file = false;
+	auto log = std::make_shared<spdlog::logger>("budget_test", std::make_shared<spdlog::sinks::null_sink_st>());
+	multiregion::ParallelSimulationManager<OverBudget, multiregion::RegionId> manager{2, 1};
+	for (const auto& single_config : config.GetSingleConfigs()) {
+		manager.CreateSimulation(single_config, log, single_config.GetId());
+	}
+
+	// The steps run on the manager's threads. The region that exchanges commuters with the failed one stops as
+	// well, and the failure reaches this thread.
+	EXPECT_THROW(manager.WaitAll(), std::runtime_error);
+}
+
+} // Tests
@@ -0,0 +1,377 @@
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/property_tree/ptree.hpp>
+#include <gtest/gtest.h>
+#include <spdlog/sinks/ostream_sink.h>
+#include <spdlog/spdlog.h>
+#include "output/ContactLog.h"
+#include "output/ContactMatrices.h"
+#include "output/PersonFile.h"
+#include "output/TimeSeriesFile.h"
+#include "sim/SimulationConfig.h"
+#include "sim/Simulator.h"
+#include "sim/SimulatorBuilder.h"
+#include "util/InstallDirs.h"
+#include "util/PerfCounters.h"
+
+namespace Tests {
+
+using namespace stride;
+using namespace stride::output;
+using namespace stride::util;
+using boost::property_tree::ptree;
+
+/// Runs a simulation with the given log level for some days, and returns the contact log as text. With
+/// `aggregate`, the per day contact matrices are returned instead of the contacts.
+std::string RunContactLog(const std::string& log_level, unsigned int days, bool binary, bool aggregate = false)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile("../config/run_test_popgen.xml", InstallDirs::GetCurrentDir(), pt_config);
+	SingleSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.log_config->log_level = ToLogMode(log_level);
+	config.log_config->output_prefix = "test_contactlog";
+	config.log_config->binary_contact_log = binary;
+	config.log_config->aggregate_contacts = aggregate;
+	config.log_config->contact_matrix_per_day = true;
+
+	std::ostringstream text;
+	auto log = std::make_shared<spdlog::logger>(
+	    "test_contactlog", std::make_shared<spdlog::sinks::ostream_sink_st>(text));
+	log->set_pattern("%v");
+	auto sim = SimulatorBuilder::Build(config, log, 1);
+	for (unsigned int i = 0; i < days; i++) {
+		(void)sim->TimeStep({{}, {}});
+	}
+	// Destroying the simulator writes the rest of the binary log.
+	sim.reset();
+
+	// The participants of the survey are always logged as text.
+	std::ostringstream result;
+	std::istringstream lines(text.str());
+	for (std::string line; std::getline(lines, line);) {
+		if (line.compare(0, 6, "[PART]") != 0) {
+			result << line << '\n';
+		}
+	}
+	if (binary) {
+		const auto file = "test_contactlog_sim" + std::to_string(config.GetId()) + "_contacts.bin";
+		std::ifstream in(file, std::ios::binary);
+		ContactLog::Decode(in, result);
+		in.close();
+		std::remove(file.c_str());
+	}
+	if (aggregate) {
+		const auto file = "test_contactlog_sim" + std::to_string(config.GetId()) + "_contact_matrix.csv";
+		std::ifstream in(file);
+		result << in.rdbuf();
+		in.close();
+		std::remove(file.c_str());
+	}
+	return result.str();
+}
+
+TEST(OutputFiles, TimeSeriesRecords)
+{
+	auto log = spdlog::stderr_logger_st("test_timeseries");
+	log->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build("../config/run_test_popgen.xml", log, 2, false);
+	const auto population = sim->GetPopulation();
+	const auto& atlas = population->get_atlas();
+
+	std::size_t record_size = 0;
+	{
+		TimeSeriesFile file("test_timeseries", &atlas);
+		for (unsigned int day = 0; day < 5; day++) {
+			(void)sim->TimeStep({{}, {}});
+			const auto record = TimeSeriesRecord::Count(*sim, 0, day);
+
+			unsigned int persons = 0;
+			for (auto count : record.status) {
+				persons += count;
+			}
+			unsigned int infected_by_age = 0;
+			for (auto count : record.infected_by_age) {
+				infected_by_age += count;
+			}
+			unsigned int infected_by_town = 0;
+			for (auto count : record.infected_by_town) {
+				infected_by_town += count;
+			}
+			EXPECT_EQ(population->size(), persons);
+			EXPECT_EQ(population->get_infected_count(), record.GetCases());
+			EXPECT_EQ(infected_by_age, infected_by_town);
+			file.Print(record);
+		}
+		record_size = (2 + TimeSeriesRecord::NumOfStatuses + TimeSeriesRecord::NumOfAgeGroups +
+			       atlas.GetTowns().size()) *
+			      sizeof(uint32_t);
+	}
+
+	// Every record has the same size, after the header.
+	std::ifstream in("test_timeseries_timeseries.bin", std::ios::binary | std::ios::ate);
+	const std::size_t file_size = in.tellg();
+	std::size_t header_size = 8 + 5 * sizeof(uint32_t);
+	for (const auto& town : atlas.getTownMap()) {
+		header_size += 2 * sizeof(uint32_t) + 2 * sizeof(double) + town.second.name.size();
+	}
+	EXPECT_EQ(header_size + 5 * record_size, file_size);
+	in.close();
+	std::remove("test_timeseries_timeseries.bin");
+
+	spdlog::drop("test_timeseries");
+}
+
+TEST(OutputFiles, BinaryContactLogDecodesToText)
+{
+	const auto transmissions = RunContactLog("Transmissions", 10, false);
+	EXPECT_FALSE(transmissions.empty());
+	EXPECT_EQ(transmissions, RunContactLog("Transmissions", 10, true));
+
+	const auto contacts = RunContactLog("Contacts", 2, false);
+	EXPECT_FALSE(contacts.empty());
+	EXPECT_EQ(contacts, RunContactLog("Contacts", 2, true));
+}
+
+TEST(OutputFiles, ContactLogBuffersWrapAround)
+{
+	const unsigned int num_threads = 3;
+	const unsigned int num_records = 1000;
+	{
+		// Tiny buffers, so that the threads have to wait for the writer.
+		ContactLog log("test_contactlog_wrap.bin", num_threads, 8);
+		std::vector<std::thread> threads;
+		for (unsigned int t = 0; t < num_threads; t++) {
+			threads.emplace_back([&log, t] {
+				for (unsigned int i = 0; i < num_records; i++) {
+					log.GetBuffer(t).Push({ContactRecord::Transmission, 0U, 0U, i, t, i, 0.0, 0.0});
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	// Every thread's records are in the file, in the order they were pushed.
+	std::ifstream in("test_contactlog_wrap.bin", std::ios::binary);
+	std::ostringstream text;
+	ContactLog::Decode(in, text);
+	in.close();
+	std::remove("test_contactlog_wrap.bin");
+
+	std::vector<unsigned int> next(num_threads, 0U);
+	std::istringstream lines(text.str());
+	std::string tag, cluster;
+	unsigned int thread, record, day;
+	unsigned int count = 0;
+	while (lines >> tag >> thread >> record >> cluster >> day) {
+		ASSERT_LT(thread, num_threads);
+		EXPECT_EQ(next[thread], record);
+		next[thread]++;
+		count++;
+	}
+	EXPECT_EQ(num_threads * num_records, count);
+}
+
+TEST(OutputFiles, ContactMatricesMatchContactLog)
+{
+	// Count the logged contacts by day, cluster type, participant age and contact age.
+	std::map<std::string, unsigned long> logged;
+	std::istringstream log_lines(RunContactLog("Contacts", 2, false));
+	for (std::string line; std::getline(log_lines, line);) {
+		std::istringstream fields(line);
+		std::string tag;
+		unsigned int id, day;
+		double age1, age2;
+		bool at[5];
+		fields >> tag >> id >> age1 >> age2 >> at[0] >> at[1] >> at[2] >> at[3] >> at[4] >> day;
+		ASSERT_EQ("[CONT]", tag);
+		for (unsigned int type = 0; type < 5; type++) {
+			if (at[type]) {
+				const auto part_age = std::min(static_cast<unsigned int>(age1), ContactMatrices::MaxAge);
+				const auto cnt_age = std::min(static_cast<unsigned int>(age2), ContactMatrices::MaxAge);
+				logged[std::to_string(day) + ";" + ToString(static_cast<ClusterType>(type)) + ";" + std::to_string(part_age) +
+				       ";" + std::to_string(cnt_age)]++;
+			}
+		}
+	}
+	EXPECT_FALSE(logged.empty());
+
+	// The matrices count the same contacts, and nothing is logged one by one.
+	std::map<std::string, unsigned long> counted;
+	std::istringstream matrix_lines(RunContactLog("Contacts", 2, false, true));
+	std::string line;
+	std::getline(matrix_lines, line);
+	EXPECT_EQ(0U, line.find("day;cluster_type;part_age;participants;age0;"));
+	while (std::getline(matrix_lines, line)) {
+		std::istringstream fields(line);
+		std::string day, cluster_type, part_age, participants, count;
+		std::getline(fields, day, ';');
+		std::getline(fields, cluster_type, ';');
+		std::getline(fields, part_age, ';');
+		std::getline(fields, participants, ';');
+		EXPECT_GT(std::stoul(participants), 0UL);
+		for (unsigned int cnt_age = 0; std::getline(fields, count, ';'); cnt_age++) {
+			if (std::stoul(count) > 0) {
+				counted[day + ";" + cluster_type + ";" + part_age + ";" + std::to_string(cnt_age)] =
+				    std::stoul(count);
+			}
+		}
+	}
+	EXPECT_EQ(logged, counted);
+}
+
+TEST(OutputFiles, ContactMatricesSampleRate)
+{
+	const double sample_rate = 0.1;
+	const unsigned int num_ids = 100000;
+	unsigned int sampled = 0;
+	for (unsigned int id = 0; id < num_ids; id++) {
+		sampled += ContactMatrices::IsSampled(id, sample_rate);
+	}
+	EXPECT_NEAR(sample_rate, static_cast<double>(sampled) / num_ids, 0.01);
+
+	EXPECT_FALSE(ContactMatrices::IsSampled(0, 0.0));
+	EXPECT_TRUE(ContactMatrices::IsSampled(0, 1.0));
+	EXPECT_THROW(ContactMatrices("test_contact_matrix.csv", 1, true, 1.5), std::runtime_error);
+	std::remove("test_contact_matrix.csv");
+}
+
+/// Reads a whole file.
+std::string ReadFile(const std::string& file)
+{
+	std::ifstream in(file, std::ios::binary);
+	std::ostringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+TEST(OutputFiles, PersonFileIsOrderedAndComplete)
+{
+	auto log = spdlog::stderr_logger_st("test_personfile");
+	log->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build("../config/run_test_popgen.xml", log, 2, false);
+	for (unsigned int day = 0; day < 10; day++) {
+		(void)sim->TimeStep({{}, {}});
+	}
+	const auto population = sim->GetPopulation();
+
+	// The persons as the file used to be written, one by one.
+	std::ostringstream expected;
+	std::vector<std::vector<std::uint32_t>> expected_columns(PersonFile::NumOfColumns);
+	expected << "id,is_recovered,is_immune,start_infectiousness;end_infectiousness,start_symptomatic,end_symptomatic\n";
+	population->serial_for([&expected, &expected_columns](const Person& p, unsigned int) {
+		const auto& h = p.GetHealth();
+		if (!h.IsSusceptible()) {
+			const std::uint32_t values[] = {p.GetOriginalId(),
+							h.IsRecovered(),
+							h.IsImmune(),
+							h.GetStartInfectiousness(),
+							h.GetEndInfectiousness(),
+							h.GetStartSymptomatic(),
+							h.GetEndSymptomatic()};
+			for (std::size_t column = 0; column < PersonFile::NumOfColumns; column++) {
+				expected << values[column] << (column + 1 < PersonFile::NumOfColumns ? ',' : '\n');
+				expected_columns[column].push_back(values[column]);
+			}
+		}
+	});
+	ASSERT_FALSE(expected_columns[0].empty());
+
+	for (unsigned int num_threads : {1U, 4U}) {
+		PersonFile("test_personfile").Print(population, num_threads);
+		EXPECT_EQ(expected.str(), ReadFile("test_personfile_person.csv"));
+		std::remove("test_personfile_person.csv");
+
+		PersonFile("test_personfile", true).Print(population, num_threads);
+		std::ifstream in("test_personfile_person.bin", std::ios::binary);
+		char magic[8];
+		std::uint32_t header[2];
+		std::uint64_t num_rows;
+		in.read(magic, sizeof(magic));
+		in.read(reinterpret_cast<char*>(header), sizeof(header));
+		in.read(reinterpret_cast<char*>(&num_rows), sizeof(num_rows));
+		EXPECT_EQ("STRIDEPF", std::string(magic, sizeof(magic)));
+		EXPECT_EQ(PersonFile::Version, header[0]);
+		ASSERT_EQ(PersonFile::NumOfColumns, header[1]);
+		ASSERT_EQ(expected_columns[0].size(), num_rows);
+		for (const auto& name : PersonFile::GetColumnNames()) {
+			std::uint32_t length;
+			in.read(reinterpret_cast<char*>(&length), sizeof(length));
+			std::string read_name(length, ' ');
+			in.read(&read_name[0], length);
+			EXPECT_EQ(name, read_name);
+		}
+		for (const auto& expected_column : expected_columns) {
+			std::vector<std::uint32_t> column(num_rows);
+			in.read(reinterpret_cast<char*>(column.data()), num_rows * sizeof(std::uint32_t));
+			EXPECT_EQ(expected_column, column);
+		}
+		EXPECT_TRUE(in.good());
+		EXPECT_EQ(std::char_traits<char>::eof(), in.peek());
+		in.close();
+		std::remove("test_personfile_person.bin");
+	}
+
+	spdlog::drop("test_personfile");
+}
+
+TEST(OutputFiles, PerfCountersPerPhase)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile("../config/run_test_popgen.xml", InstallDirs::GetCurrentDir(), pt_config);
+	SingleSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	config.log_config->output_prefix = "test_counters";
+	config.log_config->perf_counters = true;
+	auto log = spdlog::stderr_logger_st("test_counters");
+	log->set_level(spdlog::level::off);
+	auto sim = SimulatorBuilder::Build(config, log, 2);
+	for (unsigned int day = 0; day < 3; day++) {
+		(void)sim->TimeStep({{}, {}});
+	}
+	// Destroying the simulator writes the counters.
+	sim.reset();
+
+	// The events that are counted depend on the machine; the others are "NA".
+	const PerfCounters counters;
+	const auto file = "test_counters_sim" + std::to_string(config.GetId()) + "_counters.csv";
+	std::istringstream lines(ReadFile(file));
+	std::string line;
+	std::getline(lines, line);
+	EXPECT_EQ("phase,runs,seconds,cycles,instructions,llc_misses,branch_misses,dtlb_misses", line);
+	std::vector<std::string> phases;
+	while (std::getline(lines, line)) {
+		std::vector<std::string> fields;
+		std::istringstream values(line);
+		for (std::string field; std::getline(values, field, ',');) {
+			fields.push_back(field);
+		}
+		ASSERT_EQ(3U + PerfCounters::NumOfEvents, fields.size()) << line;
+		phases.push_back(fields[0]);
+		EXPECT_EQ("3", fields[1]);
+		EXPECT_GE(std::stod(fields[2]), 0.0);
+		for (std::size_t event = 0; event < PerfCounters::NumOfEvents; event++) {
+			if (counters.IsAvailable(event)) {
+				EXPECT_GE(std::stod(fields[3 + event]), 0.0);
+			} else {
+				EXPECT_EQ("NA", fields[3 + event]);
+			}
+		}
+	}
+	const std::vector<std::string> expected_phases{"AcceptVisitors",   "UpdatePopulation", "Households",
+						       "Schools",	  "Work",	     "PrimaryCommunity",
+						       "SecondaryCommunity", "ReturnVisitors"};
+	EXPECT_EQ(expected_phases, phases);
+	std::remove(file.c_str());
+	spdlog::drop("test_counters");
+}
+
+} // Tests
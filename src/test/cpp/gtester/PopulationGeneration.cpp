@@ -1,4 +1,6 @@
 #include <iostream>
+#include <map>
+#include <set>
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/exceptions.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -9,6 +11,7 @@
 #include "core/LogMode.h"
 #include "multiregion/TravelModel.h"
 #include "pop/Generator.h"
+#include "util/Parallel.h"
 #include "sim/SimulatorBuilder.h"
 #include "util/InstallDirs.h"
 
@@ -35,6 +38,60 @@ TEST(PopulationGeneration, GeneratedPopulationFitsModel)
 	ASSERT_TRUE(generator->FitsModel(population));
 }
 
+TEST(PopulationGeneration, GenerationIsIndependentOfThreadCount)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile("../config/run_test_popgen.xml", InstallDirs::GetCurrentDir(), pt_config);
+	stride::SingleSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	ptree pt_disease;
+	InstallDirs::ReadXmlFile(config.common_config->disease_config_file_name, InstallDirs::GetDataDir(), pt_disease);
+	const auto disease = disease::Disease::Parse(pt_disease);
+
+	const auto generate = [&](unsigned int num_threads) {
+		parallel::try_set_number_of_threads(num_threads);
+		stride::util::Random rng(1);
+		return population::Generator::FromConfig(config, *disease, rng)->Generate();
+	};
+	const unsigned int original_threads = parallel::get_number_of_threads();
+	const auto serial = generate(1);
+	const auto threaded = generate(4);
+	parallel::try_set_number_of_threads(original_threads);
+
+	ASSERT_EQ(serial.size(), threaded.size());
+	for (auto a = serial.begin(), b = threaded.begin(); a != serial.end(); ++a, ++b) {
+		const Person p = *a, q = *b;
+		ASSERT_EQ(p.GetId(), q.GetId());
+		EXPECT_EQ(p.GetAge(), q.GetAge());
+		for (auto type : {ClusterType::Household, ClusterType::School, ClusterType::Work,
+				  ClusterType::PrimaryCommunity, ClusterType::SecondaryCommunity})
+			EXPECT_EQ(p.GetClusterId(type), q.GetClusterId(type));
+		EXPECT_EQ(p.GetHealth().GetStartInfectiousness(), q.GetHealth().GetStartInfectiousness());
+	}
+}
+
+TEST(PopulationGeneration, EveryPersonHasAHometown)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile("../config/run_test_popgen.xml", InstallDirs::GetCurrentDir(), pt_config);
+	stride::SingleSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	ptree pt_disease;
+	InstallDirs::ReadXmlFile(config.common_config->disease_config_file_name, InstallDirs::GetDataDir(), pt_disease);
+	const auto disease = disease::Disease::Parse(pt_disease);
+	stride::util::Random rng(1);
+
+	const auto population = population::Generator::FromConfig(config, *disease, rng)->Generate();
+	const auto& atlas = population.get_atlas();
+	for (const auto& p : population) {
+		const Atlas::ClusterKey household{p.GetClusterId(ClusterType::Household), ClusterType::Household};
+		const auto& position = atlas.LookupPosition(household);
+		const auto town = atlas.getTownMap().find(position);
+		ASSERT_NE(town, atlas.getTownMap().end());
+		EXPECT_EQ(town->second.id, population.get_hometown(p).id);
+	}
+}
+
 TEST(PopulationGeneration, GeneratedPopulationIsInfectious)
 {
 	auto log = spdlog::stderr_logger_st("test_popgen");
@@ -51,4 +108,116 @@ TEST(PopulationGeneration, GeneratedPopulationIsInfectious)
 	spdlog::drop("test_popgen");
 }
 
+TEST(PopulationGeneration, TownInfectionsMatchPopulation)
+{
+	auto log = spdlog::stderr_logger_st("test_popgen_towns");
+	log->set_level(spdlog::level::off);
+	auto sim = stride::SimulatorBuilder::Build("../config/run_test_popgen.xml", log, 2, false);
+	const auto population = sim->GetPopulation();
+	const auto& atlas = population->get_atlas();
+
+	// After every step, the incremental counts should match a count of the whole population.
+	for (int i = 0; i < 10; i++) {
+		std::vector<unsigned int> expected(atlas.GetTowns().size(), 0U);
+		for (const auto& p : *population) {
+			const auto town =
+			    atlas.FindTownIndex({p.GetClusterId(ClusterType::Household), ClusterType::Household});
+			ASSERT_NE(Atlas::no_town, town);
+			if (p.GetHealth().IsInfected()) {
+				expected[town]++;
+			}
+		}
+		ASSERT_EQ(expected, sim->GetTownInfections()) << "on day " << i;
+		(void)sim->TimeStep({{}, {}});
+	}
+
+	spdlog::drop("test_popgen_towns");
+}
+
+TEST(PopulationGeneration, ClustersHoldTheirMembersInOrder)
+{
+	auto log = spdlog::stderr_logger_st("test_popgen_clusters");
+	log->set_level(spdlog::level::off);
+	auto sim = stride::SimulatorBuilder::Build("../config/run_test_popgen.xml", log, 4, false);
+	const auto population = sim->GetPopulation();
+	const auto& clusters = sim->GetClusters();
+	const std::vector<Cluster>* cluster_vectors[] = {&clusters.m_households, &clusters.m_school_clusters,
+							&clusters.m_work_clusters, &clusters.m_primary_community,
+							&clusters.m_secondary_community};
+
+	for (std::size_t t = 0; t < NumOfClusterTypes(); t++) {
+		// Every cluster should hold its non-immune members by id, followed by its immune members by id.
+		const auto type = static_cast<ClusterType>(t);
+		std::vector<std::vector<PersonId>> expected(cluster_vectors[t]->size());
+		std::vector<std::vector<PersonId>> expected_immune(cluster_vectors[t]->size());
+		for (const auto& p : *population) {
+			const auto id = p.GetClusterId(type);
+			if (id > 0) {
+				ASSERT_LT(id, expected.size());
+				(p.GetHealth().IsImmune() ? expected_immune : expected)[id].push_back(p.GetId());
+			}
+		}
+		for (std::size_t i = 0; i < expected.size(); i++) {
+			expected[i].insert(expected[i].end(), expected_immune[i].begin(), expected_immune[i].end());
+			std::vector<PersonId> members;
+			for (const auto& p : (*cluster_vectors[t])[i].GetPeople()) {
+				members.push_back(p.GetId());
+			}
+			ASSERT_EQ(expected[i], members) << ToString(type) << " " << i;
+			EXPECT_EQ(type, (*cluster_vectors[t])[i].GetClusterType());
+		}
+	}
+
+	spdlog::drop("test_popgen_clusters");
+}
+
+TEST(PopulationGeneration, RenumberingKeepsHouseholdsTogether)
+{
+	ptree pt_config;
+	InstallDirs::ReadXmlFile("../config/run_test_popgen.xml", InstallDirs::GetCurrentDir(), pt_config);
+	stride::SingleSimulationConfig config;
+	config.Parse(pt_config.get_child("run"));
+	ptree pt_disease;
+	InstallDirs::ReadXmlFile(config.common_config->disease_config_file_name, InstallDirs::GetDataDir(), pt_disease);
+	const auto disease = disease::Disease::Parse(pt_disease);
+
+	const auto generate = [&]() {
+		stride::util::Random rng(1);
+		return population::Generator::FromConfig(config, *disease, rng)->Generate();
+	};
+	const auto original = generate();
+	auto renumbered = generate();
+	renumbered.renumber_by_household();
+
+	std::map<PersonId, Person> by_original_id;
+	for (const auto& p : original) {
+		by_original_id.emplace(p.GetId(), p);
+	}
+	ASSERT_EQ(original.size(), renumbered.size());
+	PersonId expected_id = 0U;
+	std::set<unsigned int> finished_households;
+	unsigned int household = 0U;
+	for (const auto& p : renumbered) {
+		// The ids are consecutive, and every person is still there, with their data and original id.
+		ASSERT_EQ(expected_id, p.GetId());
+		expected_id++;
+		const auto it = by_original_id.find(p.GetOriginalId());
+		ASSERT_NE(by_original_id.end(), it);
+		const Person q = it->second;
+		by_original_id.erase(it);
+		EXPECT_EQ(q.GetAge(), p.GetAge());
+		for (auto type : {ClusterType::Household, ClusterType::School, ClusterType::Work,
+				  ClusterType::PrimaryCommunity, ClusterType::SecondaryCommunity})
+			EXPECT_EQ(q.GetClusterId(type), p.GetClusterId(type));
+
+		// The members of a household are next to each other.
+		if (p.GetClusterId(ClusterType::Household) != household) {
+			finished_households.insert(household);
+			household = p.GetClusterId(ClusterType::Household);
+			EXPECT_EQ(0U, finished_households.count(household)) << "household " << household;
+		}
+	}
+	EXPECT_TRUE(by_original_id.empty());
+}
+
 } // Tests
@@ -1,5 +1,7 @@
 #include <iostream>
+#include <sstream>
 #include <gtest/gtest.h>
+#include "sim/run_bench.h"
 #include "sim/run_stride.h"
 
 namespace Tests {
@@ -10,4 +12,40 @@ TEST(RunSimulator, RunSimulatorMultiregion) { stride::run_stride(false, "../conf
 
 TEST(RunSimulator, RunSimulatorTravel) { stride::run_stride(false, "../config/run_travel_test.xml", "", ""); }
 
+TEST(RunSimulator, ScalingBench)
+{
+	stride::ScalingBenchConfig config;
+	config.config_file_name = "../config/run_popgen_small.xml";
+	config.population_model = "population_model_test.xml";
+	config.num_persons = 4000U;
+	config.num_days = 2U;
+	config.max_threads = 2U;
+	config.max_regions = 2U;
+	std::ostringstream table;
+	const auto strong = stride::run_scaling_bench(config, table);
+
+	// One and two regions, with one and two threads; the regions share the persons.
+	ASSERT_EQ(4U, strong.size());
+	EXPECT_EQ(1U, strong[0].regions);
+	EXPECT_EQ(1U, strong[0].threads);
+	EXPECT_EQ(2U, strong[1].threads);
+	EXPECT_EQ(2U, strong[3].regions);
+	EXPECT_DOUBLE_EQ(1.0, strong[0].efficiency);
+	for (const auto& result : strong) {
+		EXPECT_NEAR(4000.0, result.persons, 400.0);
+		EXPECT_GT(result.person_days_per_second, 0.0);
+		EXPECT_GT(result.efficiency, 0.0);
+	}
+	EXPECT_NE(std::string::npos, table.str().find("person-days/s"));
+	EXPECT_NE(std::string::npos, table.str().find("run ms"));
+	EXPECT_EQ(std::string::npos, table.str().find(" 0.0 "));
+
+	// With weak scaling, every thread gets the persons.
+	config.max_regions = 1U;
+	config.weak_scaling = true;
+	const auto weak = stride::run_scaling_bench(config, table);
+	ASSERT_EQ(2U, weak.size());
+	EXPECT_NEAR(2.0 * weak[0].persons, weak[1].persons, 800.0);
+}
+
 } // Tests
@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <gtest/gtest.h>
+#include "util/Trace.h"
+
+namespace Tests {
+
+using namespace stride::util;
+using boost::property_tree::ptree;
+
+TEST(Trace, WritesChromeTrace)
+{
+	const std::string file_name = "test_trace.json";
+
+	// Spans that are recorded while tracing is off aren't written.
+	{
+		TraceSpan span("Off", "test");
+	}
+	Tracer::Start(file_name);
+	ASSERT_TRUE(Tracer::IsEnabled());
+	{
+		TraceSpan span("Outer", "test", 2);
+		TraceSpan inner("Inner", "test", 2);
+	}
+	std::vector<int> values(1000, 0);
+	Tracer::ParallelFor("Loop", 3, values, 4, [](int& value, unsigned int) { value++; });
+	Tracer::Stop();
+	EXPECT_FALSE(Tracer::IsEnabled());
+	for (int value : values) {
+		ASSERT_EQ(1, value);
+	}
+
+	ptree trace;
+	boost::property_tree::read_json(file_name, trace);
+	std::map<std::string, unsigned int> spans;
+	std::map<std::string, int> processes;
+	std::map<int, std::string> process_names;
+	for (const auto& event : trace.get_child("traceEvents")) {
+		const auto phase = event.second.get<std::string>("ph");
+		if (phase == "X") {
+			const auto name = event.second.get<std::string>("name");
+			spans[name]++;
+			processes[name] = event.second.get<int>("pid");
+			EXPECT_GE(event.second.get<double>("dur"), 0.0);
+		} else if (phase == "M" && event.second.get<std::string>("name") == "process_name") {
+			process_names[event.second.get<int>("pid")] = event.second.get<std::string>("args.name");
+		}
+	}
+	EXPECT_EQ(0U, spans.count("Off"));
+	EXPECT_EQ(1U, spans["Outer"]);
+	EXPECT_EQ(1U, spans["Inner"]);
+	// The loop itself, and at least one thread.
+	EXPECT_GE(spans["Loop"], 2U);
+	EXPECT_EQ("region 2", process_names[processes["Outer"]]);
+	EXPECT_EQ("region 3", process_names[processes["Loop"]]);
+	EXPECT_EQ("stride", process_names[0]);
+	std::remove(file_name.c_str());
+}
+
+TEST(Trace, KeepsSpansOfExitedThreads)
+{
+	const std::string file_name = "test_trace_session.json";
+
+	// The session writes the trace when the run fails, with the spans of a thread that has exited.
+	try {
+		TraceSession session(file_name);
+		std::thread worker([]() { TraceSpan span("Worker", "test"); });
+		worker.join();
+		throw std::runtime_error("failed run");
+	} catch (const std::runtime_error&) {
+	}
+	EXPECT_FALSE(Tracer::IsEnabled());
+
+	ptree trace;
+	boost::property_tree::read_json(file_name, trace);
+	unsigned int worker_spans = 0;
+	for (const auto& event : trace.get_child("traceEvents")) {
+		if (event.second.get<std::string>("ph") == "X" && event.second.get<std::string>("name") == "Worker") {
+			worker_spans++;
+		}
+	}
+	EXPECT_EQ(1U, worker_spans);
+	std::remove(file_name.c_str());
+}
+
+} // Tests